@@ -19,55 +19,249 @@
  */
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "avl-tree.h"
+#include "avlmap.h"
+#include "intervaltree.h"
+#include "mempool.h"
 #define max(a, b) ((a) > (b) ? (a) : (b))
 
+/*
+ * An avl-tree of height h holds at least F(h + 2) - 1 nodes,
+ * where F is Fibonacci sequence. F(94) exceeds 2^64, so no
+ * path from root to leaf is longer than this.
+ */
+#define MAX_HEIGHT 92
+
 struct entry {
     avltreeElem x;          /* data */
     int height;             /* height of sub-avltree */
+    int refs;               /* trees and nodes pointing to the node */
+    size_t size;            /* nodes in sub-avltree */
     struct entry *left;     /* left child of the node */
     struct entry *right;    /* right child of the node */
+    void *v;                /* value, allocated in avlmap only */
+};
+
+/*
+ * Nodes of an interval tree hold [x, v], and the largest v
+ * in their subtree.
+ */
+struct span_entry {
+    struct entry e;
+    void *max;
 };
 
 struct _avltree {
     struct entry *root;
+    mempool_t pool;         /* nodes of the tree */
     comparator cmp;
+    int map;                /* non-zero if nodes carry a value */
+    int span;               /* non-zero if nodes are span_entry */
+    int *cow;               /* count of trees sharing nodes, or NULL */
 };
 
-int avltree_new(avltree_t *avl, const comparator cmp)
+struct _avltree_cursor {
+    avltree_t avl;
+    int depth;              /* 0 if cursor points to nothing */
+    struct entry *path[MAX_HEIGHT];     /* root to current node */
+};
+
+/*
+ * tree_new - Create a new avl-tree, avlmap or interval tree
+ *
+ * Nodes of a plain avl-tree stop right before the value.
+ */
+static int tree_new(avltree_t *avl, const comparator cmp, const int map,
+        const int span)
 {
     avltree_t new_avl;
+    size_t size;
+
+    if (span) {
+        size = sizeof(struct span_entry);
+    } else {
+        size = map ? sizeof(struct entry) : offsetof(struct entry, v);
+    }
 
     new_avl = (avltree_t) malloc(sizeof(*new_avl));
     if (new_avl == NULL) {
         return -1;
 
+    } else if (mempool_new(&new_avl->pool, size) == -1) {
+        free(new_avl);
+        return -1;
+
     } else {
         new_avl->root = NULL;
         new_avl->cmp  = (cmp != NULL) ? cmp : cmp_int;
+        new_avl->map  = map;
+        new_avl->span = span;
+        new_avl->cow  = NULL;
         *avl = new_avl;
         return 0;
     }
 }
 
+int avltree_new(avltree_t *avl, const comparator cmp)
+{
+    return tree_new(avl, cmp, 0, 0);
+}
+
+int avltree_from_sorted(avltree_t *avl, avltreeElem const elems[],
+        const size_t n, const comparator cmp)
+{
+    struct entry *e;
+    char *nodes;
+    size_t *lo;
+    size_t i, head, tail, half, size;
+
+    if (tree_new(avl, cmp, 0, 0) == -1) {
+        return -1;
+    }
+
+    for (i = 1; i < n; ++i) {
+        if ((*avl)->cmp(elems[i - 1], elems[i]) >= 0) {
+            avltree_free(avl);
+            return -1;
+        }
+    }
+
+    if (n == 0) {
+        return 0;
+    }
+
+    /* Nodes of a set stop before the value, step by their real size. */
+    size = offsetof(struct entry, v);
+    nodes = (char *) mempool_alloc_block((*avl)->pool, n);
+    lo = (size_t *) malloc(n * sizeof(size_t));
+    if (nodes == NULL || lo == NULL) {
+        free(lo);
+        avltree_free(avl);
+        return -1;
+    }
+
+    /*
+     * Node k covers elems[lo[k], lo[k] + size) and takes the middle
+     * one. Children are appended as they are found, which is
+     * breadth-first order. Sibling sizes differ by one at most,
+     * so a subtree of size s has height of bit length of s.
+     */
+    lo[0] = 0;
+    ((struct entry *) nodes)->size = n;
+    tail = 1;
+    for (head = 0; head < n; ++head) {
+        e = (struct entry *) (nodes + head * size);
+        half = e->size / 2;
+        e->x = elems[lo[head] + half];
+        e->height = (int) (8 * sizeof(long) - __builtin_clzl(e->size));
+        e->refs = 1;
+        e->left = NULL;
+        e->right = NULL;
+
+        if (half > 0) {
+            e->left = (struct entry *) (nodes + tail * size);
+            e->left->size = half;
+            lo[tail++] = lo[head];
+        }
+        if (e->size - half - 1 > 0) {
+            e->right = (struct entry *) (nodes + tail * size);
+            e->right->size = e->size - half - 1;
+            lo[tail++] = lo[head] + half + 1;
+        }
+    }
+
+    (*avl)->root = (struct entry *) nodes;
+    free(lo);
+    return 0;
+}
+
 /*
- * subtree_free - Destroy a subtree
+ * unref - Drop a reference to a node
+ *
+ * A node nobody points to any more goes back to the pool,
+ * along with its references to its children.
  */
-static void subtree_free(struct entry *root)
+static void unref(avltree_t avl, struct entry *e)
 {
-    if (!root) {
-        return;
+    if (e != NULL && __atomic_sub_fetch(&e->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        unref(avl, e->left);
+        unref(avl, e->right);
+        mempool_release(avl->pool, e);
     }
-    
-    subtree_free(root->left);
-    subtree_free(root->right);
-    free(root);
-    root = NULL;
+}
+
+/*
+ * unshare - Make sure a node belongs to this tree only
+ *
+ * @avl: the avl-tree
+ * @link: link to the node
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * A shared node is replaced by a private copy, which points to
+ * the same children. Nodes are never changed while shared, so
+ * other trees keep seeing them as they were.
+ */
+static int unshare(avltree_t avl, struct entry **link)
+{
+    struct entry *e, *copy;
+
+    e = *link;
+    if (__atomic_load_n(&e->refs, __ATOMIC_ACQUIRE) == 1) {
+        return 0;
+    }
+
+    copy = (struct entry *) mempool_alloc(avl->pool);
+    if (copy == NULL) {
+        return -1;
+    }
+
+    memcpy(copy, e, avl->map ? sizeof(struct entry) : offsetof(struct entry, v));
+    copy->refs = 1;
+    if (copy->left != NULL) {
+        __atomic_add_fetch(&copy->left->refs, 1, __ATOMIC_RELAXED);
+    }
+    if (copy->right != NULL) {
+        __atomic_add_fetch(&copy->right->refs, 1, __ATOMIC_RELAXED);
+    }
+    unref(avl, e);
+    *link = copy;
+    return 0;
+}
+
+/*
+ * shares_nodes - Check if nodes of avl may be shared
+ *
+ * Once every other tree of its snapshots is freed, each node
+ * has a single reference again, and copy on write is over.
+ */
+static int shares_nodes(avltree_t avl)
+{
+    if (avl->cow != NULL && __atomic_load_n(avl->cow, __ATOMIC_ACQUIRE) == 1) {
+        free(avl->cow);
+        avl->cow = NULL;
+    }
+    return avl->cow != NULL;
 }
 
 void avltree_free(avltree_t *avl)
 {
-    subtree_free((*avl)->root);
+    /*
+     * Nodes go away with their chunks, no need to walk the tree,
+     * unless other trees share them.
+     */
+    if (shares_nodes(*avl)) {
+        unref(*avl, (*avl)->root);
+        if (__atomic_sub_fetch((*avl)->cow, 1, __ATOMIC_ACQ_REL) == 0) {
+            free((*avl)->cow);
+        }
+    }
+    mempool_free(&(*avl)->pool);
+    free(*avl);
     *avl = NULL;
 }
 
@@ -91,6 +285,35 @@ static int get_height_diff(struct entry *e)
     return get_height(e->left) - get_height(e->right);
 }
 
+/*
+ * get_size - Get count of nodes in an avl-tree
+ */
+static size_t get_size(struct entry *e)
+{
+    if (e == NULL) {
+        return 0;
+    } else {
+        return e->size;
+    }
+}
+
+/*
+ * update_size - Recompute size of a node from its children
+ */
+static void update_size(struct entry *e)
+{
+    e->size = get_size(e->left) + get_size(e->right) + 1;
+}
+
+/*
+ * update_node - Recompute height and size of a node from its children
+ */
+static void update_node(struct entry *e)
+{
+    e->height = max(get_height(e->left), get_height(e->right)) + 1;
+    update_size(e);
+}
+
 /*
  * rr_rotate - Right-right rotate (left rotation)
  *
@@ -114,9 +337,9 @@ static void rr_rotate(struct entry **e)
     root->right = tmp->left;
     tmp->left = root;
 
-    /* Update height of nodes */
-    root->height = max(get_height(root->left), get_height(root->right)) + 1;
-    tmp->height  = max(get_height(tmp->left),  get_height(tmp->right)) + 1;
+    /* Update height and size of nodes */
+    update_node(root);
+    update_node(tmp);
 
     /* Update root node */
     *e = tmp;
@@ -146,9 +369,9 @@ static void ll_rotate(struct entry **e)
     root->left = tmp->right;
     tmp->right = root;
     
-    /* Update height of nodes */
-    root->height = max(get_height(root->left), get_height(root->right)) + 1;
-    tmp->height  = max(get_height(tmp->left),  get_height(tmp->right)) + 1;
+    /* Update height and size of nodes */
+    update_node(root);
+    update_node(tmp);
     
     /* Update root node */
     *e = tmp;
@@ -194,12 +417,15 @@ static void rl_rotate(struct entry **node)
 
 /*
  * rebalance - Re-balance the sub-avl tree
+ *
+ * A child with equal subtrees only shows up after removal,
+ * where a single rotation is the right one.
  */
 static void rebalance(struct entry **e)
 {
 
     if (get_height_diff(*e) == 2) {
-        if (get_height_diff((*e)->left) > 0) {
+        if (get_height_diff((*e)->left) >= 0) {
             ll_rotate(e);
         } else {
             lr_rotate(e);
@@ -215,176 +441,338 @@ static void rebalance(struct entry **e)
 }
 
 /*
- * subtree_add - Add a new node
+ * retrace - Re-balance nodes on the path bottom-up
+ *
+ * @path: links from root to the changed node
+ * @depth: length of path
+ *
+ * Return index of the topmost link re-balanced, nodes above
+ * it keep their places.
+ *
+ * Once a subtree keeps its old height, nodes above it need
+ * no re-balancing, only their sizes are still off by one.
  */
-static int subtree_add(struct entry **e, const avltreeElem x, comparator cmp)
+static int retrace(struct entry **path[], int depth)
 {
-    struct entry *new_e;
-    int res;
+    struct entry **link;
+    int old;
+    int top;
 
-    if (*e == NULL) {
-        new_e = (struct entry *) malloc(sizeof(struct entry));
-        if (!new_e) {
-            return -1;
+    while (depth-- > 0) {
+        link = path[depth];
+        old = (*link)->height;
 
-        } else {
-            new_e->x = x;
-            new_e->height = 1;
-            new_e->left = NULL;
-            new_e->right = NULL;
+        rebalance(link);
+        update_node(*link);
 
-            *e = new_e;
+        if ((*link)->height == old) {
+            break;
         }
+    }
+
+    top = max(depth, 0);
+    while (depth-- > 0) {
+        update_size(*path[depth]);
+    }
+    return top;
+}
 
-    } else if (cmp(x, (*e)->x) < 0) {
-        res = subtree_add(&(*e)->left, x, cmp);     /* Go left subtree. */
+/*
+ * compare - Compare x with the key of a node
+ *
+ * Intervals are ordered by lower bound, then by upper bound,
+ * so many of them may start at the same point.
+ */
+static int compare(avltree_t avl, const void *x, const void *v,
+        struct entry *e)
+{
+    int res;
 
-    } else if (cmp(x, (*e)->x) > 0) {
-        res = subtree_add(&(*e)->right, x, cmp);    /* Go right subtree. */
+    res = avl->cmp(x, e->x);
+    if (res == 0 && avl->span) {
+        res = avl->cmp(v, e->v);
+    }
+    return res;
+}
 
+/*
+ * get_span - Get the largest upper bound in a subtree, or NULL
+ */
+static void *get_span(struct entry *e)
+{
+    if (e == NULL) {
+        return NULL;
     } else {
-        return 0;   /* Duplicated and ignore. */
+        return ((struct span_entry *) e)->max;
+    }
+}
+
+/*
+ * update_span - Recompute largest upper bound of a node from its children
+ */
+static void update_span(avltree_t avl, struct entry *e)
+{
+    void *m;
+
+    m = e->v;
+    if (e->left != NULL && avl->cmp(get_span(e->left), m) > 0) {
+        m = get_span(e->left);
+    }
+    if (e->right != NULL && avl->cmp(get_span(e->right), m) > 0) {
+        m = get_span(e->right);
+    }
+    ((struct span_entry *) e)->max = m;
+}
+
+/*
+ * update_spans - Recompute largest upper bounds after retrace
+ *
+ * @path: links from root to the changed node
+ * @depth: length of path
+ *
+ * A rotation at a link only moves nodes between the subtree
+ * root and its children, the grandchildren are kept as whole.
+ * So, bottom-up, the children and then the node under each
+ * link are all that may be stale.
+ */
+static void update_spans(avltree_t avl, struct entry **path[], int depth)
+{
+    struct entry *e;
+
+    while (depth-- > 0) {
+        e = *path[depth];
+        if (e == NULL) {
+            continue;   /* A link emptied by a rotation above. */
+        }
+        if (e->left != NULL) {
+            update_span(avl, e->left);
+        }
+        if (e->right != NULL) {
+            update_span(avl, e->right);
+        }
+        update_span(avl, e);
+    }
+}
+
+/*
+ * insert - Add a new node, or update value of a map node
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ */
+static int insert(avltree_t avl, const void *x, void *v)
+{
+    struct entry **path[MAX_HEIGHT];
+    struct entry **link;
+    struct entry *new_e;
+    int depth;
+    int res;
+
+    /* Don't copy a path for nothing. */
+    if (shares_nodes(avl) && !avl->map
+            && avltree_contains(avl, (avltreeElem) x)) {
+        return 0;
+    }
+
+    link = &avl->root;
+    depth = 0;
+
+    /* Top-down descent, one comparison per level. */
+    while (*link != NULL) {
+        if (avl->cow && unshare(avl, link) == -1) {
+            return -1;
+        }
+        res = compare(avl, x, v, *link);
+        if (res == 0) {
+            if (avl->map) {
+                (*link)->v = v;
+            }
+            return 0;   /* Duplicated and ignore. */
+        }
+        path[depth++] = link;
+        link = (res < 0) ? &(*link)->left : &(*link)->right;
     }
 
-    if (res == -1) {
+    new_e = (struct entry *) mempool_alloc(avl->pool);
+    if (new_e == NULL) {
         return -1;  /* Out of memory, failed to add new node. */
+
     } else {
-        rebalance(e);   /* Re-balance subree. */
+        new_e->x = (avltreeElem) x;
+        new_e->height = 1;
+        new_e->refs = 1;
+        new_e->size = 1;
+        new_e->left = NULL;
+        new_e->right = NULL;
+        if (avl->map) {
+            new_e->v = v;
+        }
+        if (avl->span) {
+            ((struct span_entry *) new_e)->max = v;
+        }
+        *link = new_e;
 
-        (*e)->height = 1 + max(get_height((*e)->left),
-                               get_height((*e)->right));    /* Update height*/
+        retrace(path, depth);
+        if (avl->span) {
+            update_spans(avl, path, depth);
+        }
+        return 0;
     }
-    return 0;
 }
 
 int avltree_add(avltree_t avl, const avltreeElem x)
 {
-    return subtree_add(&avl->root, x, avl->cmp);
+    return insert(avl, x, NULL);
 }
 
 int avltree_contains(avltree_t avl, const avltreeElem x)
 {
     struct entry *e;
     comparator cmp;
+    int res;
 
     e = avl->root;
     cmp  = avl->cmp;
 
-    while (e != NULL && cmp(x, e->x) != 0) {
-        if (cmp(x, e->x) < 0) {
-            e = e->left;
-        } else {
-            e = e->right;
+    while (e != NULL) {
+        res = cmp(x, e->x);
+        if (res == 0) {
+            return 1;
         }
+        e = (res < 0) ? e->left : e->right;
     }
 
-    return e != NULL;
+    return 0;
 }
 
 /*
- * subree_remove - Remove a target node in subtree
+ * unshare_siblings - Make sure rotations after removal touch no shared node
  *
- * Return 0 if success, -1 if no match node found.
+ * @avl: the avl-tree
+ * @path: links from root to the parent of the removed node
+ * @depth: length of path
+ * @gone: the removed node
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * Nodes on path are private already. Re-balancing a node whose
+ * off-path child is the taller one rotates that child, and its
+ * inner grandchild for a double rotation.
  */
-static int subtree_remove(struct entry **e, const avltreeElem x, comparator cmp)
+static int unshare_siblings(avltree_t avl, struct entry **path[], int depth,
+        struct entry *gone)
 {
-    struct entry *root;
-    struct entry *tmp;
-
-    root = *e;
-
-    if (root == NULL) {
-        return -1;
+    struct entry **link;
+    struct entry *p, *c;
+    int i;
 
-        /* Target node is in left subtree */
-    } else if (cmp(x, root->x) < 0) {
-        subtree_remove(&root->left, x, cmp);
+    for (i = 0; i < depth; ++i) {
+        p = *path[i];
+        c = (i + 1 < depth) ? *path[i + 1] : gone;
+        link = (p->left == c) ? &p->right : &p->left;
 
-        /* Re-balance */
-        if (get_height(root->right) - get_height(root->left) == 2) {
-            tmp = root->right;
-
-            if (get_height(tmp->right) > get_height(tmp->left)) {
-                rr_rotate(e);
-            } else {
-                rl_rotate(e);
+        if (get_height(*link) > get_height(c)) {
+            if (unshare(avl, link) == -1) {
+                return -1;
+            }
+            link = (link == &p->right) ? &(*link)->left : &(*link)->right;
+            if (*link != NULL && unshare(avl, link) == -1) {
+                return -1;
             }
         }
+    }
+    return 0;
+}
+
+/*
+ * erase - Remove node matching x, and v in an interval tree
+ *
+ * Return 0 if success, -1 if no match node found
+ * or failed to alloc memory.
+ */
+static int erase(avltree_t avl, const void *x, const void *v)
+{
+    struct entry **path[MAX_HEIGHT];
+    struct entry **link, **next;
+    struct entry *e;
+    int depth, toward_right;
+    int res;
 
-        /* Target node is in right subtree */
-    } else if (cmp(x, root->x) > 0) {
-        subtree_remove(&root->right, x, cmp);
+    if (shares_nodes(avl) && !avltree_contains(avl, (avltreeElem) x)) {
+        return -1;
+    }
 
-        /* Re-balance */
-        if (get_height(root->left) - get_height(root->right) == 2) {
-            tmp = root->left;
+    link = &avl->root;
+    depth = 0;
 
-            if (get_height(tmp->left) > get_height(tmp->right)) {
-                ll_rotate(e);
-            } else {
-                lr_rotate(e);
-            }
+    while (*link != NULL) {
+        if (avl->cow && unshare(avl, link) == -1) {
+            return -1;
         }
+        res = compare(avl, x, v, *link);
+        if (res == 0) {
+            break;
+        }
+        path[depth++] = link;
+        link = (res < 0) ? &(*link)->left : &(*link)->right;
+    }
 
-        /* Current node is target node. */
-    } else {
-        if (root->left != NULL && root->right != NULL) {
-            /*
-             * The height of left subtree is larger than 
-             * the height of right subtree. Find the precursor 
-             * in left subtree and copy x to current node, 
-             * and free precursor. Now, avl-tree is still balanced.
-             */
-            if (get_height(root->left) > get_height(root->right)) {
-                struct entry *max;
-
-                max = root->left;
-                while (max && max->right) {
-                    max = max->right;
-                }
-                root->x = max->x;
-                subtree_remove(&root->left, max->x, cmp);
-
-                /*
-                 * The height of left subtree is lower than 
-                 * the height of right subtree. Find the successor 
-                 * in right subtree and copy x to current node,
-                 * and free successor. Now, avl-tree is still balanced.
-                 */
-            } else {
-                struct entry *min;
-
-                min = root->right;
-                while (min && min->left) {
-                    min = min->left;
-                }
-                root->x = min->x;
-                subtree_remove(&root->right, min->x, cmp);
+    if (*link == NULL) {
+        return -1;  /* No match node. */
+    }
+
+    e = *link;
+    if (e->left != NULL && e->right != NULL) {
+        /*
+         * Copy x from the precursor in the taller left subtree,
+         * or from the successor in the right one, then remove
+         * that node instead, which has one child at most.
+         */
+        path[depth++] = link;
+        toward_right = get_height(e->left) > get_height(e->right);
+        link = toward_right ? &e->left : &e->right;
+        next = link;
+        while (*next != NULL) {
+            if (avl->cow && unshare(avl, next) == -1) {
+                return -1;
+            }
+            if (next != link) {
+                path[depth++] = link;
+                link = next;
             }
+            next = toward_right ? &(*link)->right : &(*link)->left;
+        }
+    }
 
-        /* Left subtree or right subtree is NULL.  */
-        } else {
-            tmp = *e;
+    /* Nothing may fail from here on. */
+    if (avl->cow && unshare_siblings(avl, path, depth, *link) == -1) {
+        return -1;
+    }
 
-            *e = root->left ? root->left : root->right;
-            free(tmp);
+    if (e != *link) {
+        e->x = (*link)->x;
+        if (avl->map) {
+            e->v = (*link)->v;
         }
+        e = *link;
     }
 
-    /* Update the height of nodes */
-    if (*e != NULL) {
-        (*e)->height = max(get_height((*e)->left), get_height((*e)->right)) + 1;
+    /* Left subtree or right subtree is NULL. */
+    *link = (e->left != NULL) ? e->left : e->right;
+    mempool_release(avl->pool, e);
+
+    retrace(path, depth);
+    if (avl->span) {
+        update_spans(avl, path, depth);
     }
     return 0;
 }
 
-
 int avltree_remove(avltree_t avl, const avltreeElem x)
 {
-    return subtree_remove(&avl->root, x, avl->cmp);
+    return erase(avl, x, NULL);
 }
 
-int avltree_get_hight(avltree_t avl)
+int avltree_get_height(avltree_t avl)
 {
     return get_height(avl->root);
 }
@@ -427,3 +815,997 @@ int avltree_get_max(avltree_t avl, avltreeElem *x)
         return -1;
     }
 }
+
+/*
+ * find - Find node matching key
+ *
+ * Return the node, NULL if not find.
+ */
+static struct entry *find(avltree_t avl, const void *key)
+{
+    struct entry *e;
+    int res;
+
+    e = avl->root;
+    while (e != NULL) {
+        res = avl->cmp(key, e->x);
+        if (res == 0) {
+            break;
+        }
+        e = (res < 0) ? e->left : e->right;
+    }
+    return e;
+}
+
+/*
+ * find_bound - Find the closest node on one side of key
+ *
+ * @avl: the tree
+ * @key: the key
+ * @above: non-zero for the smallest node >= key,
+ *         zero for the largest node <= key
+ *
+ * Return the node, NULL if not find.
+ */
+static struct entry *find_bound(avltree_t avl, const void *key, const int above)
+{
+    struct entry *e, *found;
+    int res;
+
+    found = NULL;
+    e = avl->root;
+    while (e != NULL) {
+        res = avl->cmp(key, e->x);
+        if (res == 0) {
+            return e;
+        } else if ((res < 0) == (above != 0)) {
+            found = e;      /* On the right side, look for a closer one. */
+            e = above ? e->left : e->right;
+        } else {
+            e = above ? e->right : e->left;
+        }
+    }
+    return found;
+}
+
+int avlmap_new(avlmap_t *map, const comparator cmp)
+{
+    return tree_new(map, cmp, 1, 0);
+}
+
+void avlmap_free(avlmap_t *map)
+{
+    avltree_free(map);
+}
+
+int avlmap_put(avlmap_t map, const avlmapKey key, const avlmapValue value)
+{
+    return insert(map, key, value);
+}
+
+int avlmap_get(avlmap_t map, const avlmapKey key, avlmapValue *value)
+{
+    struct entry *e;
+
+    e = find(map, key);
+    if (e != NULL) {
+        *value = e->v;
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+int avlmap_remove(avlmap_t map, const avlmapKey key)
+{
+    return erase(map, key, NULL);
+}
+
+int avlmap_contains_key(avlmap_t map, const avlmapKey key)
+{
+    return find(map, key) != NULL;
+}
+
+/*
+ * get_pair - Output key-value pair of a node
+ *
+ * Return 0 if node exists, -1 otherwise.
+ */
+static int get_pair(struct entry *e, avlmapKey *key, avlmapValue *value)
+{
+    if (e == NULL) {
+        return -1;
+    } else {
+        *key = e->x;
+        *value = e->v;
+        return 0;
+    }
+}
+
+int avlmap_floor(avlmap_t map, const avlmapKey key,
+        avlmapKey *k, avlmapValue *value)
+{
+    return get_pair(find_bound(map, key, 0), k, value);
+}
+
+int avlmap_ceiling(avlmap_t map, const avlmapKey key,
+        avlmapKey *k, avlmapValue *value)
+{
+    return get_pair(find_bound(map, key, 1), k, value);
+}
+
+int avlmap_isempty(avlmap_t map)
+{
+    return map->root == NULL;
+}
+
+int avltree_cursor_new(avltree_cursor_t *cur, avltree_t avl)
+{
+    avltree_cursor_t new_cur;
+
+    new_cur = (avltree_cursor_t) malloc(sizeof(*new_cur));
+    if (new_cur == NULL) {
+        return -1;
+    } else {
+        new_cur->avl = avl;
+        new_cur->depth = 0;
+        *cur = new_cur;
+        return 0;
+    }
+}
+
+void avltree_cursor_free(avltree_cursor_t *cur)
+{
+    free(*cur);
+    *cur = NULL;
+}
+
+/*
+ * get_current - Output element under cursor
+ *
+ * Return 0 if cursor points to an element, -1 otherwise.
+ */
+static int get_current(avltree_cursor_t cur, avltreeElem *x)
+{
+    if (cur->depth == 0) {
+        return -1;
+    } else {
+        *x = cur->path[cur->depth - 1]->x;
+        return 0;
+    }
+}
+
+/*
+ * push_edge - Push e and its leftmost (or rightmost) descendants
+ */
+static void push_edge(avltree_cursor_t cur, struct entry *e, const int left)
+{
+    while (e != NULL) {
+        cur->path[cur->depth++] = e;
+        e = left ? e->left : e->right;
+    }
+}
+
+int avltree_cursor_first(avltree_cursor_t cur, avltreeElem *x)
+{
+    cur->depth = 0;
+    push_edge(cur, cur->avl->root, 1);
+    return get_current(cur, x);
+}
+
+int avltree_cursor_last(avltree_cursor_t cur, avltreeElem *x)
+{
+    cur->depth = 0;
+    push_edge(cur, cur->avl->root, 0);
+    return get_current(cur, x);
+}
+
+/*
+ * seek - Point cursor to the first element >= x, or > x if strict
+ *
+ * The answer is the deepest node where the descent turned left,
+ * so the path is cut right below it.
+ */
+static int seek(avltree_cursor_t cur, const avltreeElem x,
+        const int strict, avltreeElem *y)
+{
+    struct entry *e;
+    comparator cmp;
+    int found;
+    int res;
+
+    cmp = cur->avl->cmp;
+    e = cur->avl->root;
+    cur->depth = 0;
+    found = 0;
+
+    while (e != NULL) {
+        cur->path[cur->depth++] = e;
+        res = cmp(x, e->x);
+        if (res == 0 && !strict) {
+            found = cur->depth;
+            break;
+        } else if (res < 0) {
+            found = cur->depth;
+            e = e->left;
+        } else {
+            e = e->right;
+        }
+    }
+
+    cur->depth = found;
+    return get_current(cur, y);
+}
+
+int avltree_lower_bound(avltree_cursor_t cur, const avltreeElem x,
+        avltreeElem *y)
+{
+    return seek(cur, x, 0, y);
+}
+
+int avltree_upper_bound(avltree_cursor_t cur, const avltreeElem x,
+        avltreeElem *y)
+{
+    return seek(cur, x, 1, y);
+}
+
+/*
+ * step - Move cursor to in-order successor, or precursor if !forward
+ */
+static int step(avltree_cursor_t cur, const int forward, avltreeElem *y)
+{
+    struct entry *e, *child;
+
+    if (cur->depth == 0) {
+        return -1;
+    }
+
+    e = cur->path[cur->depth - 1];
+    child = forward ? e->right : e->left;
+
+    if (child != NULL) {
+        /* Leftmost node of right subtree. */
+        push_edge(cur, child, forward);
+
+    } else {
+        /* Go up until we come from the proper side. */
+        do {
+            child = cur->path[--cur->depth];
+        } while (cur->depth > 0 && child == (forward
+                    ? cur->path[cur->depth - 1]->right
+                    : cur->path[cur->depth - 1]->left));
+    }
+    return get_current(cur, y);
+}
+
+int avltree_next(avltree_cursor_t cur, avltreeElem *y)
+{
+    return step(cur, 1, y);
+}
+
+int avltree_prev(avltree_cursor_t cur, avltreeElem *y)
+{
+    return step(cur, 0, y);
+}
+
+/*
+ * climb - Cut cursor path to the deepest node whose subtree may hold x
+ *
+ * Return comparison of x with the last node left on the path.
+ *
+ * The keys of a subtree lie between the nearest ancestors the
+ * path turned right and left at. Going up, only the ancestor
+ * on the side of x needs a look, and the others are skipped.
+ */
+static int climb(avltree_cursor_t cur, const avltreeElem x)
+{
+    struct entry **path;
+    comparator cmp;
+    int d, i;
+    int res, above;
+
+    path = cur->path;
+    cmp = cur->avl->cmp;
+    d = cur->depth - 1;
+    res = cmp(x, path[d]->x);
+
+    while (res != 0) {
+        /* Nearest ancestor above path[d] on the side of x. */
+        for (i = d; i > 0; --i) {
+            if ((res > 0) == (path[i] == path[i - 1]->left)) {
+                break;
+            }
+        }
+        if (i == 0) {
+            break;      /* No bound on that side. */
+        }
+
+        above = cmp(x, path[i - 1]->x);
+        if ((res > 0) ? above < 0 : above > 0) {
+            break;      /* Between the bounds. */
+        }
+        d = i - 1;
+        res = above;
+    }
+
+    cur->depth = d + 1;
+    return res;
+}
+
+int avltree_add_hint(avltree_t avl, avltree_cursor_t cur,
+        const avltreeElem x)
+{
+    struct entry **path[MAX_HEIGHT];
+    struct entry *new_e, *e;
+    avltreeElem y;
+    int depth, top;
+    int res;
+
+    /* Values and spans have no way in here. */
+    if (avl->map || avl->span || cur->avl != avl) {
+        return -1;
+    }
+    if (cur->depth == 0 || shares_nodes(avl)) {
+        /* No finger to start from, or nodes to copy on the way. */
+        if (insert(avl, x, NULL) == -1) {
+            return -1;
+        }
+        seek(cur, x, 0, &y);
+        return 0;
+    }
+
+    res = climb(cur, x);
+    if (res == 0) {
+        return 0;   /* Duplicated and ignore. */
+    }
+
+    /* Links to the nodes kept on the cursor path. */
+    path[0] = &avl->root;
+    for (depth = 1; depth < cur->depth; ++depth) {
+        e = cur->path[depth - 1];
+        path[depth] = (cur->path[depth] == e->left) ? &e->left : &e->right;
+    }
+
+    /* Go on down from there as insert() does. */
+    e = cur->path[depth - 1];
+    path[depth] = (res < 0) ? &e->left : &e->right;
+    while (*path[depth] != NULL) {
+        e = *path[depth];
+        cur->path[depth++] = e;
+        res = avl->cmp(x, e->x);
+        if (res == 0) {
+            cur->depth = depth;
+            return 0;
+        }
+        path[depth] = (res < 0) ? &e->left : &e->right;
+    }
+
+    new_e = (struct entry *) mempool_alloc(avl->pool);
+    if (new_e == NULL) {
+        cur->depth = depth;
+        return -1;
+    }
+    new_e->x = x;
+    new_e->height = 1;
+    new_e->refs = 1;
+    new_e->size = 1;
+    new_e->left = NULL;
+    new_e->right = NULL;
+    *path[depth] = new_e;
+
+    /*
+     * Nodes above top kept their places, so is the cursor
+     * path down to there. Find new_e again from top.
+     */
+    top = retrace(path, depth);
+    e = *path[top];
+    cur->depth = top;
+    while (e != new_e) {
+        cur->path[cur->depth++] = e;
+        e = (avl->cmp(x, e->x) < 0) ? e->left : e->right;
+    }
+    cur->path[cur->depth++] = new_e;
+    return 0;
+}
+
+size_t avltree_range_scan(avltree_t avl, const avltreeElem lo,
+        const avltreeElem hi, avltree_visitor visit, void *arg)
+{
+    struct _avltree_cursor cur;
+    avltreeElem x;
+    size_t count;
+    int res;
+
+    cur.avl = avl;
+    count = 0;
+
+    res = seek(&cur, lo, 0, &x);
+    while (res == 0 && avl->cmp(x, hi) <= 0) {
+        count++;
+        if (visit(x, arg) != 0) {
+            break;
+        }
+        res = step(&cur, 1, &x);
+    }
+    return count;
+}
+
+/*
+ * count_less - Count elements less than x, or not greater if inclusive
+ */
+static size_t count_less(avltree_t avl, const avltreeElem x, const int inclusive)
+{
+    struct entry *e;
+    comparator cmp;
+    size_t count;
+    int res;
+
+    cmp = avl->cmp;
+    e = avl->root;
+    count = 0;
+
+    while (e != NULL) {
+        res = cmp(x, e->x);
+        if (res < 0 || (res == 0 && !inclusive)) {
+            e = e->left;
+        } else {
+            count += get_size(e->left) + 1;
+            e = e->right;
+        }
+    }
+    return count;
+}
+
+size_t avltree_rank(avltree_t avl, const avltreeElem x)
+{
+    return count_less(avl, x, 0);
+}
+
+int avltree_select(avltree_t avl, size_t k, avltreeElem *x)
+{
+    struct entry *e;
+    size_t left;
+
+    e = avl->root;
+    while (e != NULL) {
+        left = get_size(e->left);
+        if (k < left) {
+            e = e->left;
+        } else if (k > left) {
+            k -= left + 1;
+            e = e->right;
+        } else {
+            *x = e->x;
+            return 0;
+        }
+    }
+    return -1;  /* k is out of range. */
+}
+
+size_t avltree_count_range(avltree_t avl, const avltreeElem lo,
+        const avltreeElem hi)
+{
+    if (avl->cmp(lo, hi) > 0) {
+        return 0;
+    } else {
+        return count_less(avl, hi, 1) - count_less(avl, lo, 0);
+    }
+}
+
+size_t avltree_get_size(avltree_t avl)
+{
+    return get_size(avl->root);
+}
+
+comparator avltree_get_comparator(avltree_t avl)
+{
+    return avl->cmp;
+}
+
+/*
+ * join - Join two trees with a middle node
+ *
+ * @l: tree of elements less than k
+ * @k: the middle node
+ * @r: tree of elements greater than k
+ *
+ * Return root of the joined tree.
+ *
+ * k goes down the spine of the taller tree until the subtree
+ * there is about as high as the other tree, then rotations on
+ * the way up fix balance. Cost is O(|h(l) - h(r)| + 1).
+ */
+static struct entry *join(struct entry *l, struct entry *k, struct entry *r)
+{
+    if (get_height(l) > get_height(r) + 1) {
+        l->right = join(l->right, k, r);
+        update_node(l);
+        rebalance(&l);
+        return l;
+
+    } else if (get_height(r) > get_height(l) + 1) {
+        r->left = join(l, k, r->left);
+        update_node(r);
+        rebalance(&r);
+        return r;
+
+    } else {
+        k->left = l;
+        k->right = r;
+        update_node(k);
+        return k;
+    }
+}
+
+/*
+ * split_last - Detach the maximum node of a tree
+ *
+ * Return root of the rest, *k is the detached node.
+ */
+static struct entry *split_last(struct entry *t, struct entry **k)
+{
+    if (t->right == NULL) {
+        *k = t;
+        return t->left;
+    } else {
+        return join(t->left, t, split_last(t->right, k));
+    }
+}
+
+/*
+ * join2 - Join two trees with no middle node
+ */
+static struct entry *join2(struct entry *l, struct entry *r)
+{
+    struct entry *k;
+
+    if (l == NULL) {
+        return r;
+    } else {
+        l = split_last(l, &k);
+        return join(l, k, r);
+    }
+}
+
+/*
+ * split - Split a tree by key
+ *
+ * @t: the tree
+ * @key: the key
+ * @l: output tree of elements less than key
+ * @r: output tree of elements greater than key
+ *
+ * Return the detached node equal to key, NULL if none.
+ */
+static struct entry *split(struct entry *t, const void *key, comparator cmp,
+        struct entry **l, struct entry **r)
+{
+    struct entry *m;
+    int res;
+
+    if (t == NULL) {
+        *l = NULL;
+        *r = NULL;
+        return NULL;
+    }
+
+    res = cmp(key, t->x);
+    if (res == 0) {
+        *l = t->left;
+        *r = t->right;
+        return t;
+    } else if (res < 0) {
+        m = split(t->left, key, cmp, l, r);
+        *r = join(*r, t, t->right);
+        return m;
+    } else {
+        m = split(t->right, key, cmp, l, r);
+        *l = join(t->left, t, *l);
+        return m;
+    }
+}
+
+int avltree_join(avltree_t avl, avltree_t *other)
+{
+    avltreeElem max, min;
+
+    if (avl->cmp != (*other)->cmp || avl->map != (*other)->map
+            || avl->span || (*other)->span
+            || shares_nodes(avl) || shares_nodes(*other)) {
+        return -1;
+    }
+    if (avltree_get_max(avl, &max) == 0 && avltree_get_min(*other, &min) == 0
+            && avl->cmp(max, min) >= 0) {
+        return -1;
+    }
+
+    mempool_merge(avl->pool, (*other)->pool);
+    avl->root = join2(avl->root, (*other)->root);
+    avltree_free(other);
+    return 0;
+}
+
+int avltree_split(avltree_t avl, const avltreeElem x, avltree_t *right)
+{
+    struct entry *l, *r, *m;
+    avltree_t new_avl;
+
+    if (shares_nodes(avl) || avl->span) {
+        return -1;
+    }
+
+    new_avl = (avltree_t) malloc(sizeof(*new_avl));
+    if (new_avl == NULL) {
+        return -1;
+    }
+
+    m = split(avl->root, x, avl->cmp, &l, &r);
+    if (m != NULL) {
+        r = join(NULL, m, r);
+    }
+
+    /* Both trees keep drawing nodes from the same pool. */
+    new_avl->pool = mempool_share(avl->pool);
+    new_avl->cmp = avl->cmp;
+    new_avl->map = avl->map;
+    new_avl->span = 0;
+    new_avl->cow = NULL;
+    new_avl->root = r;
+    avl->root = l;
+    *right = new_avl;
+    return 0;
+}
+
+/*
+ * Subtasks run on threads of their own while the budget lasts,
+ * which halves at each fork, and while there is enough work to
+ * pay for a thread. Each task keeps the nodes it drops on a list
+ * of its own, and gives them to the shared pool under a lock
+ * once at its end.
+ */
+static const size_t GRAIN = 4096;
+
+enum setop_type {
+    SET_UNION,
+    SET_INTERSECT,
+    SET_DIFFERENCE,
+};
+
+struct setop {
+    enum setop_type type;
+    comparator cmp;
+    mempool_t pool;
+    pthread_mutex_t lock;   /* guards pool */
+};
+
+struct setop_task {
+    struct setop *op;
+    struct entry *t1;
+    struct entry *t2;
+    struct entry *res;
+    int budget;
+};
+
+/*
+ * drop - Put a node detached from its children on the dropped
+ * list, linked by left
+ */
+static void drop(struct entry **dropped, struct entry *e)
+{
+    if (e != NULL) {
+        e->left = *dropped;
+        *dropped = e;
+    }
+}
+
+/*
+ * drop_tree - Put all nodes of a tree on the dropped list
+ */
+static void drop_tree(struct entry **dropped, struct entry *e)
+{
+    if (e != NULL) {
+        drop_tree(dropped, e->left);
+        drop_tree(dropped, e->right);
+        drop(dropped, e);
+    }
+}
+
+/*
+ * release_dropped - Give nodes on the dropped list back to the pool
+ */
+static void release_dropped(struct setop *op, struct entry *dropped)
+{
+    struct entry *next;
+
+    pthread_mutex_lock(&op->lock);
+    while (dropped != NULL) {
+        next = dropped->left;
+        mempool_release(op->pool, dropped);
+        dropped = next;
+    }
+    pthread_mutex_unlock(&op->lock);
+}
+
+static struct entry *set_op(struct setop *op, struct entry *t1,
+        struct entry *t2, const int budget, struct entry **dropped);
+
+static void *run_task(void *arg)
+{
+    struct setop_task *task;
+    struct entry *dropped;
+
+    task = (struct setop_task *) arg;
+    dropped = NULL;
+    task->res = set_op(task->op, task->t1, task->t2, task->budget,
+            &dropped);
+    release_dropped(task->op, dropped);
+    return NULL;
+}
+
+/*
+ * set_op - Apply a set operation to t1 and t2
+ *
+ * Both trees are consumed, return root of the result.
+ *
+ * t2 is split by the root of t1 for union and intersection,
+ * t1 by the root of t2 for difference. Both halves are solved
+ * independently and joined back, which takes O(m log(n/m + 1))
+ * work for trees of sizes m <= n.
+ */
+static struct entry *set_op(struct setop *op, struct entry *t1,
+        struct entry *t2, const int budget, struct entry **dropped)
+{
+    struct setop_task task;
+    struct entry *k, *m, *l1, *r1, *l2, *r2, *l, *r;
+    pthread_t tid;
+    size_t size;
+    int forked;
+
+    if (t1 == NULL || t2 == NULL) {
+        if (op->type == SET_UNION) {
+            return (t1 != NULL) ? t1 : t2;
+        } else if (op->type == SET_INTERSECT) {
+            drop_tree(dropped, (t1 != NULL) ? t1 : t2);
+            return NULL;
+        } else {
+            drop_tree(dropped, t2);
+            return t1;
+        }
+    }
+
+    /* Before split() takes the trees apart. */
+    size = get_size(t1) + get_size(t2);
+
+    if (op->type == SET_DIFFERENCE) {
+        k = t2;
+        l2 = t2->left;
+        r2 = t2->right;
+        m = split(t1, k->x, op->cmp, &l1, &r1);
+    } else {
+        k = t1;
+        l1 = t1->left;
+        r1 = t1->right;
+        m = split(t2, k->x, op->cmp, &l2, &r2);
+    }
+
+    forked = 0;
+    if (budget > 0 && size >= GRAIN) {
+        task.op = op;
+        task.t1 = l1;
+        task.t2 = l2;
+        task.budget = budget - 1;
+        forked = pthread_create(&tid, NULL, run_task, &task) == 0;
+    }
+
+    if (forked) {
+        r = set_op(op, r1, r2, budget - 1, dropped);
+        pthread_join(tid, NULL);
+        l = task.res;
+    } else {
+        l = set_op(op, l1, l2, 0, dropped);
+        r = set_op(op, r1, r2, 0, dropped);
+    }
+
+    if (op->type == SET_UNION) {
+        drop(dropped, m);
+        return join(l, k, r);
+    } else if (op->type == SET_INTERSECT && m != NULL) {
+        drop(dropped, m);
+        return join(l, k, r);
+    } else {
+        drop(dropped, k);
+        drop(dropped, m);
+        return join2(l, r);
+    }
+}
+
+/*
+ * combine - Replace avl by avl op other, and free other
+ *
+ * Return 0 if success, -1 if trees don't match.
+ */
+static int combine(avltree_t avl, avltree_t *other, enum setop_type type)
+{
+    struct setop op;
+    struct entry *dropped;
+    long cpus;
+    int budget;
+
+    if (avl->cmp != (*other)->cmp || avl->map || (*other)->map
+            || shares_nodes(avl) || shares_nodes(*other)) {
+        return -1;
+    }
+
+    /* Enough forks to have about two tasks per cpu. */
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (budget = 1; cpus > 1; cpus /= 2) {
+        budget++;
+    }
+
+    op.type = type;
+    op.cmp = avl->cmp;
+    op.pool = avl->pool;
+    pthread_mutex_init(&op.lock, NULL);
+    mempool_merge(avl->pool, (*other)->pool);
+
+    dropped = NULL;
+    avl->root = set_op(&op, avl->root, (*other)->root, budget, &dropped);
+    release_dropped(&op, dropped);
+
+    pthread_mutex_destroy(&op.lock);
+    avltree_free(other);
+    return 0;
+}
+
+int avltree_union(avltree_t avl, avltree_t *other)
+{
+    return combine(avl, other, SET_UNION);
+}
+
+int avltree_intersect(avltree_t avl, avltree_t *other)
+{
+    return combine(avl, other, SET_INTERSECT);
+}
+
+int avltree_difference(avltree_t avl, avltree_t *other)
+{
+    return combine(avl, other, SET_DIFFERENCE);
+}
+
+int avltree_snapshot(avltree_t avl, avltree_t *snap)
+{
+    avltree_t new_avl;
+
+    if (avl->span) {
+        return -1;
+    }
+
+    new_avl = (avltree_t) malloc(sizeof(*new_avl));
+    if (new_avl == NULL) {
+        return -1;
+    }
+    if (avl->cow == NULL) {
+        avl->cow = (int *) malloc(sizeof(*avl->cow));
+        if (avl->cow == NULL) {
+            free(new_avl);
+            return -1;
+        }
+        *avl->cow = 1;
+    }
+
+    /* One more tree points to root, and to the pool of its nodes. */
+    if (avl->root != NULL) {
+        __atomic_add_fetch(&avl->root->refs, 1, __ATOMIC_RELAXED);
+    }
+    new_avl->pool = mempool_share(avl->pool);
+    new_avl->root = avl->root;
+    new_avl->cmp = avl->cmp;
+    new_avl->map = avl->map;
+    new_avl->span = 0;
+    new_avl->cow = avl->cow;
+    __atomic_add_fetch(avl->cow, 1, __ATOMIC_RELAXED);
+    *snap = new_avl;
+    return 0;
+}
+
+int intervaltree_new(intervaltree_t *it, const comparator cmp)
+{
+    return tree_new(it, cmp, 1, 1);
+}
+
+void intervaltree_free(intervaltree_t *it)
+{
+    avltree_free(it);
+}
+
+int intervaltree_add(intervaltree_t it, const intervaltreePoint lo,
+        const intervaltreePoint hi)
+{
+    if (it->cmp(lo, hi) > 0) {
+        return -1;
+    }
+    return insert(it, lo, hi);
+}
+
+int intervaltree_remove(intervaltree_t it, const intervaltreePoint lo,
+        const intervaltreePoint hi)
+{
+    return erase(it, lo, hi);
+}
+
+int intervaltree_contains(intervaltree_t it, const intervaltreePoint lo,
+        const intervaltreePoint hi)
+{
+    struct entry *e;
+    int res;
+
+    e = it->root;
+    while (e != NULL) {
+        res = compare(it, lo, hi, e);
+        if (res == 0) {
+            return 1;
+        }
+        e = (res < 0) ? e->left : e->right;
+    }
+    return 0;
+}
+
+/*
+ * overlap - Visit intervals of a subtree overlapping [lo, hi] in order
+ *
+ * Return non-zero if visit asked to stop.
+ *
+ * A subtree is skipped as a whole if its largest upper bound
+ * is below lo, and right subtrees once lower bounds pass hi.
+ * Every node left is either reported or on the path to one,
+ * which gives O(log n + k) for k reported intervals.
+ */
+static int overlap(intervaltree_t it, struct entry *e, const void *lo,
+        const void *hi, intervaltree_visitor visit, void *arg, size_t *count)
+{
+    comparator cmp;
+
+    cmp = it->cmp;
+    while (e != NULL && cmp(get_span(e), lo) >= 0) {
+        if (overlap(it, e->left, lo, hi, visit, arg, count)) {
+            return 1;
+        }
+        if (cmp(e->x, hi) > 0) {
+            return 0;
+        }
+        if (cmp(e->v, lo) >= 0) {
+            ++*count;
+            if (visit(e->x, e->v, arg)) {
+                return 1;
+            }
+        }
+        e = e->right;
+    }
+    return 0;
+}
+
+size_t intervaltree_overlap(intervaltree_t it, const intervaltreePoint lo,
+        const intervaltreePoint hi, intervaltree_visitor visit, void *arg)
+{
+    size_t count;
+
+    count = 0;
+    overlap(it, it->root, lo, hi, visit, arg, &count);
+    return count;
+}
+
+size_t intervaltree_stab(intervaltree_t it, const intervaltreePoint x,
+        intervaltree_visitor visit, void *arg)
+{
+    return intervaltree_overlap(it, x, x, visit, arg);
+}
+
+size_t intervaltree_get_size(intervaltree_t it)
+{
+    return get_size(it->root);
+}
+
+int intervaltree_isempty(intervaltree_t it)
+{
+    return it->root == NULL;
+}
@@ -202,6 +202,20 @@ int binary_minheap_peek(binary_minheap_t heap, binaryMinHeapElem *x)
     }
 }
 
+int binary_minheap_replace(binary_minheap_t heap,
+        const binaryMinHeapElem x, binaryMinHeapElem *old)
+{
+    if (binary_minheap_isempty(heap)) {
+        return -1;
+
+    } else {
+        *old = heap->array[0];
+        heap->array[0] = x;
+        shiftdown(heap, 0);
+        return 0;
+    }
+}
+
 size_t binary_minheap_get_size(binary_minheap_t heap)
 {
 
@@ -0,0 +1,661 @@
+/*
+ * bptree.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bptree.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Keys of a node fill 4 cache lines, and are searched without
+ * touching the values or children stored behind them.
+ *
+ * A full node holds ORDER keys. Apart from the root, a leaf
+ * holds at least ORDER / 2 keys and an inner node at least
+ * ORDER / 2 - 1 keys, so that splitting a full node or merging
+ * two minimal ones always gives legal nodes.
+ */
+#define ORDER       64
+#define MIN_LEAF    (ORDER / 2)
+#define MIN_INNER   (ORDER / 2 - 1)
+
+struct node {
+    int keys[ORDER];
+    int n;              /* count of keys */
+    int leaf;           /* non-zero if node is a leaf */
+};
+
+struct leaf {
+    struct node hdr;
+    bptreeValue values[ORDER];
+    struct leaf *next;  /* next leaf in key order */
+};
+
+/*
+ * Keys of child[i] are in [keys[i - 1], keys[i]).
+ */
+struct inner {
+    struct node hdr;
+    struct node *child[ORDER + 1];
+};
+
+struct _bptree {
+    struct node *root;  /* never NULL, an empty leaf at least */
+    size_t size;        /* count of keys */
+};
+
+/*
+ * new_node - Alloc an empty leaf or inner node
+ *
+ * Unused keys stay zeroed, so the vector search never
+ * reads uninitialized memory.
+ */
+static struct node *new_node(const int leaf)
+{
+    struct node *nd;
+
+    if (leaf) {
+        nd = (struct node *) calloc(1, sizeof(struct leaf));
+    } else {
+        nd = (struct node *) calloc(1, sizeof(struct inner));
+    }
+
+    if (nd != NULL) {
+        nd->leaf = leaf;
+    }
+    return nd;
+}
+
+static void free_node(struct node *nd)
+{
+    int i;
+
+    if (!nd->leaf) {
+        for (i = 0; i <= nd->n; ++i) {
+            free_node(((struct inner *) nd)->child[i]);
+        }
+    }
+    free(nd);
+}
+
+/*
+ * count_below - Count keys less than key, or not greater if inclusive
+ *
+ * Keys are sorted, so the count is also the position of
+ * the first key not counted.
+ */
+static int count_below(const struct node *nd, const int key,
+        const int inclusive)
+{
+#ifdef __SSE2__
+    __m128i k, v;
+    int i, bits;
+
+    /* 4 keys per compare, stop at the first block not all below. */
+    k = _mm_set1_epi32(key);
+    for (i = 0; i < nd->n; i += 4) {
+        v = _mm_loadu_si128((const __m128i *) &nd->keys[i]);
+        if (inclusive) {
+            bits = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, k))) & 0xf;
+        } else {
+            bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, k)));
+        }
+        if (nd->n - i < 4) {
+            bits &= (1 << (nd->n - i)) - 1;
+        }
+        if (bits != 0xf) {
+            return i + __builtin_popcount(bits);
+        }
+    }
+    return nd->n;
+#else
+    int lo, hi, mid;
+
+    lo = 0;
+    hi = nd->n;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (nd->keys[mid] < key || (inclusive && nd->keys[mid] == key)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+#endif
+}
+
+int bptree_new(bptree_t *bpt)
+{
+    bptree_t new_bpt;
+
+    new_bpt = (bptree_t) malloc(sizeof(*new_bpt));
+    if (new_bpt == NULL) {
+        return -1;
+    }
+
+    new_bpt->root = new_node(1);
+    if (new_bpt->root == NULL) {
+        free(new_bpt);
+        return -1;
+    } else {
+        new_bpt->size = 0;
+        *bpt = new_bpt;
+        return 0;
+    }
+}
+
+void bptree_free(bptree_t *bpt)
+{
+    free_node((*bpt)->root);
+    free(*bpt);
+    *bpt = NULL;
+}
+
+/*
+ * find_leaf - Descend to the leaf that may hold key
+ */
+static struct leaf *find_leaf(bptree_t bpt, const int key)
+{
+    struct node *nd;
+
+    nd = bpt->root;
+    while (!nd->leaf) {
+        nd = ((struct inner *) nd)->child[count_below(nd, key, 1)];
+    }
+    return (struct leaf *) nd;
+}
+
+int bptree_get(bptree_t bpt, const int key, bptreeValue *value)
+{
+    struct leaf *lf;
+    int i;
+
+    lf = find_leaf(bpt, key);
+    i = count_below(&lf->hdr, key, 0);
+    if (i < lf->hdr.n && lf->hdr.keys[i] == key) {
+        *value = lf->values[i];
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+int bptree_contains(bptree_t bpt, const int key)
+{
+    bptreeValue value;
+
+    return bptree_get(bpt, key, &value) == 0;
+}
+
+/*
+ * split_child - Split the full child i of parent in halves
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ */
+static int split_child(struct inner *parent, const int i)
+{
+    struct node *c, *s;
+    int half, j;
+
+    c = parent->child[i];
+    s = new_node(c->leaf);
+    if (s == NULL) {
+        return -1;
+    }
+
+    half = ORDER / 2;
+    for (j = parent->hdr.n; j > i; --j) {
+        parent->hdr.keys[j] = parent->hdr.keys[j - 1];
+        parent->child[j + 1] = parent->child[j];
+    }
+    parent->child[i + 1] = s;
+    parent->hdr.n++;
+
+    if (c->leaf) {
+        /* Both halves keep their keys, s starts with the separator. */
+        s->n = ORDER - half;
+        memcpy(s->keys, &c->keys[half], s->n * sizeof(int));
+        memcpy(((struct leaf *) s)->values, &((struct leaf *) c)->values[half],
+                s->n * sizeof(bptreeValue));
+        ((struct leaf *) s)->next = ((struct leaf *) c)->next;
+        ((struct leaf *) c)->next = (struct leaf *) s;
+        parent->hdr.keys[i] = s->keys[0];
+
+    } else {
+        /* The middle key moves up to parent. */
+        s->n = ORDER - half - 1;
+        memcpy(s->keys, &c->keys[half + 1], s->n * sizeof(int));
+        memcpy(((struct inner *) s)->child, &((struct inner *) c)->child[half + 1],
+                (s->n + 1) * sizeof(struct node *));
+        parent->hdr.keys[i] = c->keys[half];
+    }
+    c->n = half;
+    return 0;
+}
+
+int bptree_put(bptree_t bpt, const int key, const bptreeValue value)
+{
+    struct node *nd, *root;
+    struct leaf *lf;
+    int i, j;
+
+    /*
+     * Split full nodes on the way down, so the leaf always has
+     * room and no split ever needs to go back up. Each split
+     * leaves a valid tree, which keeps failure harmless.
+     */
+    if (bpt->root->n == ORDER) {
+        root = new_node(0);
+        if (root == NULL) {
+            return -1;
+        }
+        ((struct inner *) root)->child[0] = bpt->root;
+        if (split_child((struct inner *) root, 0) == -1) {
+            free(root);
+            return -1;
+        }
+        bpt->root = root;
+    }
+
+    nd = bpt->root;
+    while (!nd->leaf) {
+        i = count_below(nd, key, 1);
+        if (((struct inner *) nd)->child[i]->n == ORDER) {
+            if (split_child((struct inner *) nd, i) == -1) {
+                return -1;
+            }
+            if (key >= nd->keys[i]) {
+                i++;
+            }
+        }
+        nd = ((struct inner *) nd)->child[i];
+    }
+
+    lf = (struct leaf *) nd;
+    i = count_below(nd, key, 0);
+    if (i < nd->n && nd->keys[i] == key) {
+        lf->values[i] = value;
+        return 0;
+    }
+
+    for (j = nd->n; j > i; --j) {
+        nd->keys[j] = nd->keys[j - 1];
+        lf->values[j] = lf->values[j - 1];
+    }
+    nd->keys[i] = key;
+    lf->values[i] = value;
+    nd->n++;
+    bpt->size++;
+    return 0;
+}
+
+/*
+ * borrow_left - Move the last key of child i - 1 to child i
+ */
+static void borrow_left(struct inner *parent, const int i)
+{
+    struct node *c, *l;
+    int j;
+
+    c = parent->child[i];
+    l = parent->child[i - 1];
+
+    for (j = c->n; j > 0; --j) {
+        c->keys[j] = c->keys[j - 1];
+    }
+
+    if (c->leaf) {
+        struct leaf *cl = (struct leaf *) c;
+
+        for (j = c->n; j > 0; --j) {
+            cl->values[j] = cl->values[j - 1];
+        }
+        c->keys[0] = l->keys[l->n - 1];
+        cl->values[0] = ((struct leaf *) l)->values[l->n - 1];
+        parent->hdr.keys[i - 1] = c->keys[0];
+
+    } else {
+        struct inner *ci = (struct inner *) c;
+
+        for (j = c->n + 1; j > 0; --j) {
+            ci->child[j] = ci->child[j - 1];
+        }
+        c->keys[0] = parent->hdr.keys[i - 1];
+        ci->child[0] = ((struct inner *) l)->child[l->n];
+        parent->hdr.keys[i - 1] = l->keys[l->n - 1];
+    }
+    c->n++;
+    l->n--;
+}
+
+/*
+ * borrow_right - Move the first key of child i + 1 to child i
+ */
+static void borrow_right(struct inner *parent, const int i)
+{
+    struct node *c, *r;
+    int j;
+
+    c = parent->child[i];
+    r = parent->child[i + 1];
+
+    if (c->leaf) {
+        struct leaf *rl = (struct leaf *) r;
+
+        c->keys[c->n] = r->keys[0];
+        ((struct leaf *) c)->values[c->n] = rl->values[0];
+        for (j = 1; j < r->n; ++j) {
+            r->keys[j - 1] = r->keys[j];
+            rl->values[j - 1] = rl->values[j];
+        }
+        parent->hdr.keys[i] = r->keys[0];
+
+    } else {
+        struct inner *ri = (struct inner *) r;
+
+        c->keys[c->n] = parent->hdr.keys[i];
+        ((struct inner *) c)->child[c->n + 1] = ri->child[0];
+        parent->hdr.keys[i] = r->keys[0];
+        for (j = 1; j < r->n; ++j) {
+            r->keys[j - 1] = r->keys[j];
+        }
+        for (j = 1; j <= r->n; ++j) {
+            ri->child[j - 1] = ri->child[j];
+        }
+    }
+    c->n++;
+    r->n--;
+}
+
+/*
+ * merge_children - Merge child i + 1 into child i
+ */
+static void merge_children(struct inner *parent, const int i)
+{
+    struct node *l, *r;
+    int j;
+
+    l = parent->child[i];
+    r = parent->child[i + 1];
+
+    if (l->leaf) {
+        memcpy(&l->keys[l->n], r->keys, r->n * sizeof(int));
+        memcpy(&((struct leaf *) l)->values[l->n], ((struct leaf *) r)->values,
+                r->n * sizeof(bptreeValue));
+        ((struct leaf *) l)->next = ((struct leaf *) r)->next;
+        l->n += r->n;
+
+    } else {
+        /* The separator comes down between both halves. */
+        l->keys[l->n] = parent->hdr.keys[i];
+        memcpy(&l->keys[l->n + 1], r->keys, r->n * sizeof(int));
+        memcpy(&((struct inner *) l)->child[l->n + 1], ((struct inner *) r)->child,
+                (r->n + 1) * sizeof(struct node *));
+        l->n += r->n + 1;
+    }
+    free(r);
+
+    for (j = i + 1; j < parent->hdr.n; ++j) {
+        parent->hdr.keys[j - 1] = parent->hdr.keys[j];
+        parent->child[j] = parent->child[j + 1];
+    }
+    parent->hdr.n--;
+}
+
+int bptree_remove(bptree_t bpt, const int key)
+{
+    struct node *nd, *c;
+    struct inner *in;
+    struct leaf *lf;
+    int i, j, min;
+
+    /*
+     * Top up every child on the way down before entering it,
+     * so the leaf can lose a key and no fix needs to go back up.
+     */
+    nd = bpt->root;
+    while (!nd->leaf) {
+        in = (struct inner *) nd;
+        i = count_below(nd, key, 1);
+        c = in->child[i];
+        min = c->leaf ? MIN_LEAF : MIN_INNER;
+
+        if (c->n <= min) {
+            if (i > 0 && in->child[i - 1]->n > min) {
+                borrow_left(in, i);
+            } else if (i < nd->n && in->child[i + 1]->n > min) {
+                borrow_right(in, i);
+            } else if (i < nd->n) {
+                merge_children(in, i);
+            } else {
+                merge_children(in, --i);
+            }
+            c = in->child[i];
+
+            /* Root may have lost its last key. */
+            if (nd == bpt->root && nd->n == 0) {
+                bpt->root = c;
+                free(nd);
+            }
+        }
+        nd = c;
+    }
+
+    lf = (struct leaf *) nd;
+    i = count_below(nd, key, 0);
+    if (i == nd->n || nd->keys[i] != key) {
+        return -1;
+    }
+
+    for (j = i + 1; j < nd->n; ++j) {
+        nd->keys[j - 1] = nd->keys[j];
+        lf->values[j - 1] = lf->values[j];
+    }
+    nd->n--;
+    bpt->size--;
+    return 0;
+}
+
+size_t bptree_range_scan(bptree_t bpt, const int lo, const int hi,
+        bptree_visitor visit, void *arg)
+{
+    struct leaf *lf;
+    size_t count;
+    int i;
+
+    count = 0;
+    lf = find_leaf(bpt, lo);
+    i = count_below(&lf->hdr, lo, 0);
+
+    while (lf != NULL) {
+        for (; i < lf->hdr.n; ++i) {
+            if (lf->hdr.keys[i] > hi) {
+                return count;
+            }
+            count++;
+            if (visit(lf->hdr.keys[i], lf->values[i], arg) != 0) {
+                return count;
+            }
+        }
+        lf = lf->next;
+        i = 0;
+    }
+    return count;
+}
+
+size_t bptree_get_size(bptree_t bpt)
+{
+    return bpt->size;
+}
+
+int bptree_isempty(bptree_t bpt)
+{
+    return bpt->size == 0;
+}
+
+/*
+ * build_level - Build parents over a level of nodes
+ *
+ * @nodes: nodes of the level, replaced by their parents
+ * @mins: least key under each node, replaced likewise
+ * @count: count of nodes, replaced likewise
+ *
+ * Children are spread evenly, so every parent has more than
+ * ORDER / 2 children. Return 0 if success, -1 if failed to
+ * alloc memory, and then the level is left as it was.
+ */
+static int build_level(struct node **nodes, int *mins, size_t *count)
+{
+    struct inner *in, *chain;
+    size_t parents, per, extra, p, c;
+    int j;
+
+    parents = (*count + ORDER) / (ORDER + 1);
+    per = *count / parents;
+    extra = *count % parents;
+
+    /* Alloc all parents first, chained through child[0]. */
+    chain = NULL;
+    for (p = 0; p < parents; ++p) {
+        in = (struct inner *) new_node(0);
+        if (in == NULL) {
+            while (chain != NULL) {
+                in = chain;
+                chain = (struct inner *) chain->child[0];
+                free(in);
+            }
+            return -1;
+        }
+        in->child[0] = (struct node *) chain;
+        chain = in;
+    }
+
+    /* Parent p never covers a child before p, nodes is safe to reuse. */
+    c = 0;
+    for (p = 0; p < parents; ++p) {
+        in = chain;
+        chain = (struct inner *) chain->child[0];
+
+        in->hdr.n = (int) (per + (p < extra)) - 1;
+        for (j = 0; j <= in->hdr.n; ++j) {
+            in->child[j] = nodes[c + j];
+            if (j > 0) {
+                in->hdr.keys[j - 1] = mins[c + j];
+            }
+        }
+        nodes[p] = (struct node *) in;
+        mins[p] = mins[c];
+        c += in->hdr.n + 1;
+    }
+
+    *count = parents;
+    return 0;
+}
+
+int bptree_from_sorted(bptree_t *bpt, const int keys[],
+        bptreeValue const values[], const size_t n)
+{
+    struct node **nodes;
+    struct leaf *lf, *prev;
+    int *mins;
+    size_t leaves, per, extra, count, i, k;
+
+    for (i = 1; i < n; ++i) {
+        if (keys[i - 1] >= keys[i]) {
+            return -1;
+        }
+    }
+
+    if (n <= ORDER) {
+        if (bptree_new(bpt) == -1) {
+            return -1;
+        }
+        for (i = 0; i < n; ++i) {
+            (*bpt)->root->keys[i] = keys[i];
+            ((struct leaf *) (*bpt)->root)->values[i] =
+                (values != NULL) ? values[i] : NULL;
+        }
+        (*bpt)->root->n = (int) n;
+        (*bpt)->size = n;
+        return 0;
+    }
+
+    leaves = (n + ORDER - 1) / ORDER;
+    nodes = (struct node **) malloc(leaves * sizeof(struct node *));
+    mins = (int *) malloc(leaves * sizeof(int));
+    *bpt = (bptree_t) malloc(sizeof(**bpt));
+    if (nodes == NULL || mins == NULL || *bpt == NULL) {
+        free(nodes);
+        free(mins);
+        free(*bpt);
+        *bpt = NULL;
+        return -1;
+    }
+
+    /* Leaves, filled evenly and linked in order. */
+    per = n / leaves;
+    extra = n % leaves;
+    prev = NULL;
+    k = 0;
+    for (i = 0; i < leaves; ++i) {
+        lf = (struct leaf *) new_node(1);
+        if (lf == NULL) {
+            break;
+        }
+        lf->hdr.n = (int) (per + (i < extra));
+        memcpy(lf->hdr.keys, &keys[k], lf->hdr.n * sizeof(int));
+        if (values != NULL) {
+            memcpy(lf->values, &values[k], lf->hdr.n * sizeof(bptreeValue));
+        }
+        if (prev != NULL) {
+            prev->next = lf;
+        }
+        prev = lf;
+        nodes[i] = (struct node *) lf;
+        mins[i] = keys[k];
+        k += lf->hdr.n;
+    }
+
+    count = i;
+    if (count == leaves) {
+        while (count > 1 && build_level(nodes, mins, &count) == 0) {
+            ;
+        }
+    }
+
+    if (count != 1) {
+        for (i = 0; i < count; ++i) {
+            free_node(nodes[i]);
+        }
+        free(nodes);
+        free(mins);
+        free(*bpt);
+        *bpt = NULL;
+        return -1;
+    }
+
+    (*bpt)->root = nodes[0];
+    (*bpt)->size = n;
+    free(nodes);
+    free(mins);
+    return 0;
+}
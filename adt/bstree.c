@@ -20,6 +20,7 @@
 
 #include <stdlib.h>
 #include "bstree.h"
+#include "mempool.h"
 #define max(a, b) (((a) > (b)) ? (a) : (b))
 
 struct entry {
@@ -30,10 +31,28 @@ struct entry {
 
 struct _bstree {
     struct entry *root;  /* root node of bstree */
+    mempool_t pool;      /* nodes of bstree */
     comparator cmp;      /* comparing function */
+    int splay;           /* non-zero to splay on access */
 };
 
-int bstree_new(bstree_t *bstree, const comparator cmp)
+/*
+ * A bstree has no bound on its height,
+ * so the path of a cursor grows on demand.
+ */
+static const size_t DEFAULT_PATH = 32;
+
+struct _bstree_cursor {
+    bstree_t bstree;
+    size_t depth;           /* 0 if cursor points to nothing */
+    size_t size;            /* capacity of path */
+    struct entry **path;    /* root to current node */
+};
+
+/*
+ * tree_new - Create a new bstree, plain or splaying
+ */
+static int tree_new(bstree_t *bstree, const comparator cmp, const int splay)
 {
     bstree_t new_bstree;
 
@@ -42,34 +61,186 @@ int bstree_new(bstree_t *bstree, const comparator cmp)
     if (new_bstree == NULL) {
         return -1;
 
+    } else if (mempool_new(&new_bstree->pool, sizeof(struct entry)) == -1) {
+        free(new_bstree);
+        return -1;
+
     } else {
         new_bstree->root = NULL;
         new_bstree->cmp  = (cmp != NULL) ? cmp : cmp_int;
+        new_bstree->splay = splay;
         *bstree = new_bstree;
         return 0;
     }
 
 }
 
+int bstree_new(bstree_t *bstree, const comparator cmp)
+{
+    return tree_new(bstree, cmp, 0);
+}
+
+int bstree_new_splay(bstree_t *bstree, const comparator cmp)
+{
+    return tree_new(bstree, cmp, 1);
+}
+
+void bstree_free(bstree_t *bstree)
+{
+    /* Nodes go away with their chunks, no need to walk the tree. */
+    mempool_free(&(*bstree)->pool);
+    free(*bstree);
+    *bstree = NULL;
+}
+
 /**
- * subtree_free - Destroy a subtree 
+ * splay - Bring the node of x, or the last node met, up to root
+ *
+ * @root: the root of subtree
+ * @x: the value
+ * @cmp: comparing function
+ *
+ * Return the new root.
+ *
+ * Top-down splaying: nodes passed on the way down are hung on a
+ * left tree (less than x) and a right tree (greater than x), with
+ * a rotation first when the path goes the same way twice. At the
+ * end both trees are reassembled under the last node. Every node
+ * on the path ends up about half as deep as before.
  */
-static void subtree_free(struct entry *root)
+static struct entry *splay(struct entry *root, const bstreeElem x, comparator cmp)
 {
+    struct entry header, *l, *r, *y;
+    int res;
+
     if (root == NULL) {
-        return;
+        return NULL;
+    }
+
+    /* header.right is the left tree and header.left the right one. */
+    header.left = NULL;
+    header.right = NULL;
+    l = &header;
+    r = &header;
+
+    while ((res = cmp(x, root->x)) != 0) {
+        if (res < 0) {
+            if (root->left == NULL) {
+                break;
+            }
+            /* Zig-zig, rotate right. */
+            if (cmp(x, root->left->x) < 0) {
+                y = root->left;
+                root->left = y->right;
+                y->right = root;
+                root = y;
+                if (root->left == NULL) {
+                    break;
+                }
+            }
+            /* Link right. */
+            r->left = root;
+            r = root;
+            root = root->left;
+
+        } else {
+            if (root->right == NULL) {
+                break;
+            }
+            /* Zag-zag, rotate left. */
+            if (cmp(x, root->right->x) > 0) {
+                y = root->right;
+                root->right = y->left;
+                y->left = root;
+                root = y;
+                if (root->right == NULL) {
+                    break;
+                }
+            }
+            /* Link left. */
+            l->right = root;
+            l = root;
+            root = root->right;
+        }
     }
-    
-    subtree_free(root->left);
-    subtree_free(root->right);
-    free(root);
+
+    l->right = root->left;
+    r->left = root->right;
+    root->left = header.right;
+    root->right = header.left;
+    return root;
 }
 
-void bstree_free(bstree_t *bstree)
+/**
+ * splay_add - Add an element to a splay tree
+ *
+ * Return 0 if success or duplicated, -1 if failed to alloc memory.
+ *
+ * The new node becomes root, with the old root on one side.
+ */
+static int splay_add(bstree_t bstree, const bstreeElem x)
 {
-    subtree_free((*bstree)->root);
-    free(*bstree);
-    *bstree = NULL;
+    struct entry *root, *e;
+    int res;
+
+    root = splay(bstree->root, x, bstree->cmp);
+    bstree->root = root;
+
+    res = (root != NULL) ? bstree->cmp(x, root->x) : 0;
+    if (root != NULL && res == 0) {
+        return 0;   /* Ignore duplicated value. */
+    }
+
+    e = (struct entry *) mempool_alloc(bstree->pool);
+    if (e == NULL) {
+        return -1;
+    }
+
+    e->x = x;
+    if (root == NULL) {
+        e->left = NULL;
+        e->right = NULL;
+    } else if (res < 0) {
+        e->left = root->left;
+        e->right = root;
+        root->left = NULL;
+    } else {
+        e->right = root->right;
+        e->left = root;
+        root->right = NULL;
+    }
+    bstree->root = e;
+    return 0;
+}
+
+/**
+ * splay_remove - Remove an element from a splay tree
+ *
+ * Return 0 if success, -1 if no such element.
+ *
+ * Splaying x in the left subtree of the removed root brings
+ * up its maximum, which has no right child to lose.
+ */
+static int splay_remove(bstree_t bstree, const bstreeElem x)
+{
+    struct entry *root, *left;
+
+    root = splay(bstree->root, x, bstree->cmp);
+    bstree->root = root;
+
+    if (root == NULL || bstree->cmp(x, root->x) != 0) {
+        return -1;
+    }
+
+    if (root->left == NULL) {
+        bstree->root = root->right;
+    } else {
+        left = splay(root->left, x, bstree->cmp);
+        left->right = root->right;
+        bstree->root = left;
+    }
+    mempool_release(bstree->pool, root);
+    return 0;
 }
 
 /**
@@ -78,11 +249,13 @@ void bstree_free(bstree_t *bstree)
  * @root: the root of sub tree
  * @x: the value
  * @cmp: comparing funciton
+ * @pool: pool of nodes
  *
  * Return 0 if success, -1 otherwise.
  * Return 0 if duplicated.
  */
-static int subtree_add(struct entry **root, const bstreeElem x, comparator cmp)
+static int subtree_add(struct entry **root, const bstreeElem x, comparator cmp,
+        mempool_t pool)
 {
     struct entry *e;
 
@@ -103,7 +276,7 @@ static int subtree_add(struct entry **root, const bstreeElem x, comparator cmp)
 
         /* No match node, create a new one.  */
     } else {
-        e = (struct entry *) malloc(sizeof(*e));
+        e = (struct entry *) mempool_alloc(pool);
         if (!e) {
             return -1;
         } else {
@@ -118,7 +291,10 @@ static int subtree_add(struct entry **root, const bstreeElem x, comparator cmp)
 
 int bstree_add(bstree_t bstree, const bstreeElem x)
 {
-    return subtree_add(&bstree->root, x, bstree->cmp);
+    if (bstree->splay) {
+        return splay_add(bstree, x);
+    }
+    return subtree_add(&bstree->root, x, bstree->cmp, bstree->pool);
 }
 
 /**
@@ -147,6 +323,10 @@ static int subtree_contains(struct entry *root, const bstreeElem x, comparator c
 
 int bstree_contains(bstree_t bstree, const bstreeElem x)
 {
+    if (bstree->splay) {
+        bstree->root = splay(bstree->root, x, bstree->cmp);
+        return bstree->root != NULL && bstree->cmp(x, bstree->root->x) == 0;
+    }
     return subtree_contains(bstree->root, x, bstree->cmp);
 }
 
@@ -154,26 +334,27 @@ int bstree_contains(bstree_t bstree, const bstreeElem x)
  * delete_node - Delete a single node in bstree
  *
  * @node: second rank pointer
+ * @pool: pool of nodes
  *
  * There are 3 different situation to be handled:
  * [1]  Left child is empty.
  * [2]  Right child is empty.
  * [3]  Both exists.
  */
-static void delete_node(struct entry **node) {
+static void delete_node(struct entry **node, mempool_t pool) {
     struct entry *p, *q;
 
     /* [1] */
     if ((*node)->left == NULL) {
         p = *node;
         *node = p->right;
-        free(p);
+        mempool_release(pool, p);
 
      /* [2] */
     } else if ((*node)->right == NULL){
         p = *node;
         *node = p->left;
-        free(p);
+        mempool_release(pool, p);
 
     /* [3] */
     } else {
@@ -205,7 +386,7 @@ static void delete_node(struct entry **node) {
          */
         if (p == *node) {
             p->left = q->left;
-            free(q);
+            mempool_release(pool, q);
 
         /*
          * If left child of current node have left
@@ -224,7 +405,7 @@ static void delete_node(struct entry **node) {
          */
         } else {
             p->right = q->left;
-            free(q);
+            mempool_release(pool, q);
         }
     }
 }
@@ -235,10 +416,12 @@ static void delete_node(struct entry **node) {
  * @root: the root of subtree
  * @x: the value
  * @cmp: comparing function
+ * @pool: pool of nodes
  *
  * Return 0 if success, -1 otherwise.
  */
-static int subtree_remove(struct entry **root, const bstreeElem x, comparator cmp)
+static int subtree_remove(struct entry **root, const bstreeElem x, comparator cmp,
+        mempool_t pool)
 {
     while (*root != NULL && cmp(x, (*root)->x) != 0) {
         /* Turn left */
@@ -252,7 +435,7 @@ static int subtree_remove(struct entry **root, const bstreeElem x, comparator cm
     }
 
     if (*root != NULL) {
-        delete_node(root);
+        delete_node(root, pool);
         return 0;
     } else {
         return -1;
@@ -261,7 +444,75 @@ static int subtree_remove(struct entry **root, const bstreeElem x, comparator cm
 
 int bstree_remove(bstree_t bstree, const bstreeElem x)
 {
-    return subtree_remove(&bstree->root, x, bstree->cmp);
+    if (bstree->splay) {
+        return splay_remove(bstree, x);
+    }
+    return subtree_remove(&bstree->root, x, bstree->cmp, bstree->pool);
+}
+
+int bstree_from_sorted(bstree_t *bstree, bstreeElem const elems[],
+        const size_t n, const comparator cmp)
+{
+    struct entry *nodes, *e;
+    size_t *lo, *len;
+    size_t i, head, tail, half;
+
+    if (bstree_new(bstree, cmp) == -1) {
+        return -1;
+    }
+
+    for (i = 1; i < n; ++i) {
+        if ((*bstree)->cmp(elems[i - 1], elems[i]) >= 0) {
+            bstree_free(bstree);
+            return -1;
+        }
+    }
+
+    if (n == 0) {
+        return 0;
+    }
+
+    nodes = (struct entry *) mempool_alloc_block((*bstree)->pool, n);
+    lo = (size_t *) malloc(n * sizeof(size_t));
+    len = (size_t *) malloc(n * sizeof(size_t));
+    if (nodes == NULL || lo == NULL || len == NULL) {
+        free(lo);
+        free(len);
+        bstree_free(bstree);
+        return -1;
+    }
+
+    /*
+     * Node k takes the middle of elems[lo[k], lo[k] + len[k]),
+     * and children are appended as they are found, which lays
+     * nodes out in breadth-first order.
+     */
+    lo[0] = 0;
+    len[0] = n;
+    tail = 1;
+    for (head = 0; head < n; ++head) {
+        e = &nodes[head];
+        half = len[head] / 2;
+        e->x = elems[lo[head] + half];
+        e->left = NULL;
+        e->right = NULL;
+
+        if (half > 0) {
+            e->left = &nodes[tail];
+            lo[tail] = lo[head];
+            len[tail++] = half;
+        }
+        if (len[head] - half - 1 > 0) {
+            e->right = &nodes[tail];
+            lo[tail] = lo[head] + half + 1;
+            len[tail++] = len[head] - half - 1;
+        }
+    }
+
+    (*bstree)->root = nodes;
+    free(lo);
+    free(len);
+    return 0;
 }
 
 /**
@@ -269,11 +520,15 @@ int bstree_remove(bstree_t bstree, const bstreeElem x)
  */
 static int subtree_get_height(struct entry *root)
 {
+    int left, right;
+
     if (!root)
         return 0;
 
-    return 1 + max(subtree_get_height(root->left),
-            subtree_get_height(root->right));
+    /* max() evaluates its arguments twice, don't recurse in it. */
+    left = subtree_get_height(root->left);
+    right = subtree_get_height(root->right);
+    return 1 + max(left, right);
 }
 
 size_t bstree_get_height(bstree_t bstree)
@@ -286,6 +541,11 @@ int bstree_isempty(bstree_t bstree)
     return bstree->root == NULL;
 }
 
+comparator bstree_get_comparator(bstree_t bstree)
+{
+    return bstree->cmp;
+}
+
 int bstree_get_min(bstree_t bstree, bstreeElem *x)
 {
     struct entry *e;
@@ -320,3 +580,215 @@ int bstree_get_max(bstree_t bstree, bstreeElem *x)
     }
 
 }
+
+int bstree_cursor_new(bstree_cursor_t *cur, bstree_t bstree)
+{
+    bstree_cursor_t new_cur;
+
+    new_cur = (bstree_cursor_t) malloc(sizeof(*new_cur));
+    if (new_cur == NULL) {
+        return -1;
+    }
+
+    new_cur->path = (struct entry **) malloc(DEFAULT_PATH * sizeof(struct entry *));
+    if (new_cur->path == NULL) {
+        free(new_cur);
+        return -1;
+    } else {
+        new_cur->bstree = bstree;
+        new_cur->depth = 0;
+        new_cur->size = DEFAULT_PATH;
+        *cur = new_cur;
+        return 0;
+    }
+}
+
+void bstree_cursor_free(bstree_cursor_t *cur)
+{
+    free((*cur)->path);
+    free(*cur);
+    *cur = NULL;
+}
+
+/**
+ * push - Push a node on path of cursor
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ */
+static int push(bstree_cursor_t cur, struct entry *e)
+{
+    struct entry **new_path;
+
+    if (cur->depth == cur->size) {
+        new_path = (struct entry **) realloc(cur->path,
+                2 * cur->size * sizeof(struct entry *));
+        if (new_path == NULL) {
+            return -1;
+        }
+        cur->path = new_path;
+        cur->size *= 2;
+    }
+    cur->path[cur->depth++] = e;
+    return 0;
+}
+
+/**
+ * get_current - Output element under cursor
+ *
+ * Return 0 if cursor points to an element, -1 otherwise.
+ */
+static int get_current(bstree_cursor_t cur, bstreeElem *x)
+{
+    if (cur->depth == 0) {
+        return -1;
+    } else {
+        *x = cur->path[cur->depth - 1]->x;
+        return 0;
+    }
+}
+
+/**
+ * push_edge - Push e and its leftmost (or rightmost) descendants
+ *
+ * Return 0 if success, -1 if failed to alloc memory,
+ * and then cursor points to nothing.
+ */
+static int push_edge(bstree_cursor_t cur, struct entry *e, const int left)
+{
+    while (e != NULL) {
+        if (push(cur, e) == -1) {
+            cur->depth = 0;
+            return -1;
+        }
+        e = left ? e->left : e->right;
+    }
+    return 0;
+}
+
+int bstree_cursor_first(bstree_cursor_t cur, bstreeElem *x)
+{
+    cur->depth = 0;
+    push_edge(cur, cur->bstree->root, 1);
+    return get_current(cur, x);
+}
+
+int bstree_cursor_last(bstree_cursor_t cur, bstreeElem *x)
+{
+    cur->depth = 0;
+    push_edge(cur, cur->bstree->root, 0);
+    return get_current(cur, x);
+}
+
+/**
+ * seek - Point cursor to the first element >= x, or > x if strict
+ *
+ * The answer is the deepest node where the descent turned left,
+ * so the path is cut right below it.
+ */
+static int seek(bstree_cursor_t cur, const bstreeElem x,
+        const int strict, bstreeElem *y)
+{
+    struct entry *e;
+    comparator cmp;
+    size_t found;
+    int res;
+
+    cmp = cur->bstree->cmp;
+    e = cur->bstree->root;
+    cur->depth = 0;
+    found = 0;
+
+    while (e != NULL) {
+        if (push(cur, e) == -1) {
+            found = 0;
+            break;
+        }
+        res = cmp(x, e->x);
+        if (res == 0 && !strict) {
+            found = cur->depth;
+            break;
+        } else if (res < 0) {
+            found = cur->depth;
+            e = e->left;
+        } else {
+            e = e->right;
+        }
+    }
+
+    cur->depth = found;
+    return get_current(cur, y);
+}
+
+int bstree_lower_bound(bstree_cursor_t cur, const bstreeElem x, bstreeElem *y)
+{
+    return seek(cur, x, 0, y);
+}
+
+int bstree_upper_bound(bstree_cursor_t cur, const bstreeElem x, bstreeElem *y)
+{
+    return seek(cur, x, 1, y);
+}
+
+/**
+ * step - Move cursor to in-order successor, or precursor if !forward
+ */
+static int step(bstree_cursor_t cur, const int forward, bstreeElem *y)
+{
+    struct entry *e, *child;
+
+    if (cur->depth == 0) {
+        return -1;
+    }
+
+    e = cur->path[cur->depth - 1];
+    child = forward ? e->right : e->left;
+
+    if (child != NULL) {
+        push_edge(cur, child, forward);
+
+    } else {
+        /* Go up until we come from the proper side. */
+        do {
+            child = cur->path[--cur->depth];
+        } while (cur->depth > 0 && child == (forward
+                    ? cur->path[cur->depth - 1]->right
+                    : cur->path[cur->depth - 1]->left));
+    }
+    return get_current(cur, y);
+}
+
+int bstree_next(bstree_cursor_t cur, bstreeElem *y)
+{
+    return step(cur, 1, y);
+}
+
+int bstree_prev(bstree_cursor_t cur, bstreeElem *y)
+{
+    return step(cur, 0, y);
+}
+
+size_t bstree_range_scan(bstree_t bstree, const bstreeElem lo,
+        const bstreeElem hi, bstree_visitor visit, void *arg)
+{
+    bstree_cursor_t cur;
+    bstreeElem x;
+    size_t count;
+    int res;
+
+    if (bstree_cursor_new(&cur, bstree) == -1) {
+        return 0;
+    }
+
+    count = 0;
+    res = seek(cur, lo, 0, &x);
+    while (res == 0 && bstree->cmp(x, hi) <= 0) {
+        count++;
+        if (visit(x, arg) != 0) {
+            break;
+        }
+        res = step(cur, 1, &x);
+    }
+
+    bstree_cursor_free(&cur);
+    return count;
+}
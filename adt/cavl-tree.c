@@ -0,0 +1,978 @@
+/*
+ * cavl-tree.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <sched.h>
+#include "cavl-tree.h"
+#include "ebr.h"
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+/*
+ * The tree follows Bronson et al., "A Practical Concurrent
+ * Binary Search Tree".
+ *
+ * Every node has a version. A rotation that moves a node down
+ * marks it shrinking while it runs, and bumps the version when
+ * done. Readers note the version of a node before following a
+ * link out of it, and check it again after: a change means the
+ * node lost part of its subtree, and they step back to its
+ * parent. Nodes never shrink without a version change.
+ *
+ * Removing a node with two children only clears its present
+ * flag, the node stays as a routing node, and is unlinked
+ * later when it has one child at most.
+ *
+ * Unlike the paper, fixing heights after an update goes on up
+ * to the root: a rotation that leaves work below it returns
+ * there first, and the height of its parent may still be off.
+ *
+ * Locks are always taken from parent to child. Unlinked nodes
+ * are freed through epoch based reclamation, since readers may
+ * still be on them.
+ */
+#define CACHE_LINE  64
+
+#define UNLINKED    1UL
+#define SHRINKING   2UL
+#define CHANGE      4UL     /* version step of a completed change */
+
+#define L   0
+#define R   1
+
+/* Results of node_condition(), or else a new height. */
+#define UNLINK_REQUIRED     -1
+#define REBALANCE_REQUIRED  -2
+#define NOTHING_REQUIRED    -3
+
+/* Results of attempts. */
+enum result {
+    ABSENT,
+    FOUND,
+    RETRY,
+    NOMEM,
+};
+
+/* Bounded spinning before blocking on the lock of a shrinking node. */
+#define SPINS   100
+
+#define LOAD(p)         __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define STORE(p, v)     __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+struct node {
+    struct ebr_node retired;    /* first, for reclaim() */
+    cavltreeElem x;
+    unsigned long version;
+    int height;
+    int present;                /* 0 for a routing node */
+    int lock;
+    struct node *parent;
+    struct node *child[2];
+};
+
+struct _cavltree {
+    struct node holder;     /* root is holder.child[R] */
+    ebr_t ebr;
+    comparator cmp;
+
+    /* Written by each add and remove, kept off the line of holder. */
+    size_t size __attribute__((aligned(CACHE_LINE)));
+};
+
+static void reclaim(struct ebr_node *e)
+{
+    free(e);
+}
+
+static void lock(struct node *n)
+{
+    while (__atomic_exchange_n(&n->lock, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&n->lock, __ATOMIC_RELAXED)) {
+            sched_yield();
+        }
+    }
+}
+
+static void unlock(struct node *n)
+{
+    __atomic_store_n(&n->lock, 0, __ATOMIC_RELEASE);
+}
+
+static int shrinking_or_unlinked(const unsigned long version)
+{
+    return (version & (SHRINKING | UNLINKED)) != 0;
+}
+
+/*
+ * begin_change - Mark a locked node as shrinking before relinking it
+ */
+static void begin_change(struct node *n, const unsigned long ovl)
+{
+    STORE(n->version, ovl | SHRINKING);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void end_change(struct node *n, const unsigned long ovl)
+{
+    STORE(n->version, ovl + CHANGE);
+}
+
+/*
+ * wait_shrink - Wait until a rotation of n is over
+ *
+ * The rotating thread holds the lock of n.
+ */
+static void wait_shrink(struct node *n, const unsigned long ovl)
+{
+    int i;
+
+    if (ovl & SHRINKING) {
+        for (i = 0; i < SPINS && LOAD(n->version) == ovl; ++i) {
+            sched_yield();
+        }
+        if (LOAD(n->version) == ovl) {
+            lock(n);
+            unlock(n);
+        }
+    }
+}
+
+static int height(struct node *n)
+{
+    return (n == NULL) ? 0 : LOAD(n->height);
+}
+
+static struct node *new_node(const cavltreeElem x)
+{
+    struct node *n;
+
+    n = (struct node *) malloc(sizeof(*n));
+    if (n != NULL) {
+        n->x = x;
+        n->version = 0;
+        n->height = 1;
+        n->present = 1;
+        n->lock = 0;
+        n->parent = NULL;
+        n->child[L] = NULL;
+        n->child[R] = NULL;
+    }
+    return n;
+}
+
+int cavltree_new(cavltree_t *cavl, const comparator cmp)
+{
+    cavltree_t new_cavl;
+
+    if (posix_memalign((void **) &new_cavl, CACHE_LINE,
+            sizeof(*new_cavl)) != 0) {
+        return -1;
+
+    } else if (ebr_new(&new_cavl->ebr, reclaim) == -1) {
+        free(new_cavl);
+        return -1;
+
+    } else {
+        new_cavl->holder.x = NULL;
+        new_cavl->holder.version = 0;
+        new_cavl->holder.height = 0;
+        new_cavl->holder.present = 0;
+        new_cavl->holder.lock = 0;
+        new_cavl->holder.parent = NULL;
+        new_cavl->holder.child[L] = NULL;
+        new_cavl->holder.child[R] = NULL;
+        new_cavl->cmp = (cmp != NULL) ? cmp : cmp_int;
+        new_cavl->size = 0;
+        *cavl = new_cavl;
+        return 0;
+    }
+}
+
+static void free_nodes(struct node *n)
+{
+    if (n != NULL) {
+        free_nodes(n->child[L]);
+        free_nodes(n->child[R]);
+        free(n);
+    }
+}
+
+void cavltree_free(cavltree_t *cavl)
+{
+    free_nodes((*cavl)->holder.child[R]);
+    ebr_free(&(*cavl)->ebr);
+    free(*cavl);
+    *cavl = NULL;
+}
+
+/*
+ * attempt_get - Look for x below node
+ *
+ * @cavl: the cavltree
+ * @x: the element
+ * @node: node whose version was ovl, x is on side dir of it
+ *
+ * Return FOUND, ABSENT, or RETRY if node changed meanwhile.
+ */
+static enum result attempt_get(cavltree_t cavl, const void *x,
+        struct node *node, const int dir, const unsigned long ovl)
+{
+    struct node *child;
+    unsigned long child_ovl;
+    enum result res;
+    int c;
+
+    while (1) {
+        child = LOAD(node->child[dir]);
+        if (child == NULL) {
+            return (LOAD(node->version) != ovl) ? RETRY : ABSENT;
+        }
+
+        c = cavl->cmp(x, child->x);
+        if (c == 0) {
+            return LOAD(child->present) ? FOUND : ABSENT;
+        }
+
+        child_ovl = LOAD(child->version);
+        if (shrinking_or_unlinked(child_ovl)) {
+            wait_shrink(child, child_ovl);
+            if (LOAD(node->version) != ovl) {
+                return RETRY;
+            }
+        } else if (child != LOAD(node->child[dir])) {
+            if (LOAD(node->version) != ovl) {
+                return RETRY;
+            }
+        } else {
+            if (LOAD(node->version) != ovl) {
+                return RETRY;
+            }
+            res = attempt_get(cavl, x, child, c > 0, child_ovl);
+            if (res != RETRY) {
+                return res;
+            }
+        }
+    }
+}
+
+int cavltree_contains(cavltree_t cavl, const cavltreeElem x)
+{
+    struct node *right;
+    unsigned long ovl;
+    enum result res;
+    int c;
+
+    if (ebr_enter(cavl->ebr) == -1) {
+        return -1;
+    }
+
+    res = RETRY;
+    while (res == RETRY) {
+        right = LOAD(cavl->holder.child[R]);
+        if (right == NULL) {
+            res = ABSENT;
+            break;
+        }
+
+        c = cavl->cmp(x, right->x);
+        if (c == 0) {
+            res = LOAD(right->present) ? FOUND : ABSENT;
+            break;
+        }
+
+        ovl = LOAD(right->version);
+        if (shrinking_or_unlinked(ovl)) {
+            wait_shrink(right, ovl);
+        } else if (right == LOAD(cavl->holder.child[R])) {
+            res = attempt_get(cavl, x, right, c > 0, ovl);
+        }
+    }
+
+    ebr_exit(cavl->ebr);
+    return res == FOUND;
+}
+
+/*
+ * node_condition - Tell what a node needs
+ *
+ * Return UNLINK_REQUIRED for a routing node with one child at
+ * most, REBALANCE_REQUIRED, NOTHING_REQUIRED, or else the new
+ * height of the node.
+ */
+static int node_condition(struct node *n)
+{
+    struct node *nl, *nr;
+    int hn, hl, hr, repl, bal;
+
+    nl = LOAD(n->child[L]);
+    nr = LOAD(n->child[R]);
+    if ((nl == NULL || nr == NULL) && !LOAD(n->present)) {
+        return UNLINK_REQUIRED;
+    }
+
+    hn = LOAD(n->height);
+    hl = height(nl);
+    hr = height(nr);
+    repl = 1 + max(hl, hr);
+    bal = hl - hr;
+
+    if (bal < -1 || bal > 1) {
+        return REBALANCE_REQUIRED;
+    }
+    return (hn != repl) ? repl : NOTHING_REQUIRED;
+}
+
+/*
+ * fix_height_nl - Fix height of a locked node
+ *
+ * Return the next node to look at.
+ */
+static struct node *fix_height_nl(struct node *n)
+{
+    int c;
+
+    c = node_condition(n);
+    switch (c) {
+    case REBALANCE_REQUIRED:
+    case UNLINK_REQUIRED:
+        return n;
+    case NOTHING_REQUIRED:
+        return LOAD(n->parent);
+    default:
+        STORE(n->height, c);
+        return LOAD(n->parent);
+    }
+}
+
+/*
+ * attempt_unlink_nl - Unlink a locked routing node under locked parent
+ *
+ * Return non-zero if unlinked.
+ */
+static int attempt_unlink_nl(cavltree_t cavl, struct node *parent,
+        struct node *n)
+{
+    struct node *nl, *nr, *splice;
+    int dir;
+
+    if (LOAD(parent->child[L]) == n) {
+        dir = L;
+    } else if (LOAD(parent->child[R]) == n) {
+        dir = R;
+    } else {
+        return 0;
+    }
+
+    nl = LOAD(n->child[L]);
+    nr = LOAD(n->child[R]);
+    if (nl != NULL && nr != NULL) {
+        return 0;
+    }
+
+    splice = (nl != NULL) ? nl : nr;
+    STORE(parent->child[dir], splice);
+    if (splice != NULL) {
+        STORE(splice->parent, parent);
+    }
+    STORE(n->version, UNLINKED);
+    ebr_retire(cavl->ebr, &n->retired);
+    return 1;
+}
+
+/*
+ * rotate_nl - Single rotation of n, its child nd on side d goes up
+ *
+ * Heights passed in are those read under the locks held, nParent,
+ * n and nd are locked. Return the next node to look at.
+ *
+ * Schema for d = L, a right rotation:
+ *        n                 nd
+ *       / \               /  \
+ *     nd   e     ==>    ndd   n
+ *    /  \                    / \
+ *  ndd  nde                nde  e
+ */
+static struct node *rotate_nl(struct node *parent, struct node *n,
+        struct node *nd, const int he, const int hdd, struct node *nde,
+        const int hde, const int d)
+{
+    unsigned long ovl;
+    int e, repl, bal;
+
+    e = !d;
+    ovl = LOAD(n->version);
+    begin_change(n, ovl);
+
+    STORE(n->child[d], nde);
+    if (nde != NULL) {
+        STORE(nde->parent, n);
+    }
+    STORE(nd->child[e], n);
+    STORE(n->parent, nd);
+    if (LOAD(parent->child[L]) == n) {
+        STORE(parent->child[L], nd);
+    } else {
+        STORE(parent->child[R], nd);
+    }
+    STORE(nd->parent, parent);
+
+    repl = 1 + max(hde, he);
+    STORE(n->height, repl);
+    STORE(nd->height, 1 + max(hdd, repl));
+
+    end_change(n, ovl);
+
+    /* Look further down if n or nd needs more work. */
+    bal = hde - he;
+    if (bal < -1 || bal > 1) {
+        return n;
+    } else if ((nde == NULL || he == 0) && !LOAD(n->present)) {
+        return n;
+    }
+    bal = hdd - repl;
+    if (bal < -1 || bal > 1) {
+        return nd;
+    } else if (hdd == 0 && !LOAD(nd->present)) {
+        return nd;
+    }
+    return fix_height_nl(parent);
+}
+
+/*
+ * rotate_over_nl - Double rotation, grandchild nde of n goes up
+ *
+ * parent, n, nd and nde are locked. If nd is a routing node
+ * left with one child, it is unlinked at once: nothing on the
+ * way up from n would find it later.
+ *
+ * Schema for d = L:
+ *        n                    nde
+ *       / \                 /     \
+ *     nd   e     ==>      nd       n
+ *    /  \                /  \     / \
+ *  ndd  nde            ndd  nded ndee e
+ *       /  \
+ *    nded  ndee
+ */
+static struct node *rotate_over_nl(cavltree_t cavl, struct node *parent,
+        struct node *n, struct node *nd, const int he, const int hdd,
+        struct node *nde, const int hded, const int d)
+{
+    struct node *nded, *ndee;
+    unsigned long ovl, dovl;
+    int e, hdee, nrepl, drepl, bal;
+
+    e = !d;
+    ovl = LOAD(n->version);
+    dovl = LOAD(nd->version);
+    nded = LOAD(nde->child[d]);
+    ndee = LOAD(nde->child[e]);
+    hdee = height(ndee);
+
+    begin_change(n, ovl);
+    begin_change(nd, dovl);
+
+    STORE(n->child[d], ndee);
+    if (ndee != NULL) {
+        STORE(ndee->parent, n);
+    }
+    STORE(nd->child[e], nded);
+    if (nded != NULL) {
+        STORE(nded->parent, nd);
+    }
+    STORE(nde->child[d], nd);
+    STORE(nd->parent, nde);
+    STORE(nde->child[e], n);
+    STORE(n->parent, nde);
+    if (LOAD(parent->child[L]) == n) {
+        STORE(parent->child[L], nde);
+    } else {
+        STORE(parent->child[R], nde);
+    }
+    STORE(nde->parent, parent);
+
+    nrepl = 1 + max(hdee, he);
+    STORE(n->height, nrepl);
+    drepl = 1 + max(hdd, hded);
+    STORE(nd->height, drepl);
+
+    end_change(n, ovl);
+    end_change(nd, dovl);
+
+    if ((hdd == 0 || hded == 0) && !LOAD(nd->present)) {
+        attempt_unlink_nl(cavl, nde, nd);
+        drepl = max(hdd, hded);
+    }
+    STORE(nde->height, 1 + max(drepl, nrepl));
+
+    bal = hdee - he;
+    if (bal < -1 || bal > 1) {
+        return n;
+    } else if ((ndee == NULL || he == 0) && !LOAD(n->present)) {
+        return n;
+    }
+    bal = drepl - nrepl;
+    if (bal < -1 || bal > 1) {
+        return nde;
+    }
+    return fix_height_nl(parent);
+}
+
+/*
+ * rebalance_to_nl - Move height from side d of n, child nd, to the other
+ *
+ * parent and n are locked, he is the height of the other side.
+ * Return the next node to look at.
+ */
+static struct node *rebalance_to_nl(cavltree_t cavl, struct node *parent,
+        struct node *n, struct node *nd, const int he, const int d)
+{
+    struct node *nde, *next;
+    int e, hd, hdd, hde, hded, bal;
+
+    e = !d;
+    lock(nd);
+
+    hd = LOAD(nd->height);
+    if (hd - he <= 1) {
+        unlock(nd);
+        return n;   /* Retry. */
+    }
+
+    nde = LOAD(nd->child[e]);
+    hdd = height(LOAD(nd->child[d]));
+    hde = height(nde);
+    if (hdd >= hde) {
+        next = rotate_nl(parent, n, nd, he, hdd, nde, hde, d);
+        unlock(nd);
+        return next;
+    }
+
+    lock(nde);
+    hde = LOAD(nde->height);
+    if (hdd >= hde) {
+        next = rotate_nl(parent, n, nd, he, hdd, nde, hde, d);
+        unlock(nde);
+        unlock(nd);
+        return next;
+    }
+
+    hded = height(LOAD(nde->child[d]));
+    bal = hdd - hded;
+    if (bal >= -1 && bal <= 1) {
+        next = rotate_over_nl(cavl, parent, n, nd, he, hdd, nde, hded, d);
+        unlock(nde);
+        unlock(nd);
+        return next;
+    }
+    unlock(nde);
+
+    /* nd itself leans the other way too much, fix it first. */
+    next = rebalance_to_nl(cavl, n, nd, nde, hdd, e);
+    unlock(nd);
+    return next;
+}
+
+/*
+ * rebalance_nl - Unlink, rotate or fix height of locked n
+ *
+ * Return the next node to look at.
+ */
+static struct node *rebalance_nl(cavltree_t cavl, struct node *parent,
+        struct node *n)
+{
+    struct node *nl, *nr;
+    int hn, hl, hr, repl, bal;
+
+    nl = LOAD(n->child[L]);
+    nr = LOAD(n->child[R]);
+    if ((nl == NULL || nr == NULL) && !LOAD(n->present)) {
+        if (attempt_unlink_nl(cavl, parent, n)) {
+            return fix_height_nl(parent);
+        } else {
+            return n;
+        }
+    }
+
+    hn = LOAD(n->height);
+    hl = height(nl);
+    hr = height(nr);
+    repl = 1 + max(hl, hr);
+    bal = hl - hr;
+
+    if (bal > 1) {
+        return rebalance_to_nl(cavl, parent, n, nl, hr, L);
+    } else if (bal < -1) {
+        return rebalance_to_nl(cavl, parent, n, nr, hl, R);
+    } else if (repl != hn) {
+        STORE(n->height, repl);
+        return fix_height_nl(parent);
+    } else {
+        return parent;
+    }
+}
+
+/*
+ * fix_and_rebalance - Walk up from a changed node, fixing what is off
+ */
+static void fix_and_rebalance(cavltree_t cavl, struct node *n)
+{
+    struct node *parent, *next;
+    int c;
+
+    while (n != NULL && LOAD(n->parent) != NULL) {
+        c = node_condition(n);
+        if (LOAD(n->version) & UNLINKED) {
+            return;
+        }
+
+        if (c == NOTHING_REQUIRED) {
+            next = LOAD(n->parent);
+        } else if (c != UNLINK_REQUIRED && c != REBALANCE_REQUIRED) {
+            lock(n);
+            next = fix_height_nl(n);
+            unlock(n);
+        } else {
+            parent = LOAD(n->parent);
+            next = n;
+            lock(parent);
+            if (!(LOAD(parent->version) & UNLINKED) && LOAD(n->parent) == parent) {
+                lock(n);
+                next = rebalance_nl(cavl, parent, n);
+                unlock(n);
+            }
+            unlock(parent);
+        }
+        n = next;
+    }
+}
+
+/*
+ * attempt_add_node - Make node present, it matches x
+ */
+static enum result attempt_add_node(cavltree_t cavl, struct node *node)
+{
+    if (LOAD(node->present)) {
+        return FOUND;
+    }
+
+    lock(node);
+    if (LOAD(node->version) & UNLINKED) {
+        unlock(node);
+        return RETRY;
+    } else if (LOAD(node->present)) {
+        unlock(node);
+        return FOUND;
+    }
+    STORE(node->present, 1);
+    unlock(node);
+
+    __atomic_add_fetch(&cavl->size, 1, __ATOMIC_RELAXED);
+    return ABSENT;
+}
+
+/*
+ * attempt_remove_node - Remove node under parent, it matches x
+ *
+ * A node with one child at most is unlinked right away,
+ * one with two children becomes a routing node.
+ */
+static enum result attempt_remove_node(cavltree_t cavl, struct node *parent,
+        struct node *node)
+{
+    struct node *damaged;
+
+    if (!LOAD(node->present)) {
+        return ABSENT;
+    }
+
+    if (LOAD(node->child[L]) == NULL || LOAD(node->child[R]) == NULL) {
+        lock(parent);
+        if ((LOAD(parent->version) & UNLINKED) || LOAD(node->parent) != parent) {
+            unlock(parent);
+            return RETRY;
+        }
+        lock(node);
+        if (LOAD(node->version) & UNLINKED) {
+            unlock(node);
+            unlock(parent);
+            return RETRY;
+        } else if (!LOAD(node->present)) {
+            unlock(node);
+            unlock(parent);
+            return ABSENT;
+        }
+        STORE(node->present, 0);
+        damaged = attempt_unlink_nl(cavl, parent, node) ? parent : NULL;
+        unlock(node);
+        unlock(parent);
+
+    } else {
+        lock(node);
+        if (LOAD(node->version) & UNLINKED) {
+            unlock(node);
+            return RETRY;
+        } else if (!LOAD(node->present)) {
+            unlock(node);
+            return ABSENT;
+        }
+        STORE(node->present, 0);
+        unlock(node);
+
+        /* A child may have gone meanwhile. */
+        damaged = node;
+    }
+
+    __atomic_sub_fetch(&cavl->size, 1, __ATOMIC_RELAXED);
+    fix_and_rebalance(cavl, damaged);
+    return FOUND;
+}
+
+/*
+ * attempt_update - Add or remove x at or below node
+ *
+ * @cavl: the cavltree
+ * @x: the element
+ * @add: non-zero to add, 0 to remove
+ * @spare: a new node for x, NULL when removing
+ * @parent: parent of node
+ * @node: node whose version was ovl
+ *
+ * Return FOUND if x was there, ABSENT if not, or RETRY if
+ * node changed meanwhile. *spare is set to NULL once used.
+ */
+static enum result attempt_update(cavltree_t cavl, const void *x,
+        const int add, struct node **spare, struct node *parent,
+        struct node *node, const unsigned long ovl)
+{
+    struct node *child;
+    unsigned long child_ovl;
+    enum result res;
+    int c, dir;
+
+    c = cavl->cmp(x, node->x);
+    if (c == 0) {
+        return add ? attempt_add_node(cavl, node)
+            : attempt_remove_node(cavl, parent, node);
+    }
+    dir = c > 0;
+
+    while (1) {
+        child = LOAD(node->child[dir]);
+        if (LOAD(node->version) != ovl) {
+            return RETRY;
+        }
+
+        if (child == NULL) {
+            if (!add) {
+                return ABSENT;
+            }
+            lock(node);
+            if (LOAD(node->version) != ovl) {
+                unlock(node);
+                return RETRY;
+            } else if (LOAD(node->child[dir]) != NULL) {
+                unlock(node);
+                continue;
+            }
+            (*spare)->parent = node;
+            STORE(node->child[dir], *spare);
+            *spare = NULL;
+            unlock(node);
+
+            __atomic_add_fetch(&cavl->size, 1, __ATOMIC_RELAXED);
+            fix_and_rebalance(cavl, node);
+            return ABSENT;
+        }
+
+        child_ovl = LOAD(child->version);
+        if (shrinking_or_unlinked(child_ovl)) {
+            wait_shrink(child, child_ovl);
+        } else if (child == LOAD(node->child[dir])) {
+            if (LOAD(node->version) != ovl) {
+                return RETRY;
+            }
+            res = attempt_update(cavl, x, add, spare, node, child, child_ovl);
+            if (res != RETRY) {
+                return res;
+            }
+        }
+    }
+}
+
+/*
+ * update - Add or remove x
+ *
+ * Return FOUND if x was there, ABSENT if not, NOMEM if
+ * failed to alloc memory.
+ */
+static enum result update(cavltree_t cavl, const void *x, const int add)
+{
+    struct node *holder, *right, *spare;
+    unsigned long ovl;
+    enum result res;
+
+    /* Alloc before taking any lock, and free if not used. */
+    spare = NULL;
+    if (add) {
+        spare = new_node((cavltreeElem) x);
+        if (spare == NULL) {
+            return NOMEM;
+        }
+    }
+
+    if (ebr_enter(cavl->ebr) == -1) {
+        free(spare);
+        return NOMEM;
+    }
+
+    holder = &cavl->holder;
+    res = RETRY;
+    while (res == RETRY) {
+        right = LOAD(holder->child[R]);
+        if (right == NULL) {
+            if (!add) {
+                res = ABSENT;
+                break;
+            }
+            lock(holder);
+            if (LOAD(holder->child[R]) == NULL) {
+                spare->parent = holder;
+                STORE(holder->child[R], spare);
+                spare = NULL;
+                res = ABSENT;
+                __atomic_add_fetch(&cavl->size, 1, __ATOMIC_RELAXED);
+            }
+            unlock(holder);
+            continue;
+        }
+
+        ovl = LOAD(right->version);
+        if (shrinking_or_unlinked(ovl)) {
+            wait_shrink(right, ovl);
+        } else if (right == LOAD(holder->child[R])) {
+            res = attempt_update(cavl, x, add, &spare, holder, right, ovl);
+        }
+    }
+
+    ebr_exit(cavl->ebr);
+    free(spare);
+    return res;
+}
+
+int cavltree_add(cavltree_t cavl, const cavltreeElem x)
+{
+    return (update(cavl, x, 1) == NOMEM) ? -1 : 0;
+}
+
+int cavltree_remove(cavltree_t cavl, const cavltreeElem x)
+{
+    return (update(cavl, x, 0) == FOUND) ? 0 : -1;
+}
+
+/*
+ * attempt_edge - Find the first present element below node toward side d
+ *
+ * @node: node whose version was ovl
+ * @d: L for the minimum, R for the maximum
+ * @x: output element
+ *
+ * Return FOUND, ABSENT if the subtree holds routing nodes only,
+ * or RETRY if node changed meanwhile.
+ */
+static enum result attempt_edge(struct node *node, const unsigned long ovl,
+        const int d, cavltreeElem *x)
+{
+    struct node *child;
+    unsigned long child_ovl;
+    enum result res;
+    int side;
+
+    /* Near side first, then node itself, then far side. */
+    for (side = d; ; side = !d) {
+        res = RETRY;
+        while (res == RETRY) {
+            child = LOAD(node->child[side]);
+            if (LOAD(node->version) != ovl) {
+                return RETRY;
+            } else if (child == NULL) {
+                res = ABSENT;
+                break;
+            }
+
+            child_ovl = LOAD(child->version);
+            if (shrinking_or_unlinked(child_ovl)) {
+                wait_shrink(child, child_ovl);
+            } else if (child == LOAD(node->child[side])) {
+                if (LOAD(node->version) != ovl) {
+                    return RETRY;
+                }
+                res = attempt_edge(child, child_ovl, d, x);
+            }
+        }
+
+        if (res == FOUND || side != d) {
+            return res;
+        } else if (LOAD(node->present)) {
+            *x = node->x;
+            return FOUND;
+        }
+    }
+}
+
+/*
+ * get_edge - Get the minimum (d = L) or maximum (d = R)
+ */
+static int get_edge(cavltree_t cavl, const int d, cavltreeElem *x)
+{
+    struct node *holder;
+    enum result res;
+
+    if (ebr_enter(cavl->ebr) == -1) {
+        return -1;
+    }
+
+    /* The holder never changes version, nor holds an element. */
+    holder = &cavl->holder;
+    do {
+        res = attempt_edge(holder, LOAD(holder->version), d, x);
+    } while (res == RETRY);
+
+    ebr_exit(cavl->ebr);
+    return (res == FOUND) ? 0 : -1;
+}
+
+int cavltree_get_min(cavltree_t cavl, cavltreeElem *x)
+{
+    return get_edge(cavl, L, x);
+}
+
+int cavltree_get_max(cavltree_t cavl, cavltreeElem *x)
+{
+    return get_edge(cavl, R, x);
+}
+
+size_t cavltree_get_size(cavltree_t cavl)
+{
+    return __atomic_load_n(&cavl->size, __ATOMIC_RELAXED);
+}
+
+int cavltree_isempty(cavltree_t cavl)
+{
+    return cavltree_get_size(cavl) == 0;
+}
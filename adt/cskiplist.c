@@ -0,0 +1,469 @@
+/*
+ * cskiplist.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "cskiplist.h"
+#include "ebr.h"
+
+/*
+ * The list follows Fraser, and Herlihy and Shavit.
+ *
+ * The lowest bit of a link marks its node as removed at that
+ * level. A marked link never changes again, and a node is in
+ * the set while its link at level 0 is unmarked. Removal marks
+ * the links from the top down, then any thread passing by
+ * unlinks the node, at each level on its own.
+ *
+ * A node may be linked at an upper level by its adder after the
+ * remover is done with it, so the two of them agree through the
+ * state of the node on who unlinks it last and retires it.
+ */
+#define CACHE_LINE  64
+#define MAX_LEVEL   32
+#define SHIFT       2       /* p = 1/4 */
+
+#define MARK        ((uintptr_t) 1)
+#define PTR(v)      ((struct node *) ((v) & ~MARK))
+#define MARKED(v)   (((v) & MARK) != 0)
+
+#define LOAD(p)     __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define CAS(p, o, n) __atomic_compare_exchange_n(&(p), &(o), (n), \
+        0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+/* Node state. */
+#define LINKING     1       /* adder still links upper levels */
+#define REMOVED     2       /* remover is done marking */
+
+enum result {
+    ABSENT,
+    FOUND,
+    RETRY,
+};
+
+struct node {
+    struct ebr_node retired;    /* first, for reclaim() */
+    cskiplistElem x;
+    int level;
+    int state;
+    uintptr_t next[];
+};
+
+struct _cskiplist {
+    struct node *head;
+    ebr_t ebr;
+    comparator cmp;
+    int levels;             /* Levels in use, only grows. */
+
+    /*
+     * Every add and remove bumps the count, so it gets a line
+     * of its own, away from the fields each search reads.
+     */
+    size_t size __attribute__((aligned(CACHE_LINE)));
+};
+
+static void reclaim(struct ebr_node *e)
+{
+    free(e);
+}
+
+/*
+ * get_level - Draw level of a new node
+ *
+ * Each thread has its own xorshift state, and takes SHIFT zero
+ * bits in a row of a random word per level.
+ */
+static int get_level(void)
+{
+    static unsigned long counter = 0;
+    static __thread unsigned long seed = 0;
+    unsigned long r;
+    int level;
+
+    if (seed == 0) {
+        /* splitmix64 of a shared counter. */
+        r = __atomic_add_fetch(&counter, 0x9e3779b97f4a7c15UL, __ATOMIC_RELAXED);
+        r = (r ^ (r >> 30)) * 0xbf58476d1ce4e5b9UL;
+        r = (r ^ (r >> 27)) * 0x94d049bb133111ebUL;
+        seed = (r ^ (r >> 31)) | 1;
+    }
+
+    r = seed;
+    r ^= r << 13;
+    r ^= r >> 7;
+    r ^= r << 17;
+    seed = r;
+
+    level = 1 + __builtin_ctzl(r) / SHIFT;
+    return level < MAX_LEVEL ? level : MAX_LEVEL;
+}
+
+static struct node *new_node(const cskiplistElem x, const int level)
+{
+    struct node *n;
+
+    n = (struct node *) malloc(sizeof(*n) + level * sizeof(n->next[0]));
+    if (n != NULL) {
+        n->x = x;
+        n->level = level;
+        n->state = (level > 1) ? LINKING : 0;
+    }
+    return n;
+}
+
+int cskiplist_new(cskiplist_t *cs, const comparator cmp)
+{
+    cskiplist_t new_cs;
+    int i;
+
+    if (posix_memalign((void **) &new_cs, CACHE_LINE, sizeof(*new_cs)) != 0) {
+        return -1;
+
+    } else if ((new_cs->head = new_node(NULL, MAX_LEVEL)) == NULL) {
+        free(new_cs);
+        return -1;
+
+    } else if (ebr_new(&new_cs->ebr, reclaim) == -1) {
+        free(new_cs->head);
+        free(new_cs);
+        return -1;
+
+    } else {
+        for (i = 0; i < MAX_LEVEL; ++i) {
+            new_cs->head->next[i] = 0;
+        }
+        new_cs->cmp = (cmp != NULL) ? cmp : cmp_int;
+        new_cs->levels = 1;
+        new_cs->size = 0;
+        *cs = new_cs;
+        return 0;
+    }
+}
+
+void cskiplist_free(cskiplist_t *cs)
+{
+    struct node *n, *next;
+
+    /* Removed nodes are all in ebr by now. */
+    n = (*cs)->head;
+    while (n != NULL) {
+        next = PTR(n->next[0]);
+        free(n);
+        n = next;
+    }
+    ebr_free(&(*cs)->ebr);
+    free(*cs);
+    *cs = NULL;
+}
+
+/*
+ * attempt_find - Find prev and next nodes of x at every level
+ *
+ * @cs: the cskiplist
+ * @x: the element
+ * @preds: output prev nodes
+ * @succs: output next nodes, NULL at the end
+ * @target: node to unlink, or NULL
+ *
+ * Return FOUND if succs[0] holds x, ABSENT if not, or RETRY
+ * if another thread changed a link under us.
+ *
+ * Marked nodes on the way are unlinked. With a target, nodes
+ * equal to x are passed too until target is, so the target is
+ * unlinked at each level it was in.
+ */
+static enum result attempt_find(cskiplist_t cs, const void *x,
+        struct node *preds[], struct node *succs[], struct node *target)
+{
+    struct node *pred, *curr;
+    uintptr_t succ, expected;
+    int i, c;
+
+    pred = cs->head;
+    curr = NULL;
+    for (i = LOAD(cs->levels) - 1; i >= 0; --i) {
+        curr = PTR(LOAD(pred->next[i]));
+        while (curr != NULL) {
+            succ = LOAD(curr->next[i]);
+            if (MARKED(succ)) {
+                expected = (uintptr_t) curr;
+                if (!CAS(pred->next[i], expected, succ & ~MARK)) {
+                    return RETRY;
+                }
+                curr = PTR(succ);
+                continue;
+            }
+
+            c = cs->cmp(x, curr->x);
+            if (c > 0 || (c == 0 && target != NULL && curr != target)) {
+                pred = curr;
+                curr = PTR(succ);
+            } else {
+                break;
+            }
+        }
+        preds[i] = pred;
+        succs[i] = curr;
+    }
+
+    if (curr != NULL && cs->cmp(x, curr->x) == 0) {
+        return FOUND;
+    } else {
+        return ABSENT;
+    }
+}
+
+static enum result find(cskiplist_t cs, const void *x,
+        struct node *preds[], struct node *succs[], struct node *target)
+{
+    enum result res;
+
+    do {
+        res = attempt_find(cs, x, preds, succs, target);
+    } while (res == RETRY);
+    return res;
+}
+
+/*
+ * raise_levels - Make sure the levels in use cover level
+ */
+static void raise_levels(cskiplist_t cs, const int level)
+{
+    int old;
+
+    old = LOAD(cs->levels);
+    while (old < level && !CAS(cs->levels, old, level)) {
+        /* old is reloaded by failed CAS. */
+    }
+}
+
+/*
+ * finish - Unlink and retire a removed node, if last to touch it
+ *
+ * @flag: LINKING from the adder, REMOVED from the remover
+ */
+static void finish(cskiplist_t cs, struct node *n, const int flag)
+{
+    struct node *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+    int old;
+
+    if (flag == LINKING) {
+        old = __atomic_fetch_and(&n->state, ~LINKING, __ATOMIC_ACQ_REL);
+        if (!(old & REMOVED)) {
+            return;     /* Not removed, or its remover cleans up. */
+        }
+    } else {
+        old = __atomic_fetch_or(&n->state, REMOVED, __ATOMIC_ACQ_REL);
+        if (old & LINKING) {
+            return;     /* Adder cleans up once done linking. */
+        }
+    }
+
+    find(cs, n->x, preds, succs, n);
+    ebr_retire(cs->ebr, &n->retired);
+}
+
+/*
+ * link_upper - Link a new node at its upper levels
+ *
+ * Stops early once the node is being removed.
+ */
+static void link_upper(cskiplist_t cs, struct node *n,
+        struct node *preds[], struct node *succs[])
+{
+    uintptr_t old, succ;
+    int i;
+
+    for (i = 1; i < n->level; ++i) {
+        while (1) {
+            old = LOAD(n->next[i]);
+            succ = (uintptr_t) succs[i];
+            if (MARKED(old)) {
+                return;
+            } else if (old != succ && !CAS(n->next[i], old, succ)) {
+                return;     /* Only a remover changes it now. */
+            }
+
+            old = succ;
+            if (CAS(preds[i]->next[i], old, (uintptr_t) n)) {
+                break;
+            }
+            if (find(cs, n->x, preds, succs, NULL) == ABSENT || succs[0] != n) {
+                return;
+            }
+        }
+    }
+}
+
+int cskiplist_add(cskiplist_t cs, const cskiplistElem x)
+{
+    struct node *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+    struct node *n;
+    uintptr_t expected;
+    int i, level;
+
+    level = get_level();
+    n = new_node(x, level);
+    if (n == NULL) {
+        return -1;
+    } else if (ebr_enter(cs->ebr) == -1) {
+        free(n);
+        return -1;
+    }
+
+    raise_levels(cs, level);
+    while (1) {
+        if (find(cs, x, preds, succs, NULL) == FOUND) {
+            ebr_exit(cs->ebr);
+            free(n);    /* Never seen by others. */
+            return 0;   /* Ignore duplicate value. */
+        }
+
+        for (i = 0; i < level; ++i) {
+            n->next[i] = (uintptr_t) succs[i];
+        }
+        expected = (uintptr_t) succs[0];
+        if (CAS(preds[0]->next[0], expected, (uintptr_t) n)) {
+            break;
+        }
+    }
+    __atomic_add_fetch(&cs->size, 1, __ATOMIC_RELAXED);
+
+    if (level > 1) {
+        link_upper(cs, n, preds, succs);
+        finish(cs, n, LINKING);
+    }
+    ebr_exit(cs->ebr);
+    return 0;
+}
+
+int cskiplist_remove(cskiplist_t cs, const cskiplistElem x)
+{
+    struct node *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+    struct node *n;
+    uintptr_t v;
+    int i;
+
+    if (ebr_enter(cs->ebr) == -1) {
+        return -1;
+    } else if (find(cs, x, preds, succs, NULL) == ABSENT) {
+        ebr_exit(cs->ebr);
+        return -1;
+    }
+
+    /* Mark from the top, level 0 last takes it out of the set. */
+    n = succs[0];
+    for (i = n->level - 1; i >= 0; --i) {
+        v = LOAD(n->next[i]);
+        while (!MARKED(v) && !CAS(n->next[i], v, v | MARK)) {
+            /* v is reloaded by failed CAS. */
+        }
+        if (i == 0 && MARKED(v)) {
+            ebr_exit(cs->ebr);
+            return -1;  /* Another thread took it out first. */
+        }
+    }
+    __atomic_sub_fetch(&cs->size, 1, __ATOMIC_RELAXED);
+
+    finish(cs, n, REMOVED);
+    ebr_exit(cs->ebr);
+    return 0;
+}
+
+/*
+ * lower_bound - Find the first node not marked and not less than x
+ *
+ * Marked nodes are skipped, not unlinked, so readers never write.
+ */
+static struct node *lower_bound(cskiplist_t cs, const void *x)
+{
+    struct node *pred, *curr;
+    uintptr_t succ;
+    int i;
+
+    pred = cs->head;
+    curr = NULL;
+    for (i = LOAD(cs->levels) - 1; i >= 0; --i) {
+        curr = PTR(LOAD(pred->next[i]));
+        while (curr != NULL) {
+            succ = LOAD(curr->next[i]);
+            if (MARKED(succ)) {
+                curr = PTR(succ);
+            } else if (cs->cmp(x, curr->x) > 0) {
+                pred = curr;
+                curr = PTR(succ);
+            } else {
+                break;
+            }
+        }
+    }
+    return curr;
+}
+
+int cskiplist_contains(cskiplist_t cs, const cskiplistElem x)
+{
+    struct node *n;
+    int res;
+
+    if (ebr_enter(cs->ebr) == -1) {
+        return -1;
+    }
+    n = lower_bound(cs, x);
+    res = (n != NULL && cs->cmp(x, n->x) == 0);
+    ebr_exit(cs->ebr);
+    return res;
+}
+
+size_t cskiplist_range_scan(cskiplist_t cs, const cskiplistElem lo,
+        const cskiplistElem hi, cskiplist_visitor visit, void *arg)
+{
+    struct node *n;
+    uintptr_t succ;
+    size_t count;
+
+    if (ebr_enter(cs->ebr) == -1) {
+        return (size_t) -1;
+    }
+
+    count = 0;
+    n = lower_bound(cs, lo);
+    while (n != NULL && cs->cmp(n->x, hi) <= 0) {
+        succ = LOAD(n->next[0]);
+        if (!MARKED(succ)) {
+            count++;
+            if (visit(n->x, arg)) {
+                break;
+            }
+        }
+        n = PTR(succ);
+    }
+
+    ebr_exit(cs->ebr);
+    return count;
+}
+
+size_t cskiplist_get_size(cskiplist_t cs)
+{
+    return __atomic_load_n(&cs->size, __ATOMIC_RELAXED);
+}
+
+int cskiplist_isempty(cskiplist_t cs)
+{
+    return cskiplist_get_size(cs) == 0;
+}
@@ -0,0 +1,315 @@
+/*
+ * frozenset.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include "frozenset.h"
+
+/*
+ * Slots are numbered from 1: the children of slot k are 2k and
+ * 2k + 1, and slot 0 is left unused. Sixteen descendants four
+ * levels below k sit side by side from slot 16k on, which is two
+ * cache lines of pointers, so the search prefetches them while it
+ * compares at k.
+ */
+#define AHEAD   16
+
+struct _frozenset {
+    frozensetElem *slots;   /* n + 1 slots */
+    size_t n;               /* count of elements */
+    comparator cmp;
+};
+
+/*
+ * first - Slot of the smallest element of subtree k
+ */
+static size_t first(const size_t n, size_t k)
+{
+    while (2 * k <= n) {
+        k = 2 * k;
+    }
+    return k;
+}
+
+/*
+ * next - Slot of the in-order successor of slot k
+ *
+ * Return 0 if k holds the largest element.
+ *
+ * Without a right child, climb while k is a right child; the
+ * parent of the last left child is the successor.
+ */
+static size_t next(const size_t n, const size_t k)
+{
+    if (2 * k + 1 <= n) {
+        return first(n, 2 * k + 1);
+    } else {
+        return k >> (__builtin_ctzl(~k) + 1);
+    }
+}
+
+/*
+ * search - Find slot of the smallest element >= x, or > x
+ *
+ * @fs: the frozenset
+ * @x: the bound
+ * @strict: non-zero for > x
+ *
+ * Return the slot, or 0 if there is no such element.
+ *
+ * The loop has no branch on the outcome of a comparison, it
+ * only picks a child. Each step appends a bit to k, 1 for going
+ * right. Finally, stripping the trailing 1s and one 0 goes back
+ * to where the search last turned left, that is the answer.
+ *
+ * Elements are pointers, so the data of both children is fetched
+ * too, while cmp still reads that of k.
+ */
+static size_t search(frozenset_t fs, const void *x, const int strict)
+{
+    comparator cmp;
+    size_t k;
+    int res;
+
+    cmp = fs->cmp;
+    k = 1;
+    while (k <= fs->n) {
+        __builtin_prefetch(fs->slots + AHEAD * k);
+        if (2 * k + 1 <= fs->n) {
+            __builtin_prefetch(fs->slots[2 * k]);
+            __builtin_prefetch(fs->slots[2 * k + 1]);
+        }
+        res = cmp(fs->slots[k], x);
+        k = 2 * k + (strict ? res <= 0 : res < 0);
+    }
+    return k >> (__builtin_ctzl(~k) + 1);
+}
+
+/*
+ * fill - Create a frozenset of n sorted elements
+ *
+ * The in-order walk of the implicit tree visits slots
+ * in ascending order, so the elements are dealt to the
+ * slots as it goes.
+ */
+static int fill(frozenset_t *fs, frozensetElem const elems[],
+        const size_t n, const comparator cmp)
+{
+    frozenset_t new_fs;
+    size_t i, k;
+
+    new_fs = (frozenset_t) malloc(sizeof(*new_fs));
+    if (new_fs == NULL) {
+        return -1;
+    }
+
+    new_fs->slots = (frozensetElem *) malloc((n + 1) * sizeof(frozensetElem));
+    if (new_fs->slots == NULL) {
+        free(new_fs);
+        return -1;
+    }
+
+    new_fs->n = n;
+    new_fs->cmp = (cmp != NULL) ? cmp : cmp_int;
+    new_fs->slots[0] = NULL;
+    k = first(n, 1);
+    for (i = 0; i < n; ++i) {
+        new_fs->slots[k] = elems[i];
+        k = next(n, k);
+    }
+
+    *fs = new_fs;
+    return 0;
+}
+
+int frozenset_new(frozenset_t *fs, frozensetElem const elems[],
+        const size_t n, const comparator cmp)
+{
+    comparator c;
+    size_t i;
+
+    c = (cmp != NULL) ? cmp : cmp_int;
+    for (i = 1; i < n; ++i) {
+        if (c(elems[i - 1], elems[i]) >= 0) {
+            return -1;
+        }
+    }
+    return fill(fs, elems, n, cmp);
+}
+
+int frozenset_from_avltree(frozenset_t *fs, avltree_t avl)
+{
+    avltree_cursor_t cur;
+    frozensetElem *elems;
+    avltreeElem x;
+    size_t n;
+    int res;
+
+    elems = (frozensetElem *) malloc((avltree_get_size(avl) + 1)
+            * sizeof(frozensetElem));
+    if (elems == NULL) {
+        return -1;
+    } else if (avltree_cursor_new(&cur, avl) == -1) {
+        free(elems);
+        return -1;
+    }
+
+    n = 0;
+    res = avltree_cursor_first(cur, &x);
+    while (res == 0) {
+        elems[n++] = x;
+        res = avltree_next(cur, &x);
+    }
+    avltree_cursor_free(&cur);
+
+    res = fill(fs, elems, n, avltree_get_comparator(avl));
+    free(elems);
+    return res;
+}
+
+int frozenset_from_bstree(frozenset_t *fs, bstree_t bstree)
+{
+    bstree_cursor_t cur;
+    frozensetElem *elems, *bigger;
+    bstreeElem x;
+    size_t n, cap;
+    int res;
+
+    /* A bstree doesn't keep its size, grow the array on demand. */
+    cap = 64;
+    elems = (frozensetElem *) malloc(cap * sizeof(frozensetElem));
+    if (elems == NULL) {
+        return -1;
+    } else if (bstree_cursor_new(&cur, bstree) == -1) {
+        free(elems);
+        return -1;
+    }
+
+    n = 0;
+    res = bstree_cursor_first(cur, &x);
+    while (res == 0) {
+        if (n == cap) {
+            bigger = (frozensetElem *) realloc(elems,
+                    2 * cap * sizeof(frozensetElem));
+            if (bigger == NULL) {
+                break;
+            }
+            elems = bigger;
+            cap *= 2;
+        }
+        elems[n++] = x;
+        res = bstree_next(cur, &x);
+    }
+    bstree_cursor_free(&cur);
+
+    res = (res == 0) ? -1 : fill(fs, elems, n,
+            bstree_get_comparator(bstree));
+    free(elems);
+    return res;
+}
+
+void frozenset_free(frozenset_t *fs)
+{
+    free((*fs)->slots);
+    free(*fs);
+    *fs = NULL;
+}
+
+int frozenset_contains(frozenset_t fs, const frozensetElem x)
+{
+    size_t k;
+
+    k = search(fs, x, 0);
+    return k != 0 && fs->cmp(fs->slots[k], x) == 0;
+}
+
+int frozenset_lower_bound(frozenset_t fs, const frozensetElem x,
+        frozensetElem *y)
+{
+    size_t k;
+
+    k = search(fs, x, 0);
+    if (k == 0) {
+        return -1;
+    } else {
+        *y = fs->slots[k];
+        return 0;
+    }
+}
+
+int frozenset_upper_bound(frozenset_t fs, const frozensetElem x,
+        frozensetElem *y)
+{
+    size_t k;
+
+    k = search(fs, x, 1);
+    if (k == 0) {
+        return -1;
+    } else {
+        *y = fs->slots[k];
+        return 0;
+    }
+}
+
+size_t frozenset_range_scan(frozenset_t fs, const frozensetElem lo,
+        const frozensetElem hi, frozenset_visitor visit, void *arg)
+{
+    size_t k, count;
+
+    count = 0;
+    k = search(fs, lo, 0);
+    while (k != 0 && fs->cmp(fs->slots[k], hi) <= 0) {
+        count++;
+        if (visit(fs->slots[k], arg)) {
+            break;
+        }
+        k = next(fs->n, k);
+    }
+    return count;
+}
+
+int frozenset_get_min(frozenset_t fs, frozensetElem *x)
+{
+    if (fs->n == 0) {
+        return -1;
+    } else {
+        *x = fs->slots[first(fs->n, 1)];
+        return 0;
+    }
+}
+
+int frozenset_get_max(frozenset_t fs, frozensetElem *x)
+{
+    size_t k;
+
+    if (fs->n == 0) {
+        return -1;
+    }
+
+    k = 1;
+    while (2 * k + 1 <= fs->n) {
+        k = 2 * k + 1;
+    }
+    *x = fs->slots[k];
+    return 0;
+}
+
+size_t frozenset_get_size(frozenset_t fs)
+{
+    return fs->n;
+}
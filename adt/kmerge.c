@@ -0,0 +1,164 @@
+/*
+ * kmerge.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "kmerge.h"
+
+struct runs {
+    kmergeElem *x;          /* Remaining elements of the run. */
+    size_t left;            /* Count of remaining elements. */
+};
+
+/*
+ * Loser tree of k leaves, leaf i sits at virtual node k + i.
+ * loser[1..k-1] hold the losing run of each internal match,
+ * loser[0] holds the overall winner.
+ */
+struct _kmerge {
+    struct runs *runs;
+    size_t *loser;
+    size_t k;
+    comparator cmp;
+};
+
+/*
+ * beats - Check if run a wins against run b
+ *
+ * An exhausted run loses against any other run,
+ * ties are broken by run index to keep merge stable.
+ */
+static int beats(kmerge_t km, const size_t a, const size_t b)
+{
+    int res;
+
+    if (km->runs[a].left == 0) {
+        return 0;
+    } else if (km->runs[b].left == 0) {
+        return 1;
+    } else {
+        res = km->cmp(*km->runs[a].x, *km->runs[b].x);
+        return res < 0 || (res == 0 && a < b);
+    }
+}
+
+/*
+ * build - Play every match bottom-up
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ */
+static int build(kmerge_t km)
+{
+    size_t *winner;
+    size_t i, k;
+
+    k = km->k;
+    winner = (size_t *) malloc(2 * k * sizeof(*winner));
+    if (winner == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < k; ++i) {
+        winner[k + i] = i;
+    }
+    for (i = k - 1; i >= 1; --i) {
+        if (beats(km, winner[2 * i], winner[2 * i + 1])) {
+            winner[i] = winner[2 * i];
+            km->loser[i] = winner[2 * i + 1];
+        } else {
+            winner[i] = winner[2 * i + 1];
+            km->loser[i] = winner[2 * i];
+        }
+    }
+    km->loser[0] = (k > 1) ? winner[1] : 0;
+
+    free(winner);
+    return 0;
+}
+
+int kmerge_new(kmerge_t *km, kmergeElem *const runs[],
+        const size_t lens[], const size_t k, const comparator cmp)
+{
+    kmerge_t new_km;
+    size_t i;
+
+    new_km = (kmerge_t) malloc(sizeof(*new_km));
+    if (new_km == NULL) {
+        return -1;
+    }
+
+    new_km->k = k;
+    new_km->cmp = (cmp != NULL) ? cmp : cmp_int;
+    new_km->runs = (struct runs *) malloc((k + 1) * sizeof(struct runs));
+    new_km->loser = (size_t *) malloc((k + 1) * sizeof(size_t));
+
+    if (new_km->runs != NULL && new_km->loser != NULL) {
+        for (i = 0; i < k; ++i) {
+            new_km->runs[i].x = runs[i];
+            new_km->runs[i].left = lens[i];
+        }
+        if (k == 0 || build(new_km) == 0) {
+            *km = new_km;
+            return 0;
+        }
+    }
+
+    /* Out of memory. */
+    free(new_km->runs);
+    free(new_km->loser);
+    free(new_km);
+    return -1;
+}
+
+void kmerge_free(kmerge_t *km)
+{
+    free((*km)->runs);
+    free((*km)->loser);
+    free(*km);
+    *km = NULL;
+}
+
+int kmerge_next(kmerge_t km, kmergeElem *x)
+{
+    size_t winner, node, tmp;
+    struct runs *r;
+
+    if (km->k == 0) {
+        return -1;
+    }
+
+    winner = km->loser[0];
+    r = &km->runs[winner];
+    if (r->left == 0) {
+        return -1;  /* Winner is exhausted, so are the others. */
+    }
+
+    *x = *r->x;
+    r->x++;
+    r->left--;
+
+    /* Replay matches on the path from the leaf to the root. */
+    for (node = (km->k + winner) / 2; node >= 1; node /= 2) {
+        if (beats(km, km->loser[node], winner)) {
+            tmp = km->loser[node];
+            km->loser[node] = winner;
+            winner = tmp;
+        }
+    }
+    km->loser[0] = winner;
+    return 0;
+}
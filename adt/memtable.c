@@ -0,0 +1,399 @@
+/*
+ * memtable.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "memtable.h"
+
+/*
+ * The list follows the memtable of LevelDB.
+ *
+ * Nodes are never unlinked, so readers need no lock and no
+ * reclamation: the writer fills a node in full, then publishes
+ * it level by level from the bottom with release stores, and
+ * readers follow links with acquire loads. A reader may miss a
+ * node still being linked at upper levels, but then finds it
+ * by the levels below.
+ */
+#define MAX_LEVEL   32
+#define SHIFT       2       /* p = 1/4 */
+#define BLOCK       4096    /* arena block size */
+
+#define LOAD(p)     __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define STORE(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+struct node {
+    memtableKey key;
+    memtableValue value;
+    struct node *next[];
+};
+
+/*
+ * Arena memory comes in blocks. A request bigger than a
+ * quarter of a block gets a block of its own, so the space
+ * left in the current one is not thrown away.
+ */
+struct block {
+    struct block *next;
+    char data[];
+};
+
+struct _memtable {
+    struct node *head;
+    comparator cmp;
+    int levels;             /* Levels in use, only grows. */
+    size_t size;
+    unsigned long seed;     /* xorshift state, never 0 */
+    struct block *blocks;
+    char *ptr;              /* free space in current block */
+    size_t left;
+    size_t usage;           /* bytes of all blocks */
+};
+
+struct _memtable_cursor {
+    memtable_t mt;
+    struct node *node;      /* NULL if pointing to nothing */
+};
+
+/*
+ * new_block - Add a block of size bytes to the arena
+ *
+ * Return the data of the block, or NULL if out of memory.
+ */
+static char *new_block(memtable_t mt, const size_t size)
+{
+    struct block *b;
+
+    b = (struct block *) malloc(sizeof(*b) + size);
+    if (b == NULL) {
+        return NULL;
+    }
+    b->next = mt->blocks;
+    mt->blocks = b;
+    __atomic_store_n(&mt->usage, mt->usage + sizeof(*b) + size,
+            __ATOMIC_RELAXED);
+    return b->data;
+}
+
+void *memtable_alloc(memtable_t mt, size_t size)
+{
+    char *p;
+
+    /* Keep everything 8 bytes aligned. */
+    size = (size + 7) & ~(size_t) 7;
+    if (size <= mt->left) {
+        p = mt->ptr;
+        mt->ptr += size;
+        mt->left -= size;
+    } else if (size > BLOCK / 4) {
+        p = new_block(mt, size);
+    } else if ((p = new_block(mt, BLOCK)) != NULL) {
+        mt->ptr = p + size;
+        mt->left = BLOCK - size;
+    }
+    return p;
+}
+
+/*
+ * get_level - Draw level of a new node
+ *
+ * Only the writer draws, so the xorshift state lives in
+ * the memtable.
+ */
+static int get_level(memtable_t mt)
+{
+    unsigned long r;
+    int level;
+
+    r = mt->seed;
+    r ^= r << 13;
+    r ^= r >> 7;
+    r ^= r << 17;
+    mt->seed = r;
+
+    level = 1 + __builtin_ctzl(r) / SHIFT;
+    return level < MAX_LEVEL ? level : MAX_LEVEL;
+}
+
+static struct node *new_node(memtable_t mt, const memtableKey key,
+        const memtableValue value, const int level)
+{
+    struct node *n;
+    int i;
+
+    n = (struct node *) memtable_alloc(mt,
+            sizeof(*n) + level * sizeof(n->next[0]));
+    if (n != NULL) {
+        n->key = key;
+        n->value = value;
+        for (i = 0; i < level; ++i) {
+            n->next[i] = NULL;
+        }
+    }
+    return n;
+}
+
+int memtable_new(memtable_t *mt, const comparator cmp)
+{
+    static unsigned long counter = 0;
+    memtable_t new_mt;
+    unsigned long z;
+
+    new_mt = (memtable_t) malloc(sizeof(*new_mt));
+    if (new_mt == NULL) {
+        return -1;
+    }
+    new_mt->blocks = NULL;
+    new_mt->ptr = NULL;
+    new_mt->left = 0;
+    new_mt->usage = 0;
+
+    /* Head is always full height, and holds no pair. */
+    new_mt->head = new_node(new_mt, NULL, NULL, MAX_LEVEL);
+    if (new_mt->head == NULL) {
+        free(new_mt);
+        return -1;
+    }
+
+    /* splitmix64 of a shared counter. */
+    z = __atomic_add_fetch(&counter, 0x9e3779b97f4a7c15UL, __ATOMIC_RELAXED);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+    new_mt->seed = (z ^ (z >> 31)) | 1;
+
+    new_mt->cmp = (cmp != NULL) ? cmp : cmp_int;
+    new_mt->levels = 1;
+    new_mt->size = 0;
+    *mt = new_mt;
+    return 0;
+}
+
+void memtable_free(memtable_t *mt)
+{
+    struct block *b, *next;
+
+    /* Nodes go with their blocks. */
+    b = (*mt)->blocks;
+    while (b != NULL) {
+        next = b->next;
+        free(b);
+        b = next;
+    }
+    free(*mt);
+    *mt = NULL;
+}
+
+/*
+ * find_ge - Find the first node with key >= given key
+ *
+ * @mt: the memtable
+ * @key: the key
+ * @prev: output prev pointers in levels in use, or NULL
+ *
+ * Return the node, or NULL if no such node.
+ */
+static struct node *find_ge(memtable_t mt, const memtableKey key,
+        struct node *prev[])
+{
+    struct node *p, *q;
+    comparator cmp;
+    int i;
+
+    p = mt->head;
+    cmp = mt->cmp;
+    q = NULL;
+    i = __atomic_load_n(&mt->levels, __ATOMIC_RELAXED) - 1;
+    for (; i >= 0; --i) {
+        while ((q = LOAD(p->next[i])) != NULL && cmp(key, q->key) > 0) {
+            p = q;
+        }
+        if (prev != NULL) {
+            prev[i] = p;
+        }
+    }
+    return q;
+}
+
+/*
+ * find_lt - Find the last node with key < given key, or the
+ * last node of all if any is set
+ *
+ * Return the node, or head if no such node.
+ */
+static struct node *find_lt(memtable_t mt, const memtableKey key,
+        const int any)
+{
+    struct node *p, *q;
+    comparator cmp;
+    int i;
+
+    p = mt->head;
+    cmp = mt->cmp;
+    i = __atomic_load_n(&mt->levels, __ATOMIC_RELAXED) - 1;
+    for (; i >= 0; --i) {
+        while ((q = LOAD(p->next[i])) != NULL
+                && (any || cmp(key, q->key) > 0)) {
+            p = q;
+        }
+    }
+    return p;
+}
+
+int memtable_put(memtable_t mt, const memtableKey key,
+        const memtableValue value)
+{
+    struct node *nn, *q, *update[MAX_LEVEL];
+    int i, level;
+
+    q = find_ge(mt, key, update);
+    if (q != NULL && mt->cmp(key, q->key) == 0) {
+        STORE(q->value, value);     /* Update in place. */
+        return 0;
+    }
+
+    level = get_level(mt);
+    nn = new_node(mt, key, value, level);
+    if (nn == NULL) {
+        return -1;
+    }
+
+    /*
+     * Readers seeing the new levels early find nothing
+     * at them in head, and go on below.
+     */
+    if (level > mt->levels) {
+        for (i = mt->levels; i < level; ++i) {
+            update[i] = mt->head;
+        }
+        __atomic_store_n(&mt->levels, level, __ATOMIC_RELAXED);
+    }
+
+    /* Publish from the bottom, once the node is complete. */
+    for (i = 0; i < level; ++i) {
+        nn->next[i] = update[i]->next[i];
+        STORE(update[i]->next[i], nn);
+    }
+    __atomic_store_n(&mt->size, mt->size + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+int memtable_get(memtable_t mt, const memtableKey key,
+        memtableValue *value)
+{
+    struct node *q;
+
+    q = find_ge(mt, key, NULL);
+    if (q != NULL && mt->cmp(key, q->key) == 0) {
+        *value = LOAD(q->value);
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+size_t memtable_get_memory_usage(memtable_t mt)
+{
+    return __atomic_load_n(&mt->usage, __ATOMIC_RELAXED);
+}
+
+size_t memtable_get_size(memtable_t mt)
+{
+    return __atomic_load_n(&mt->size, __ATOMIC_RELAXED);
+}
+
+int memtable_isempty(memtable_t mt)
+{
+    return LOAD(mt->head->next[0]) == NULL;
+}
+
+int memtable_cursor_new(memtable_cursor_t *cur, memtable_t mt)
+{
+    memtable_cursor_t new_cur;
+
+    new_cur = (memtable_cursor_t) malloc(sizeof(*new_cur));
+    if (new_cur == NULL) {
+        return -1;
+    } else {
+        new_cur->mt = mt;
+        new_cur->node = NULL;
+        *cur = new_cur;
+        return 0;
+    }
+}
+
+void memtable_cursor_free(memtable_cursor_t *cur)
+{
+    free(*cur);
+    *cur = NULL;
+}
+
+/*
+ * settle - Point cursor to node n, or to nothing
+ *
+ * Return 0 if n is a node, -1 if not.
+ */
+static int settle(memtable_cursor_t cur, struct node *n,
+        memtableKey *key, memtableValue *value)
+{
+    if (n == NULL || n == cur->mt->head) {
+        cur->node = NULL;
+        return -1;
+    } else {
+        cur->node = n;
+        *key = n->key;
+        *value = LOAD(n->value);
+        return 0;
+    }
+}
+
+int memtable_cursor_first(memtable_cursor_t cur, memtableKey *key,
+        memtableValue *value)
+{
+    return settle(cur, LOAD(cur->mt->head->next[0]), key, value);
+}
+
+int memtable_cursor_last(memtable_cursor_t cur, memtableKey *key,
+        memtableValue *value)
+{
+    return settle(cur, find_lt(cur->mt, NULL, 1), key, value);
+}
+
+int memtable_seek(memtable_cursor_t cur, const memtableKey target,
+        memtableKey *key, memtableValue *value)
+{
+    return settle(cur, find_ge(cur->mt, target, NULL), key, value);
+}
+
+int memtable_next(memtable_cursor_t cur, memtableKey *key,
+        memtableValue *value)
+{
+    if (cur->node == NULL) {
+        return -1;
+    }
+    return settle(cur, LOAD(cur->node->next[0]), key, value);
+}
+
+int memtable_prev(memtable_cursor_t cur, memtableKey *key,
+        memtableValue *value)
+{
+    if (cur->node == NULL) {
+        return -1;
+    }
+    return settle(cur, find_lt(cur->mt, cur->node->key, 0), key, value);
+}
@@ -0,0 +1,281 @@
+/*
+ * minmax-heap.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "minmax-heap.h"
+
+struct _minmax_heap {
+    minMaxHeapElem *array;  /* heap array  */
+    size_t size;    /* capacity  */
+    size_t used;    /* used space  */
+    comparator cmp; /* comparing function  */
+};
+
+static void swap(minMaxHeapElem v[], const size_t x, const size_t y)
+{
+    minMaxHeapElem temp;
+
+    temp = v[x];
+    v[x] = v[y];
+    v[y] = temp;
+}
+
+/*
+ * is_max_level - Check if node idx lies on a max (odd) level
+ */
+static int is_max_level(const size_t idx)
+{
+    int level;
+
+    level = 8 * sizeof(unsigned long) - 1 - __builtin_clzl(idx + 1);
+    return level & 1;
+}
+
+/*
+ * better - Check if x should be closer to the root than y
+ *
+ * On max levels larger wins, on min levels smaller wins.
+ */
+static int better(minmax_heap_t heap, const minMaxHeapElem x,
+        const minMaxHeapElem y, const int max)
+{
+    return max ? heap->cmp(x, y) > 0 : heap->cmp(x, y) < 0;
+}
+
+/*
+ * bubble_up - Shift element up among its grandparents
+ */
+static void bubble_up(minmax_heap_t heap, size_t idx, const int max)
+{
+    size_t grandparent;
+    minMaxHeapElem *array;
+
+    array = heap->array;
+    while (idx > 2) {
+        grandparent = (idx - 3) / 4;
+        if (better(heap, array[idx], array[grandparent], max)) {
+            swap(array, idx, grandparent);
+            idx = grandparent;
+        } else {
+            break;
+        }
+    }
+}
+
+/*
+ * shiftup - Shift up a newly added element
+ */
+static void shiftup(minmax_heap_t heap, size_t idx)
+{
+    size_t parent;
+    int max;
+
+    if (idx == 0) {
+        return;
+    }
+
+    parent = (idx - 1) / 2;
+    max = is_max_level(idx);
+
+    /*
+     * If it violates the order with its parent, it belongs
+     * to the levels of the other kind, swap and go on there.
+     */
+    if (better(heap, heap->array[parent], heap->array[idx], !max)) {
+        bubble_up(heap, idx, max);
+    } else {
+        swap(heap->array, idx, parent);
+        bubble_up(heap, parent, !max);
+    }
+}
+
+/*
+ * shiftdown - Shift down element in the heap
+ *
+ * @heap: the heap
+ * @idx: element index
+ */
+static void shiftdown(minmax_heap_t heap, size_t idx)
+{
+    size_t n, m, i, first, last;
+    minMaxHeapElem *array;
+    int max;
+
+    n = heap->used;
+    array = heap->array;
+    max = is_max_level(idx);
+
+    while (2 * idx + 1 < n) {
+        /* Find the best among children and grandchildren. */
+        m = 2 * idx + 1;
+        if (m + 1 < n && better(heap, array[m + 1], array[m], max)) {
+            m = m + 1;
+        }
+        first = 4 * idx + 3;
+        last  = first + 4 < n ? first + 4 : n;
+        for (i = first; i < last; ++i) {
+            if (better(heap, array[i], array[m], max)) {
+                m = i;
+            }
+        }
+
+        if (!better(heap, array[m], array[idx], max)) {
+            break;
+        }
+        swap(array, m, idx);
+
+        if (m < first) {
+            break;      /* A child, which has no descendants of its own. */
+        }
+
+        /* A grandchild, keep order with its parent on the other level. */
+        if (better(heap, array[(m - 1) / 2], array[m], max)) {
+            swap(array, m, (m - 1) / 2);
+        }
+        idx = m;
+    }
+}
+
+/*
+ * max_index - Get index of the maximum element
+ */
+static size_t max_index(minmax_heap_t heap)
+{
+    if (heap->used == 1) {
+        return 0;
+    } else if (heap->used == 2
+            || heap->cmp(heap->array[1], heap->array[2]) >= 0) {
+        return 1;
+    } else {
+        return 2;
+    }
+}
+
+/*
+ * remove_at - Remove element at idx and fix the heap
+ */
+static minMaxHeapElem remove_at(minmax_heap_t heap, const size_t idx)
+{
+    minMaxHeapElem x;
+
+    x = heap->array[idx];
+    heap->used--;
+    if (idx < heap->used) {
+        heap->array[idx] = heap->array[heap->used];
+        shiftdown(heap, idx);
+    }
+    return x;
+}
+
+int minmax_heap_new(minmax_heap_t *heap, const size_t n, const comparator cmp)
+{
+    minMaxHeapElem *array;
+    minmax_heap_t new_heap;
+
+    new_heap = (minmax_heap_t) malloc(sizeof(*new_heap));
+    if (new_heap == NULL) {
+        return -1;
+    }
+
+    array = (minMaxHeapElem *) malloc(n * sizeof(*array));
+    if (array == NULL) {
+        free(new_heap);
+        return -1;
+    } else {
+        new_heap->array = array;
+        new_heap->size = n;
+        new_heap->used = 0;
+        new_heap->cmp  = (cmp != NULL) ? cmp : cmp_int;
+        *heap = new_heap;
+        return 0;
+    }
+}
+
+void minmax_heap_free(minmax_heap_t *heap)
+{
+    free((*heap)->array);
+    free(*heap);
+    *heap = NULL;
+}
+
+int minmax_heap_add(minmax_heap_t heap, const minMaxHeapElem x)
+{
+    if (minmax_heap_isfull(heap)) {
+        return -1;
+    } else {
+        heap->array[heap->used] = x;
+        heap->used++;
+        shiftup(heap, heap->used - 1);
+        return 0;
+    }
+}
+
+int minmax_heap_poll_min(minmax_heap_t heap, minMaxHeapElem *x)
+{
+    if (minmax_heap_isempty(heap)) {
+        return -1;
+    } else {
+        *x = remove_at(heap, 0);
+        return 0;
+    }
+}
+
+int minmax_heap_poll_max(minmax_heap_t heap, minMaxHeapElem *x)
+{
+    if (minmax_heap_isempty(heap)) {
+        return -1;
+    } else {
+        *x = remove_at(heap, max_index(heap));
+        return 0;
+    }
+}
+
+int minmax_heap_peek_min(minmax_heap_t heap, minMaxHeapElem *x)
+{
+    if (minmax_heap_isempty(heap)) {
+        return -1;
+    } else {
+        *x = heap->array[0];
+        return 0;
+    }
+}
+
+int minmax_heap_peek_max(minmax_heap_t heap, minMaxHeapElem *x)
+{
+    if (minmax_heap_isempty(heap)) {
+        return -1;
+    } else {
+        *x = heap->array[max_index(heap)];
+        return 0;
+    }
+}
+
+size_t minmax_heap_get_size(minmax_heap_t heap)
+{
+    return heap->used;
+}
+
+int minmax_heap_isempty(minmax_heap_t heap)
+{
+    return heap->used == 0;
+}
+
+int minmax_heap_isfull(minmax_heap_t heap)
+{
+    return heap->used == heap->size;
+}
@@ -0,0 +1,267 @@
+/*
+ * multiqueue.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "binary-minheap.h"
+#include "multiqueue.h"
+
+#define CACHE_LINE 64
+static const size_t DEFAULT_C = 2;
+
+/*
+ * Every heap sits on its own cache lines, so that
+ * threads working on different heaps never share a line.
+ */
+struct heaps {
+    pthread_mutex_t lock;
+    binary_minheap_t heap;
+    multiQueueElem top;     /* Cached root, NULL if heap is empty. */
+} __attribute__((aligned(CACHE_LINE)));
+
+struct _multiqueue {
+    struct heaps *heaps;
+    size_t nheaps;
+    size_t size;            /* Count of elements. */
+    comparator cmp;
+};
+
+/*
+ * Per-thread state of xorshift64* generator.
+ * Zero means not seeded yet.
+ */
+static __thread uint64_t seed;
+
+static size_t get_random(size_t n)
+{
+    if (seed == 0) {
+        seed = (uint64_t) (uintptr_t) &seed ^ (uint64_t) time(NULL);
+        seed |= 1;
+    }
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return (size_t) ((seed * 0x2545F4914F6CDD1DULL) >> 32) % n;
+}
+
+static multiQueueElem load_top(struct heaps *h)
+{
+    return __atomic_load_n(&h->top, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * update_top - Refresh cached root of a locked heap
+ */
+static void update_top(struct heaps *h)
+{
+    binaryMinHeapElem x;
+
+    if (binary_minheap_peek(h->heap, &x) == -1) {
+        x = NULL;
+    }
+    __atomic_store_n(&h->top, x, __ATOMIC_RELEASE);
+}
+
+int multiqueue_new(multiqueue_t *mq, const size_t nthreads,
+        const size_t c, const size_t n, const comparator cmp)
+{
+    multiqueue_t new_mq;
+    struct heaps *heaps;
+    size_t nheaps;
+    size_t i;
+
+    nheaps = (nthreads > 0 ? nthreads : 1) * (c > 0 ? c : DEFAULT_C);
+
+    new_mq = (multiqueue_t) malloc(sizeof(*new_mq));
+    if (new_mq == NULL) {
+        return -1;
+    }
+
+    if (posix_memalign((void **) &heaps, CACHE_LINE,
+                nheaps * sizeof(*heaps)) != 0) {
+        free(new_mq);
+        return -1;
+    }
+
+    for (i = 0; i < nheaps; ++i) {
+        if (binary_minheap_new(&heaps[i].heap, n, cmp) == -1) {
+            while (i-- > 0) {
+                pthread_mutex_destroy(&heaps[i].lock);
+                binary_minheap_free(&heaps[i].heap);
+            }
+            free(heaps);
+            free(new_mq);
+            return -1;
+        }
+        pthread_mutex_init(&heaps[i].lock, NULL);
+        heaps[i].top = NULL;
+    }
+
+    new_mq->heaps  = heaps;
+    new_mq->nheaps = nheaps;
+    new_mq->size   = 0;
+    new_mq->cmp    = (cmp != NULL) ? cmp : cmp_int;
+    *mq = new_mq;
+    return 0;
+}
+
+void multiqueue_free(multiqueue_t *mq)
+{
+    size_t i;
+
+    for (i = 0; i < (*mq)->nheaps; ++i) {
+        pthread_mutex_destroy(&(*mq)->heaps[i].lock);
+        binary_minheap_free(&(*mq)->heaps[i].heap);
+    }
+    free((*mq)->heaps);
+    free(*mq);
+    *mq = NULL;
+}
+
+/*
+ * try_add - Add an element to a locked, non-full heap
+ *
+ * Return 0 if success, -1 if the heap is full.
+ */
+static int try_add(multiqueue_t mq, struct heaps *h, const multiQueueElem x)
+{
+    if (binary_minheap_add(h->heap, x) == -1) {
+        return -1;
+    } else {
+        update_top(h);
+        __atomic_fetch_add(&mq->size, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+}
+
+int multiqueue_add(multiqueue_t mq, const multiQueueElem x)
+{
+    struct heaps *h;
+    size_t i;
+    size_t tries;
+    int res;
+
+    /* Insert to a random heap which is neither locked nor full. */
+    for (tries = 0; tries < 2 * mq->nheaps; ++tries) {
+        h = &mq->heaps[get_random(mq->nheaps)];
+        if (pthread_mutex_trylock(&h->lock) != 0) {
+            continue;
+        }
+        res = try_add(mq, h, x);
+        pthread_mutex_unlock(&h->lock);
+        if (res == 0) {
+            return 0;
+        }
+    }
+
+    /* Most heaps are full, fall back to a blocking scan. */
+    for (i = 0; i < mq->nheaps; ++i) {
+        h = &mq->heaps[i];
+        pthread_mutex_lock(&h->lock);
+        res = try_add(mq, h, x);
+        pthread_mutex_unlock(&h->lock);
+        if (res == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * pick - Pick the heap with smaller cached root
+ *
+ * An empty heap is taken as infinity. Return NULL if both are empty.
+ */
+static struct heaps *pick(multiqueue_t mq, struct heaps *a, struct heaps *b)
+{
+    multiQueueElem ta, tb;
+
+    ta = load_top(a);
+    tb = load_top(b);
+
+    if (ta == NULL) {
+        return tb != NULL ? b : NULL;
+    } else if (tb == NULL) {
+        return a;
+    } else {
+        return mq->cmp(ta, tb) <= 0 ? a : b;
+    }
+}
+
+/*
+ * try_poll - Poll the root of a locked heap
+ *
+ * Return 0 if success, -1 if the heap is empty.
+ */
+static int try_poll(multiqueue_t mq, struct heaps *h, multiQueueElem *x)
+{
+    if (binary_minheap_poll(h->heap, x) == -1) {
+        return -1;
+    } else {
+        update_top(h);
+        __atomic_fetch_sub(&mq->size, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+}
+
+int multiqueue_poll(multiqueue_t mq, multiQueueElem *x)
+{
+    struct heaps *h;
+    size_t i;
+    int res;
+
+    for (;;) {
+        h = pick(mq, &mq->heaps[get_random(mq->nheaps)],
+                     &mq->heaps[get_random(mq->nheaps)]);
+
+        if (h == NULL) {
+            /* Both are empty, make sure the others are empty too. */
+            for (i = 0; i < mq->nheaps; ++i) {
+                if (load_top(&mq->heaps[i]) != NULL) {
+                    break;
+                }
+            }
+            if (i == mq->nheaps) {
+                return -1;
+            } else {
+                h = &mq->heaps[i];
+            }
+        }
+
+        if (pthread_mutex_trylock(&h->lock) != 0) {
+            continue;   /* Contended, choose again. */
+        }
+        res = try_poll(mq, h, x);
+        pthread_mutex_unlock(&h->lock);
+        if (res == 0) {
+            return 0;
+        }
+    }
+}
+
+size_t multiqueue_get_size(multiqueue_t mq)
+{
+    return __atomic_load_n(&mq->size, __ATOMIC_RELAXED);
+}
+
+int multiqueue_isempty(multiqueue_t mq)
+{
+    return multiqueue_get_size(mq) == 0;
+}
@@ -0,0 +1,568 @@
+/*
+ * rb-tree.c
+ * Implementation of red-black tree.
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "rb-tree.h"
+#include "mempool.h"
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+#define RED   0
+#define BLACK 1
+
+struct entry {
+    struct rbnode node;     /* Must be the first member. */
+    rbtreeElem x;           /* data */
+};
+
+struct _rbtree {
+    struct rbnode *root;
+    mempool_t pool;             /* entries, NULL if intrusive */
+    comparator cmp;             /* comparing function of elements */
+    rbnode_comparator node_cmp; /* comparing function of nodes */
+};
+
+static int is_red(const struct rbnode *n)
+{
+    return n != NULL && n->color == RED;
+}
+
+/*
+ * compare - Compare a key with a node
+ *
+ * The key is an element, or a node in an intrusive tree.
+ */
+static int compare(rbtree_t rb, const void *key, const struct rbnode *n)
+{
+    if (rb->pool == NULL) {
+        return rb->node_cmp((const struct rbnode *) key, n);
+    } else {
+        return rb->cmp(key, ((const struct entry *) n)->x);
+    }
+}
+
+/*
+ * find_link - Find the link where key is or should be
+ *
+ * @rb: the red-black tree
+ * @key: the key
+ * @parent: output parent of the link
+ */
+static struct rbnode **find_link(rbtree_t rb, const void *key,
+        struct rbnode **parent)
+{
+    struct rbnode **link;
+    int res;
+
+    *parent = NULL;
+    link = &rb->root;
+    while (*link != NULL) {
+        res = compare(rb, key, *link);
+        if (res == 0) {
+            break;
+        }
+        *parent = *link;
+        link = (res < 0) ? &(*link)->left : &(*link)->right;
+    }
+    return link;
+}
+
+/*
+ * replace_child - Let parent point to new child instead of old one
+ */
+static void replace_child(rbtree_t rb, struct rbnode *parent,
+        struct rbnode *old, struct rbnode *child)
+{
+    if (parent == NULL) {
+        rb->root = child;
+    } else if (parent->left == old) {
+        parent->left = child;
+    } else {
+        parent->right = child;
+    }
+}
+
+/*
+ * rotate_left - Left rotation
+ *
+ * Schema:
+ *        x                    y
+ *       / \     rotate_left  / \
+ *      a   y        ==>     x   c
+ *         / \              / \
+ *        b   c            a   b
+ */
+static void rotate_left(rbtree_t rb, struct rbnode *x)
+{
+    struct rbnode *y;
+
+    y = x->right;
+    x->right = y->left;
+    if (y->left != NULL) {
+        y->left->parent = x;
+    }
+    y->parent = x->parent;
+    replace_child(rb, x->parent, x, y);
+    y->left = x;
+    x->parent = y;
+}
+
+/*
+ * rotate_right - Right rotation, mirror of rotate_left
+ */
+static void rotate_right(rbtree_t rb, struct rbnode *x)
+{
+    struct rbnode *y;
+
+    y = x->left;
+    x->left = y->right;
+    if (y->right != NULL) {
+        y->right->parent = x;
+    }
+    y->parent = x->parent;
+    replace_child(rb, x->parent, x, y);
+    y->right = x;
+    x->parent = y;
+}
+
+/*
+ * insert_fixup - Restore red-black properties after linking a red node
+ */
+static void insert_fixup(rbtree_t rb, struct rbnode *z)
+{
+    struct rbnode *p, *g, *u;
+
+    while ((p = z->parent) != NULL && p->color == RED) {
+        g = p->parent;      /* Red parent is never the root. */
+
+        if (p == g->left) {
+            u = g->right;
+            if (is_red(u)) {
+                /* Red uncle, recolor and go up. */
+                p->color = BLACK;
+                u->color = BLACK;
+                g->color = RED;
+                z = g;
+                continue;
+            }
+            if (z == p->right) {
+                rotate_left(rb, p);
+                z = p;
+                p = z->parent;
+            }
+            p->color = BLACK;
+            g->color = RED;
+            rotate_right(rb, g);
+
+        } else {
+            u = g->left;
+            if (is_red(u)) {
+                p->color = BLACK;
+                u->color = BLACK;
+                g->color = RED;
+                z = g;
+                continue;
+            }
+            if (z == p->left) {
+                rotate_right(rb, p);
+                z = p;
+                p = z->parent;
+            }
+            p->color = BLACK;
+            g->color = RED;
+            rotate_left(rb, g);
+        }
+    }
+    rb->root->color = BLACK;
+}
+
+/*
+ * link_node - Link a node at given position and re-balance
+ */
+static void link_node(rbtree_t rb, struct rbnode *node,
+        struct rbnode *parent, struct rbnode **link)
+{
+    node->parent = parent;
+    node->left = NULL;
+    node->right = NULL;
+    node->color = RED;
+    *link = node;
+    insert_fixup(rb, node);
+}
+
+/*
+ * erase_fixup - Restore red-black properties after unlinking a black node
+ *
+ * @node: the node taking place of the unlinked one, may be NULL
+ * @parent: parent of node
+ */
+static void erase_fixup(rbtree_t rb, struct rbnode *node, struct rbnode *parent)
+{
+    struct rbnode *other;
+
+    while (!is_red(node) && node != rb->root) {
+        if (parent->left == node) {
+            other = parent->right;
+            if (is_red(other)) {
+                other->color = BLACK;
+                parent->color = RED;
+                rotate_left(rb, parent);
+                other = parent->right;
+            }
+            if (!is_red(other->left) && !is_red(other->right)) {
+                other->color = RED;
+                node = parent;
+                parent = node->parent;
+            } else {
+                if (!is_red(other->right)) {
+                    other->left->color = BLACK;
+                    other->color = RED;
+                    rotate_right(rb, other);
+                    other = parent->right;
+                }
+                other->color = parent->color;
+                parent->color = BLACK;
+                other->right->color = BLACK;
+                rotate_left(rb, parent);
+                node = rb->root;
+                break;
+            }
+
+        } else {
+            other = parent->left;
+            if (is_red(other)) {
+                other->color = BLACK;
+                parent->color = RED;
+                rotate_right(rb, parent);
+                other = parent->left;
+            }
+            if (!is_red(other->left) && !is_red(other->right)) {
+                other->color = RED;
+                node = parent;
+                parent = node->parent;
+            } else {
+                if (!is_red(other->left)) {
+                    other->right->color = BLACK;
+                    other->color = RED;
+                    rotate_left(rb, other);
+                    other = parent->left;
+                }
+                other->color = parent->color;
+                parent->color = BLACK;
+                other->left->color = BLACK;
+                rotate_right(rb, parent);
+                node = rb->root;
+                break;
+            }
+        }
+    }
+    if (node != NULL) {
+        node->color = BLACK;
+    }
+}
+
+/*
+ * erase - Unlink a node and re-balance
+ */
+static void erase(rbtree_t rb, struct rbnode *node)
+{
+    struct rbnode *child, *parent, *succ;
+    int color;
+
+    if (node->left == NULL || node->right == NULL) {
+        /* At most one child, splice it up. */
+        child = (node->left != NULL) ? node->left : node->right;
+        parent = node->parent;
+        color = node->color;
+
+        if (child != NULL) {
+            child->parent = parent;
+        }
+        replace_child(rb, parent, node, child);
+
+    } else {
+        /* Two children, move the successor into node's place. */
+        succ = node->right;
+        while (succ->left != NULL) {
+            succ = succ->left;
+        }
+        replace_child(rb, node->parent, node, succ);
+
+        child = succ->right;
+        parent = succ->parent;
+        color = succ->color;
+
+        if (parent == node) {
+            parent = succ;
+        } else {
+            if (child != NULL) {
+                child->parent = parent;
+            }
+            parent->left = child;
+            succ->right = node->right;
+            node->right->parent = succ;
+        }
+
+        succ->parent = node->parent;
+        succ->color = node->color;
+        succ->left = node->left;
+        node->left->parent = succ;
+    }
+
+    if (color == BLACK) {
+        erase_fixup(rb, child, parent);
+    }
+}
+
+int rbtree_new(rbtree_t *rb, const comparator cmp)
+{
+    rbtree_t new_rb;
+
+    new_rb = (rbtree_t) malloc(sizeof(*new_rb));
+    if (new_rb == NULL) {
+        return -1;
+
+    } else if (mempool_new(&new_rb->pool, sizeof(struct entry)) == -1) {
+        free(new_rb);
+        return -1;
+
+    } else {
+        new_rb->root = NULL;
+        new_rb->cmp = (cmp != NULL) ? cmp : cmp_int;
+        new_rb->node_cmp = NULL;
+        *rb = new_rb;
+        return 0;
+    }
+}
+
+int rbtree_new_intrusive(rbtree_t *rb, const rbnode_comparator cmp)
+{
+    rbtree_t new_rb;
+
+    new_rb = (rbtree_t) malloc(sizeof(*new_rb));
+    if (new_rb == NULL) {
+        return -1;
+
+    } else {
+        new_rb->root = NULL;
+        new_rb->pool = NULL;
+        new_rb->cmp = NULL;
+        new_rb->node_cmp = cmp;
+        *rb = new_rb;
+        return 0;
+    }
+}
+
+void rbtree_free(rbtree_t *rb)
+{
+    if ((*rb)->pool != NULL) {
+        mempool_free(&(*rb)->pool);
+    }
+    free(*rb);
+    *rb = NULL;
+}
+
+int rbtree_add(rbtree_t rb, const rbtreeElem x)
+{
+    struct rbnode **link, *parent;
+    struct entry *e;
+
+    if (rb->pool == NULL) {
+        return -1;  /* Intrusive, no entries to alloc. */
+    }
+    link = find_link(rb, x, &parent);
+    if (*link != NULL) {
+        return 0;   /* Duplicated and ignore. */
+    }
+
+    e = (struct entry *) mempool_alloc(rb->pool);
+    if (e == NULL) {
+        return -1;
+    } else {
+        e->x = x;
+        link_node(rb, &e->node, parent, link);
+        return 0;
+    }
+}
+
+int rbtree_remove(rbtree_t rb, const rbtreeElem x)
+{
+    struct rbnode **link, *parent, *node;
+
+    if (rb->pool == NULL) {
+        return -1;
+    }
+    link = find_link(rb, x, &parent);
+    if (*link == NULL) {
+        return -1;
+    } else {
+        node = *link;
+        erase(rb, node);
+        mempool_release(rb->pool, node);
+        return 0;
+    }
+}
+
+int rbtree_contains(rbtree_t rb, const rbtreeElem x)
+{
+    struct rbnode *parent;
+
+    if (rb->pool == NULL) {
+        return 0;
+    }
+    return *find_link(rb, x, &parent) != NULL;
+}
+
+int rbtree_get_min(rbtree_t rb, rbtreeElem *x)
+{
+    struct rbnode *n;
+
+    n = (rb->pool != NULL) ? rbtree_first_node(rb) : NULL;
+    if (n != NULL) {
+        *x = ((struct entry *) n)->x;
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+int rbtree_get_max(rbtree_t rb, rbtreeElem *x)
+{
+    struct rbnode *n;
+
+    n = (rb->pool != NULL) ? rbtree_last_node(rb) : NULL;
+    if (n != NULL) {
+        *x = ((struct entry *) n)->x;
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+/*
+ * subtree_get_height - Get height of subtree
+ */
+static int subtree_get_height(struct rbnode *root)
+{
+    int left, right;
+
+    if (root == NULL) {
+        return 0;
+    }
+
+    /* max() evaluates its arguments twice, don't recurse in it. */
+    left = subtree_get_height(root->left);
+    right = subtree_get_height(root->right);
+    return 1 + max(left, right);
+}
+
+int rbtree_get_height(rbtree_t rb)
+{
+    return subtree_get_height(rb->root);
+}
+
+int rbtree_isempty(rbtree_t rb)
+{
+    return rb->root == NULL;
+}
+
+int rbtree_insert_node(rbtree_t rb, struct rbnode *node)
+{
+    struct rbnode **link, *parent;
+
+    link = find_link(rb, node, &parent);
+    if (*link != NULL) {
+        return -1;
+    } else {
+        link_node(rb, node, parent, link);
+        return 0;
+    }
+}
+
+void rbtree_erase_node(rbtree_t rb, struct rbnode *node)
+{
+    erase(rb, node);
+}
+
+struct rbnode *rbtree_find_node(rbtree_t rb, const struct rbnode *key)
+{
+    struct rbnode *parent;
+
+    return *find_link(rb, key, &parent);
+}
+
+struct rbnode *rbtree_first_node(rbtree_t rb)
+{
+    struct rbnode *n;
+
+    n = rb->root;
+    while (n != NULL && n->left != NULL) {
+        n = n->left;
+    }
+    return n;
+}
+
+struct rbnode *rbtree_last_node(rbtree_t rb)
+{
+    struct rbnode *n;
+
+    n = rb->root;
+    while (n != NULL && n->right != NULL) {
+        n = n->right;
+    }
+    return n;
+}
+
+struct rbnode *rbtree_next_node(const struct rbnode *node)
+{
+    struct rbnode *n;
+
+    if (node->right != NULL) {
+        n = node->right;
+        while (n->left != NULL) {
+            n = n->left;
+        }
+        return n;
+    }
+
+    /* Go up until we come from a left child. */
+    while (node->parent != NULL && node == node->parent->right) {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+struct rbnode *rbtree_prev_node(const struct rbnode *node)
+{
+    struct rbnode *n;
+
+    if (node->left != NULL) {
+        n = node->left;
+        while (n->right != NULL) {
+            n = n->right;
+        }
+        return n;
+    }
+
+    while (node->parent != NULL && node == node->parent->left) {
+        node = node->parent;
+    }
+    return node->parent;
+}
@@ -19,115 +19,321 @@
 
 #include <stddef.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
 #include "skiplist.h"
+#include "mempool.h"
 
 static const size_t MAX_LEVEL = 32;
+static const unsigned int BRANCHING = 4;    /* Default 1/p. */
 
+/*
+ * Each link knows its span, the count of level 0 steps it
+ * skips, as in the zset of Redis. Positions count from 1 with
+ * head at 0, and a link to NULL spans up to the last element.
+ */
+struct link {
+    struct boxes *next;
+    size_t span;
+};
+
+/*
+ * Boxes are one allocation, the links trail the node.
+ * In an inline skiplist the element itself is copied right
+ * after them, and x points there.
+ */
 struct boxes {      /* Node structure */
     skiplistElem x;
     size_t level;           /* Current level. */
-    struct boxes **next;
+    struct link lv[];
 };
 
 struct _skiplist {
     struct boxes *head;
-    size_t levels;
+    size_t levels;          /* Levels in use, at least 1. */
+    size_t length;          /* Count of elements. */
     comparator cmp;
+    size_t size;            /* Size of inline elements, or 0. */
+    mempool_t pools[MAX_LEVEL];     /* Boxes by level, made on demand. */
+    unsigned long seed;     /* xorshift state, never 0 */
+    int shift;              /* log2 of 1/p */
+    struct boxes *finger[MAX_LEVEL];    /* prev pointers of last change */
+    size_t finger_rank[MAX_LEVEL];      /* and their positions */
 };
 
-static size_t get_level(void)
+/*
+ * new_seed - Seed a new skiplist
+ *
+ * Lists created one after the other get far apart seeds by
+ * splitmix64 of a shared counter.
+ */
+static unsigned long new_seed(void)
 {
-    int level = 1;
+    static unsigned long counter = 0;
+    unsigned long z;
 
-    srand((unsigned int) time(NULL));
-    while (rand() % 2) {    /* Coin flip. */
-        level++;
-    }
+    z = __atomic_add_fetch(&counter, 0x9e3779b97f4a7c15UL, __ATOMIC_RELAXED);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+    z = z ^ (z >> 31);
+    return (z != 0) ? z : 1;
+}
+
+/*
+ * get_level - Draw level of new boxes
+ *
+ * Each level above 1 takes another shift zero bits in a row at
+ * the bottom of a random word, that is one more level with
+ * chance p = 1 / 2^shift.
+ */
+static size_t get_level(skiplist_t skiplist)
+{
+    unsigned long r;
+    size_t level;
+
+    r = skiplist->seed;
+    r ^= r << 13;
+    r ^= r >> 7;
+    r ^= r << 17;
+    skiplist->seed = r;
+
+    level = 1 + __builtin_ctzl(r) / skiplist->shift;
     return level < MAX_LEVEL ? level : MAX_LEVEL;
 }
 
 /*
  * new_boxes - Create and initialize new boxes
  *
+ * @skiplist[in]: the skiplist
  * @nb[out]: new boxes
  * @x[in]: input value
  * @level[in]: the size of the boxes
  *
  * Return 0 if create new boxes successfully, -1 if out of memory.
  */
-static int new_boxes(struct boxes **nb, const skiplistElem x, const size_t level)
+static int new_boxes(skiplist_t skiplist, struct boxes **nb,
+        const skiplistElem x, const size_t level)
 {
-    struct boxes **new_next;
+    mempool_t *pool;
+    size_t size;
+
+    /* Keep inline elements 8 bytes aligned. */
+    size = offsetof(struct boxes, lv) + level * sizeof((*nb)->lv[0])
+        + ((skiplist->size + 7) & ~(size_t) 7);
 
-    *nb = (struct boxes *) malloc(sizeof(struct boxes));
+    pool = &skiplist->pools[level - 1];
+    if (*pool == NULL && mempool_new(pool, size) == -1) {
+        return -1;
+    }
+
+    *nb = (struct boxes *) mempool_alloc(*pool);
     if (*nb == NULL) {
         return -1;
+    } else if (skiplist->size != 0) {
+        (*nb)->x = (skiplistElem) &(*nb)->lv[level];
+        memcpy((*nb)->x, x, skiplist->size);
     } else {
-        new_next = (struct boxes **) malloc(level * sizeof(new_next[0]));
-        if (new_next == NULL) {
-            free(nb);
-            return -1;
-        } else {
-            /* Init new box with `x`, `level`. */
-            (*nb)->x = x;
-            (*nb)->level = level;
-            (*nb)->next = new_next;
-            return 0;
-        }
+        (*nb)->x = x;
     }
+    (*nb)->level = level;
+    return 0;
 }
 
-static void free_boxes(struct boxes **fb)
+static void free_boxes(skiplist_t skiplist, struct boxes **fb)
 {
-    free((*fb)->next);
-    free(*fb);
+    mempool_release(skiplist->pools[(*fb)->level - 1], *fb);
     *fb = NULL;
 }
 
-int skiplist_new(skiplist_t *skiplist, comparator cmp)
+/*
+ * list_new - Create a new skiplist of elements, or of inline
+ * elements of size bytes
+ */
+static int list_new(skiplist_t *skiplist, const comparator cmp,
+        const size_t size)
 {
     skiplist_t new_skiplist;
     struct boxes *new_head;
+    size_t i;
 
     new_skiplist = (skiplist_t) malloc(sizeof(*new_skiplist));
     if (new_skiplist == NULL) {
         return -1;
-    } else {
-        /* Init head with value of 0. */
-        if (new_boxes(&new_head, 0, MAX_LEVEL) == -1){
-            free(new_skiplist);
+    }
+
+    /* Head is always full height, and holds no element. */
+    new_head = (struct boxes *) malloc(offsetof(struct boxes, lv)
+            + MAX_LEVEL * sizeof(new_head->lv[0]));
+    if (new_head == NULL) {
+        free(new_skiplist);
+        return -1;
+    }
+
+    new_head->x = NULL;
+    new_head->level = MAX_LEVEL;
+    for (i = 0; i < MAX_LEVEL; ++i) {
+        new_head->lv[i].next = NULL;
+        new_head->lv[i].span = 0;
+        new_skiplist->finger[i] = new_head;
+        new_skiplist->finger_rank[i] = 0;
+        new_skiplist->pools[i] = NULL;
+    }
+    new_skiplist->head = new_head;
+    new_skiplist->levels = 1;
+    new_skiplist->length = 0;
+    new_skiplist->cmp = (cmp != NULL) ? cmp : cmp_int;
+    new_skiplist->size = size;
+    new_skiplist->seed = new_seed();
+    new_skiplist->shift = __builtin_ctz(BRANCHING);
+
+    *skiplist = new_skiplist;
+    return 0;
+}
+
+int skiplist_new(skiplist_t *skiplist, comparator cmp)
+{
+    return list_new(skiplist, cmp, 0);
+}
+
+int skiplist_new_inline(skiplist_t *skiplist, comparator cmp, size_t size)
+{
+    return (size == 0) ? -1 : list_new(skiplist, cmp, size);
+}
+
+int skiplist_from_sorted(skiplist_t *skiplist, skiplistElem const elems[],
+        const size_t n, const comparator cmp)
+{
+    struct boxes *nb, *tail[MAX_LEVEL];
+    size_t i, k, level, tail_rank[MAX_LEVEL];
+
+    if (list_new(skiplist, cmp, 0) == -1) {
+        return -1;
+    }
+
+    for (k = 1; k < n; ++k) {
+        if ((*skiplist)->cmp(elems[k - 1], elems[k]) >= 0) {
+            skiplist_free(skiplist);
             return -1;
-        } else {
-            /* Init head with NULL pointers. */
-            int i;
-            for (i = 0; i < MAX_LEVEL; ++i) {
-                new_head->next[i] = NULL;
-            }
-            new_skiplist->head = new_head;
-            new_skiplist->levels = MAX_LEVEL;
-            new_skiplist->cmp = (cmp != NULL) ? cmp : cmp_int;
+        }
+    }
 
-            *skiplist = new_skiplist;
-            return 0;
+    /* Append each element after the last boxes of its levels. */
+    for (i = 0; i < MAX_LEVEL; ++i) {
+        tail[i] = (*skiplist)->head;
+        tail_rank[i] = 0;
+    }
+    for (k = 0; k < n; ++k) {
+        level = get_level(*skiplist);
+        if (new_boxes(*skiplist, &nb, elems[k], level) == -1) {
+            skiplist_free(skiplist);
+            return -1;
         }
+        for (i = 0; i < level; ++i) {
+            tail[i]->lv[i].next = nb;
+            tail[i]->lv[i].span = k + 1 - tail_rank[i];
+            tail[i] = nb;
+            tail_rank[i] = k + 1;
+        }
+        if ((*skiplist)->levels < level) {
+            (*skiplist)->levels = level;
+        }
+    }
+    for (i = 0; i < (*skiplist)->levels; ++i) {
+        tail[i]->lv[i].next = NULL;
+        tail[i]->lv[i].span = n - tail_rank[i];
     }
+    (*skiplist)->length = n;
+    return 0;
 }
 
 void skiplist_free(skiplist_t *skiplist)
 {
-    struct boxes *del, *cur;
+    size_t i;
 
-    cur = (*skiplist)->head;
-    while (cur != NULL) {
-        del = cur;
-        cur = cur->next[0];
-        free_boxes(&del);
+    /* Boxes go with their pools. */
+    for (i = 0; i < MAX_LEVEL; ++i) {
+        if ((*skiplist)->pools[i] != NULL) {
+            mempool_free(&(*skiplist)->pools[i]);
+        }
     }
+    free((*skiplist)->head);
     free(*skiplist);
     *skiplist = NULL;
 }
 
+/*
+ * set_finger - Keep prev pointers of a change for finger_search()
+ *
+ * Any change may leave the finger out of place, so every
+ * one of them sets it. The prev pointers are all before the
+ * change, so their positions stay right.
+ */
+static void set_finger(skiplist_t skiplist, struct boxes *update[],
+        size_t rank[])
+{
+    size_t i;
+
+    for (i = 0; i < skiplist->levels; ++i) {
+        skiplist->finger[i] = update[i];
+        skiplist->finger_rank[i] = rank[i];
+    }
+}
+
+int skiplist_set_branching(skiplist_t skiplist, unsigned int branching)
+{
+    if (branching < 2 || (branching & (branching - 1)) != 0) {
+        return -1;
+    } else {
+        skiplist->shift = __builtin_ctz(branching);
+        return 0;
+    }
+}
+
+/*
+ * insert_boxes - Link new boxes of x after prev pointers
+ *
+ * @skiplist: the skiplist
+ * @update: prev pointers in levels in use
+ * @rank: positions of prev pointers
+ * @x: input value
+ *
+ * Return 0 if success, -1 if out of memory.
+ */
+static int insert_boxes(skiplist_t skiplist, struct boxes *update[],
+        size_t rank[], const skiplistElem x)
+{
+    struct boxes *nb;   /* New boxes */
+    size_t i, level, skip;
+
+    /* Get a random level. */
+    level = get_level(skiplist);
+    if (new_boxes(skiplist, &nb, x, level) == -1) {
+        return -1;
+    }
+
+    /* New levels start at head. */
+    while (skiplist->levels < level) {
+        update[skiplist->levels] = skiplist->head;
+        rank[skiplist->levels] = 0;
+        skiplist->head->lv[skiplist->levels].span = skiplist->length;
+        skiplist->levels++;
+    }
+
+    /* Insert and update new boxes, splitting the spans. */
+    for (i = 0; i < level; ++i) {
+        skip = rank[0] - rank[i];
+        nb->lv[i].next = update[i]->lv[i].next;
+        nb->lv[i].span = update[i]->lv[i].span - skip;
+        update[i]->lv[i].next = nb;
+        update[i]->lv[i].span = skip + 1;
+    }
+    for (; i < skiplist->levels; ++i) {
+        update[i]->lv[i].span++;    /* Links over new boxes. */
+    }
+    skiplist->length++;
+    set_finger(skiplist, update, rank);
+    return 0;
+}
+
 int skiplist_add(skiplist_t skiplist, skiplistElem x)
 {
     /* 
@@ -135,62 +341,230 @@ int skiplist_add(skiplist_t skiplist, skiplistElem x)
      * to store prev pointers of new boxes.
      */
     struct boxes *p, *update[MAX_LEVEL];
-    struct boxes *nb;   /* New boxes */
+    size_t r, rank[MAX_LEVEL];
     comparator cmp;
     int i;
 
     p = skiplist->head;
     cmp = skiplist->cmp;
+    r = 0;
 
     /* Find the correct position to insert.  */
     for (i = skiplist->levels - 1; i >= 0; i--) {
-        while (p->next[i] && cmp(x, p->next[i]->x) > 0) {
-            p = p->next[i];
+        while (p->lv[i].next && cmp(x, p->lv[i].next->x) > 0) {
+            r += p->lv[i].span;
+            p = p->lv[i].next;
         }
-        if (p->next[i] != NULL && cmp(x, p->next[i]->x) == 0) {
+        if (p->lv[i].next != NULL && cmp(x, p->lv[i].next->x) == 0) {
             return 0;       /* Ignore dupllicate value. */
         } else {
             update[i] = p;  /* Memorizing prev pointers. */
+            rank[i] = r;
         }
     }
+    return insert_boxes(skiplist, update, rank, x);
+}
 
-    /* Get a random level by coin flip. */
-    size_t level = get_level();
-    if (new_boxes(&nb, x, level) == -1) {
-        return -1;
+/*
+ * finger_search - Find prev pointers of x, starting from the finger
+ *
+ * @skiplist: the skiplist
+ * @x: input value
+ * @update: output prev pointers
+ * @rank: output positions of prev pointers
+ *
+ * The finger is the last node before the last change at each
+ * level. Climb only while the finger is on the wrong side of x,
+ * the levels above are right as they are, then go down.
+ */
+static void finger_search(skiplist_t skiplist, const skiplistElem x,
+        struct boxes *update[], size_t rank[])
+{
+    struct boxes *p, *head, **finger;
+    size_t r;
+    comparator cmp;
+    int i, j, top;
+
+    head = skiplist->head;
+    finger = skiplist->finger;
+    cmp = skiplist->cmp;
+    top = skiplist->levels - 1;
+
+    i = 0;
+    if (finger[0] != head && cmp(x, finger[0]->x) <= 0) {
+        /* x is before the finger, climb until it is not. */
+        while (i < top && finger[i] != head && cmp(x, finger[i]->x) <= 0) {
+            i++;
+        }
     } else {
-        /* Insert and update new boxes */
-        for (i = 0; i < level; ++i) {
-            nb->next[i] = update[i]->next[i];
-            update[i]->next[i] = nb;
+        /* x is after the finger, climb while next is still before x. */
+        while (i < top && finger[i]->lv[i].next != NULL
+                && cmp(x, finger[i]->lv[i].next->x) > 0) {
+            i++;
         }
+    }
+
+    p = finger[i];
+    r = skiplist->finger_rank[i];
+    if (p != head && cmp(x, p->x) <= 0) {
+        p = head;   /* Even the top finger is after x. */
+        r = 0;
+    }
+    for (j = top; j > i; --j) {
+        update[j] = finger[j];
+        rank[j] = skiplist->finger_rank[j];
+    }
+    for (; i >= 0; --i) {
+        while (p->lv[i].next && cmp(x, p->lv[i].next->x) > 0) {
+            r += p->lv[i].span;
+            p = p->lv[i].next;
+        }
+        update[i] = p;
+        rank[i] = r;
+    }
+}
+
+int skiplist_add_hint(skiplist_t skiplist, skiplistElem x)
+{
+    struct boxes *update[MAX_LEVEL];
+    size_t rank[MAX_LEVEL];
+
+    finger_search(skiplist, x, update, rank);
+    if (update[0]->lv[0].next != NULL
+            && skiplist->cmp(x, update[0]->lv[0].next->x) == 0) {
+        return 0;       /* Ignore dupllicate value. */
+    }
+    return insert_boxes(skiplist, update, rank, x);
+}
+
+/*
+ * sort_elems - Merge sort n elements of a, with tmp of the same size
+ */
+static void sort_elems(const comparator cmp, skiplistElem a[],
+        skiplistElem tmp[], const size_t n)
+{
+    size_t half, i, j, k;
+
+    if (n < 2) {
+        return;
+    }
+    half = n / 2;
+    sort_elems(cmp, a, tmp, half);
+    sort_elems(cmp, a + half, tmp + half, n - half);
+    if (cmp(a[half - 1], a[half]) <= 0) {
+        return;     /* Halves already in order. */
+    }
+
+    i = 0;
+    j = half;
+    k = 0;
+    while (i < half && j < n) {
+        tmp[k++] = (cmp(a[j], a[i]) < 0) ? a[j++] : a[i++];
+    }
+    while (i < half) {
+        tmp[k++] = a[i++];
+    }
+    memcpy(a, tmp, k * sizeof(a[0]));
+}
+
+int skiplist_add_batch(skiplist_t skiplist, skiplistElem const elems[],
+        size_t n)
+{
+    struct boxes *p, *update[MAX_LEVEL];
+    skiplistElem *sorted, x;
+    size_t k, r, rank[MAX_LEVEL];
+    comparator cmp;
+    int i;
+
+    if (n == 0) {
         return 0;
     }
+    sorted = (skiplistElem *) malloc(2 * n * sizeof(sorted[0]));
+    if (sorted == NULL) {
+        return -1;
+    }
+    cmp = skiplist->cmp;
+    memcpy(sorted, elems, n * sizeof(sorted[0]));
+    sort_elems(cmp, sorted, sorted + n, n);
+
+    for (i = 0; i < (int) skiplist->levels; ++i) {
+        update[i] = skiplist->head;
+        rank[i] = 0;
+    }
+
+    /*
+     * Prev pointers of x are at or after those of the element
+     * before it, so each level goes on from the furthest of its
+     * own last prev pointer and the one found above.
+     */
+    for (k = 0; k < n; ++k) {
+        x = sorted[k];
+        p = NULL;
+        r = 0;
+        for (i = skiplist->levels - 1; i >= 0; --i) {
+            if (p == NULL || rank[i] > r) {
+                p = update[i];
+                r = rank[i];
+            }
+            while (p->lv[i].next && cmp(x, p->lv[i].next->x) > 0) {
+                r += p->lv[i].span;
+                p = p->lv[i].next;
+            }
+            update[i] = p;
+            rank[i] = r;
+        }
+        if (p->lv[0].next != NULL && cmp(x, p->lv[0].next->x) == 0) {
+            continue;       /* Ignore dupllicate value. */
+        }
+        if (insert_boxes(skiplist, update, rank, x) == -1) {
+            free(sorted);
+            return -1;
+        }
+    }
+    free(sorted);
+    return 0;
 }
 
 int skiplist_remove(skiplist_t skiplist, skiplistElem x)
 {
     struct boxes *p, *q, *update[MAX_LEVEL];
+    size_t r, rank[MAX_LEVEL];
     comparator cmp;
     int i;
 
     p = skiplist->head;
     cmp = skiplist->cmp;
+    r = 0;
 
     for (i = skiplist->levels - 1; i >= 0; i--) {
-        while (p->next[i] && cmp(x, p->next[i]->x) > 0) {
-            p = p->next[i];     /* Level scan. */
+        while (p->lv[i].next && cmp(x, p->lv[i].next->x) > 0) {
+            r += p->lv[i].span;
+            p = p->lv[i].next;     /* Level scan. */
         }
         update[i] = p;   /* Save prev pointers for updating later on. */
+        rank[i] = r;
     }
 
     /* Found and remove. */
-    if (p->next[0] != NULL && cmp(x, p->next[0]->x) == 0) {
-        q = p->next[0];
-        for (i = q->level - 1; i >= 0; i--) {
-            update[i]->next[i] = q->next[i];    /* Update. */
+    if (p->lv[0].next != NULL && cmp(x, p->lv[0].next->x) == 0) {
+        q = p->lv[0].next;
+        for (i = skiplist->levels - 1; i >= 0; i--) {
+            if (update[i]->lv[i].next == q) {    /* Update. */
+                update[i]->lv[i].span += q->lv[i].span - 1;
+                update[i]->lv[i].next = q->lv[i].next;
+            } else {
+                update[i]->lv[i].span--;
+            }
+        }
+        free_boxes(skiplist, &q);
+        skiplist->length--;
+
+        /* Drop levels left empty. */
+        while (skiplist->levels > 1
+                && skiplist->head->lv[skiplist->levels - 1].next == NULL) {
+            skiplist->levels--;
         }
-        free_boxes(&q);
+        set_finger(skiplist, update, rank);
         return 0;
     } else {
         return -1;   /* Not found. */
@@ -206,12 +580,93 @@ int skiplist_contains(skiplist_t skiplist, skiplistElem x)
     p = skiplist->head;
     cmp = skiplist->cmp;
     for (i = skiplist->levels - 1; i >= 0; i--) {
-        while (p->next[i] && cmp(x, p->next[i]->x) > 0) {  /* Level scan. */
-            p = p->next[i];
+        while (p->lv[i].next && cmp(x, p->lv[i].next->x) > 0) {  /* Level scan. */
+            p = p->lv[i].next;
         }
-        if (p->next[i] != NULL && cmp(x, p->next[i]->x) == 0) {
+        if (p->lv[i].next != NULL && cmp(x, p->lv[i].next->x) == 0) {
             return 1;       /* Found it. */
         }
     }
     return 0;   /* Not found. */
 }
+
+size_t skiplist_get_size(skiplist_t skiplist)
+{
+    return skiplist->length;
+}
+
+size_t skiplist_rank(skiplist_t skiplist, skiplistElem x)
+{
+    struct boxes *p;
+    comparator cmp;
+    size_t r;
+    int i;
+
+    p = skiplist->head;
+    cmp = skiplist->cmp;
+    r = 0;
+    for (i = skiplist->levels - 1; i >= 0; i--) {
+        while (p->lv[i].next && cmp(x, p->lv[i].next->x) > 0) {
+            r += p->lv[i].span;
+            p = p->lv[i].next;
+        }
+    }
+    return r;
+}
+
+/*
+ * boxes_at - Find boxes at 1-based position pos
+ *
+ * Jump along a level while its span still stays within pos.
+ */
+static struct boxes *boxes_at(skiplist_t skiplist, const size_t pos)
+{
+    struct boxes *p;
+    size_t r;
+    int i;
+
+    p = skiplist->head;
+    r = 0;
+    for (i = skiplist->levels - 1; i >= 0; i--) {
+        while (p->lv[i].next && r + p->lv[i].span <= pos) {
+            r += p->lv[i].span;
+            p = p->lv[i].next;
+        }
+        if (r == pos) {
+            break;
+        }
+    }
+    return p;
+}
+
+int skiplist_at(skiplist_t skiplist, size_t k, skiplistElem *x)
+{
+    if (k >= skiplist->length) {
+        return -1;
+    } else {
+        *x = boxes_at(skiplist, k + 1)->x;
+        return 0;
+    }
+}
+
+size_t skiplist_range_by_rank(skiplist_t skiplist, size_t lo, size_t hi,
+        skiplist_visitor visit, void *arg)
+{
+    struct boxes *p;
+    size_t count;
+
+    if (lo > hi || lo >= skiplist->length) {
+        return 0;
+    }
+
+    count = 0;
+    p = boxes_at(skiplist, lo + 1);
+    while (p != NULL && lo + count <= hi) {
+        count++;
+        if (visit(p->x, arg) != 0) {
+            break;
+        }
+        p = p->lv[0].next;
+    }
+    return count;
+}
@@ -0,0 +1,326 @@
+/*
+ * timer-wheel.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "timer-wheel.h"
+
+/*
+ * Level 0 has 256 slots of one tick, the other four levels
+ * have 64 slots each, which covers 2^32 ticks in total.
+ * Timers further than that are parked in the last level
+ * and cascade down as the wheel turns.
+ */
+#define TVR_BITS 8
+#define TVN_BITS 6
+#define TVR_SIZE (1 << TVR_BITS)
+#define TVN_SIZE (1 << TVN_BITS)
+#define TVR_MASK (TVR_SIZE - 1)
+#define TVN_MASK (TVN_SIZE - 1)
+#define TVN_LEVELS 4
+#define MAX_TIMEOUT 0xffffffffUL
+
+struct list {       /* Circular doubly linked list. */
+    struct list *next;
+    struct list *prev;
+};
+
+struct _twtimer {
+    struct list link;       /* Must be the first member. */
+    unsigned long expires;
+    timerWheelElem x;
+};
+
+struct _timerwheel {
+    unsigned long now;      /* Next tick to be processed. */
+    size_t count;           /* Count of pending timers. */
+    struct _twtimer *spare; /* Recycled timers. */
+    struct list expired;    /* Scheduled behind now, fire at once. */
+    struct list tv1[TVR_SIZE];
+    struct list tvn[TVN_LEVELS][TVN_SIZE];
+};
+
+static void list_init(struct list *head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+static int list_isempty(struct list *head)
+{
+    return head->next == head;
+}
+
+static void list_add_tail(struct list *head, struct list *e)
+{
+    e->prev = head->prev;
+    e->next = head;
+    head->prev->next = e;
+    head->prev = e;
+}
+
+static void list_del(struct list *e)
+{
+    e->prev->next = e->next;
+    e->next->prev = e->prev;
+}
+
+/*
+ * list_splice - Move every entry of src to an empty dst
+ */
+static void list_splice(struct list *src, struct list *dst)
+{
+    if (list_isempty(src)) {
+        list_init(dst);
+    } else {
+        *dst = *src;
+        dst->next->prev = dst;
+        dst->prev->next = dst;
+        list_init(src);
+    }
+}
+
+/*
+ * internal_add - Put a timer into the slot matching its expiry
+ */
+static void internal_add(timerwheel_t tw, struct _twtimer *t)
+{
+    unsigned long expires;
+    unsigned long idx;
+    struct list *vec;
+    int level;
+
+    expires = t->expires;
+    idx = expires - tw->now;
+
+    if ((long) idx < 0) {
+        /* Its tick is processed already, fire on next advance. */
+        vec = &tw->expired;
+
+    } else if (idx < TVR_SIZE) {
+        vec = &tw->tv1[expires & TVR_MASK];
+
+    } else {
+        if (idx > MAX_TIMEOUT) {
+            idx = MAX_TIMEOUT;
+            expires = tw->now + idx;
+        }
+        level = 0;
+        while (level < TVN_LEVELS - 1
+                && idx >= 1UL << (TVR_BITS + (level + 1) * TVN_BITS)) {
+            level++;
+        }
+        vec = &tw->tvn[level][(expires >> (TVR_BITS + level * TVN_BITS))
+                              & TVN_MASK];
+    }
+    list_add_tail(vec, &t->link);
+}
+
+/*
+ * cascade - Move timers of an upper slot into lower levels
+ *
+ * Return index of the slot.
+ */
+static int cascade(timerwheel_t tw, int level, int index)
+{
+    struct list work;
+    struct _twtimer *t;
+
+    list_splice(&tw->tvn[level][index], &work);
+    while (!list_isempty(&work)) {
+        t = (struct _twtimer *) work.next;
+        list_del(&t->link);
+        internal_add(tw, t);
+    }
+    return index;
+}
+
+static void free_list(struct list *head)
+{
+    struct list *p, *del;
+
+    p = head->next;
+    while (p != head) {
+        del = p;
+        p = p->next;
+        free(del);
+    }
+}
+
+/*
+ * recycle - Put a timer on spare list for later reuse
+ */
+static void recycle(timerwheel_t tw, struct _twtimer *t)
+{
+    t->link.next = (struct list *) tw->spare;
+    tw->spare = t;
+}
+
+int timerwheel_new(timerwheel_t *tw, const unsigned long now)
+{
+    timerwheel_t new_tw;
+    int i, j;
+
+    new_tw = (timerwheel_t) malloc(sizeof(*new_tw));
+    if (new_tw == NULL) {
+        return -1;
+    } else {
+        for (i = 0; i < TVR_SIZE; ++i) {
+            list_init(&new_tw->tv1[i]);
+        }
+        for (i = 0; i < TVN_LEVELS; ++i) {
+            for (j = 0; j < TVN_SIZE; ++j) {
+                list_init(&new_tw->tvn[i][j]);
+            }
+        }
+        list_init(&new_tw->expired);
+        new_tw->now = now;
+        new_tw->count = 0;
+        new_tw->spare = NULL;
+        *tw = new_tw;
+        return 0;
+    }
+}
+
+void timerwheel_free(timerwheel_t *tw)
+{
+    struct _twtimer *t;
+    int i, j;
+
+    for (i = 0; i < TVR_SIZE; ++i) {
+        free_list(&(*tw)->tv1[i]);
+    }
+    for (i = 0; i < TVN_LEVELS; ++i) {
+        for (j = 0; j < TVN_SIZE; ++j) {
+            free_list(&(*tw)->tvn[i][j]);
+        }
+    }
+    free_list(&(*tw)->expired);
+    while ((*tw)->spare != NULL) {
+        t = (*tw)->spare;
+        (*tw)->spare = (struct _twtimer *) t->link.next;
+        free(t);
+    }
+    free(*tw);
+    *tw = NULL;
+}
+
+int timerwheel_schedule(timerwheel_t tw, twtimer_t *timer,
+        const unsigned long expires, const timerWheelElem x)
+{
+    struct _twtimer *t;
+
+    if (tw->spare != NULL) {
+        t = tw->spare;
+        tw->spare = (struct _twtimer *) t->link.next;
+    } else {
+        t = (struct _twtimer *) malloc(sizeof(*t));
+        if (t == NULL) {
+            return -1;
+        }
+    }
+
+    t->expires = expires;
+    t->x = x;
+    internal_add(tw, t);
+    tw->count++;
+    *timer = t;
+    return 0;
+}
+
+void timerwheel_reschedule(timerwheel_t tw, twtimer_t timer,
+        const unsigned long expires)
+{
+    list_del(&timer->link);
+    timer->expires = expires;
+    internal_add(tw, timer);
+}
+
+int timerwheel_cancel(timerwheel_t tw, twtimer_t *timer)
+{
+    if (*timer == NULL) {
+        return -1;
+    } else {
+        list_del(&(*timer)->link);
+        recycle(tw, *timer);
+        tw->count--;
+        *timer = NULL;
+        return 0;
+    }
+}
+
+/*
+ * fire_list - Fire and recycle every timer of a list
+ *
+ * Return count of fired timers.
+ */
+static size_t fire_list(timerwheel_t tw, struct list *head,
+        timerwheel_callback cb)
+{
+    struct list work;
+    struct _twtimer *t;
+    timerWheelElem x;
+    size_t fired;
+
+    /* Callbacks may add to head, work on a copy. */
+    fired = 0;
+    list_splice(head, &work);
+    while (!list_isempty(&work)) {
+        t = (struct _twtimer *) work.next;
+        list_del(&t->link);
+        x = t->x;
+        recycle(tw, t);
+        tw->count--;
+        cb(x);
+        fired++;
+    }
+    return fired;
+}
+
+size_t timerwheel_advance(timerwheel_t tw, const unsigned long now,
+        timerwheel_callback cb)
+{
+    size_t fired;
+    int index, level;
+
+    fired = fire_list(tw, &tw->expired, cb);
+    while ((long) (now - tw->now) >= 0) {
+        if (tw->count == 0) {
+            tw->now = now + 1;  /* Nothing to cascade or fire, jump. */
+            break;
+        }
+
+        /* Level 0 wrapped around, pull timers down from upper levels. */
+        index = tw->now & TVR_MASK;
+        if (index == 0) {
+            for (level = 0; level < TVN_LEVELS; ++level) {
+                if (cascade(tw, level, (tw->now >> (TVR_BITS
+                                + level * TVN_BITS)) & TVN_MASK) != 0) {
+                    break;
+                }
+            }
+        }
+        tw->now++;
+        fired += fire_list(tw, &tw->tv1[index], cb);
+    }
+    return fired;
+}
+
+size_t timerwheel_get_size(timerwheel_t tw)
+{
+    return tw->count;
+}
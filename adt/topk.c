@@ -0,0 +1,142 @@
+/*
+ * topk.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "binary-minheap.h"
+#include "topk.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+struct _topk {
+    binary_minheap_t heap;  /* k largest elements, root is threshold */
+    size_t k;
+    comparator cmp;
+};
+
+int topk_new(topk_t *topk, const size_t k, const comparator cmp)
+{
+    topk_t new_topk;
+
+    new_topk = (topk_t) malloc(sizeof(*new_topk));
+    if (new_topk == NULL) {
+        return -1;
+    }
+
+    if (binary_minheap_new(&new_topk->heap, k, cmp) == -1) {
+        free(new_topk);
+        return -1;
+    } else {
+        new_topk->k = k;
+        new_topk->cmp = (cmp != NULL) ? cmp : cmp_int;
+        *topk = new_topk;
+        return 0;
+    }
+}
+
+void topk_free(topk_t *topk)
+{
+    binary_minheap_free(&(*topk)->heap);
+    free(*topk);
+    *topk = NULL;
+}
+
+int topk_add(topk_t topk, const topkElem x)
+{
+    binaryMinHeapElem top;
+
+    if (!binary_minheap_isfull(topk->heap)) {
+        return binary_minheap_add(topk->heap, x) == 0;
+
+    } else if (topk->k == 0) {
+        return 0;
+
+    } else {
+        binary_minheap_peek(topk->heap, &top);
+        if (topk->cmp(x, top) <= 0) {
+            return 0;   /* Not larger than threshold, reject. */
+        } else {
+            binary_minheap_replace(topk->heap, x, &top);
+            return 1;
+        }
+    }
+}
+
+size_t topk_add_ints(topk_t topk, const int *xs, const size_t n)
+{
+    size_t i, kept;
+
+    kept = 0;
+    i = 0;
+
+    /* Fill the heap first, there is no threshold yet. */
+    while (i < n && !binary_minheap_isfull(topk->heap)) {
+        kept += topk_add(topk, (topkElem) &xs[i++]);
+    }
+
+    if (topk->k == 0) {
+        return kept;
+    }
+
+#ifdef __SSE2__
+    if (topk->cmp == cmp_int) {
+        binaryMinHeapElem top;
+        __m128i thr;
+
+        binary_minheap_peek(topk->heap, &top);
+        thr = _mm_set1_epi32(*(int *) top);
+
+        for (; i + 4 <= n; i += 4) {
+            __m128i v;
+            size_t j;
+
+            v = _mm_loadu_si128((const __m128i *) &xs[i]);
+            if (_mm_movemask_epi8(_mm_cmpgt_epi32(v, thr)) == 0) {
+                continue;   /* Whole block rejected. */
+            }
+
+            for (j = i; j < i + 4; ++j) {
+                kept += topk_add(topk, (topkElem) &xs[j]);
+            }
+            binary_minheap_peek(topk->heap, &top);
+            thr = _mm_set1_epi32(*(int *) top);
+        }
+    }
+#endif
+
+    /* Tail, or comparator other than cmp_int. */
+    for (; i < n; ++i) {
+        kept += topk_add(topk, (topkElem) &xs[i]);
+    }
+    return kept;
+}
+
+int topk_peek(topk_t topk, topkElem *x)
+{
+    return binary_minheap_peek(topk->heap, x);
+}
+
+int topk_poll(topk_t topk, topkElem *x)
+{
+    return binary_minheap_poll(topk->heap, x);
+}
+
+size_t topk_get_size(topk_t topk)
+{
+    return binary_minheap_get_size(topk->heap);
+}
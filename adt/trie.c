@@ -15,119 +15,753 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "trie.h"
+
 /*
- * Only support 26 lower case letters for now.
- * We can extend it in the future to support more.
+ * The trie is an adaptive radix tree (Leis et al., ICDE 2013),
+ * after libart. Inner nodes take one of 4 sizes by their count
+ * of children, and grow or shrink between them. A chain of
+ * nodes with a single child is collapsed into a prefix of the
+ * node below, of which MAX_PREFIX bytes are kept; the rest is
+ * checked against a leaf when needed.
+ *
+ * Words are keyed with their trailing '\0', so no key is the
+ * prefix of another, and leaves are only found at the bottom.
  */
-#define ALPHABAT_SIZE 26
+#define MAX_PREFIX  8
+
+#define IS_LEAF(p)  (((uintptr_t) (p) & 1) != 0)
+#define LEAF(p)     ((struct leaf *) ((uintptr_t) (p) & ~(uintptr_t) 1))
+#define TAG(l)      ((struct node *) ((uintptr_t) (l) | 1))
+
+#define MIN(a, b)   ((a) < (b) ? (a) : (b))
+
+enum node_type {
+    NODE4,
+    NODE16,
+    NODE48,
+    NODE256,
+};
+
+struct node {
+    unsigned char type;
+    unsigned short count;           /* Count of children. */
+    unsigned int prefix_len;
+    unsigned char prefix[MAX_PREFIX];
+};
+
+/* Keys in order, children beside them. */
+struct node4 {
+    struct node n;
+    unsigned char keys[4];
+    struct node *children[4];
+};
+
+struct node16 {
+    struct node n;
+    unsigned char keys[16];
+    struct node *children[16];
+};
+
+/* Slot + 1 of each byte, 0 if none. */
+struct node48 {
+    struct node n;
+    unsigned char index[256];
+    struct node *children[48];
+};
+
+struct node256 {
+    struct node n;
+    struct node *children[256];
+};
+
+/* Leaves are tagged pointers in child slots. */
+struct leaf {
+    size_t len;                     /* Key length with '\0'. */
+    unsigned char key[];
+};
 
 struct _trie {
-    char c;
-    int eow;           /* End of word, which means if it is a word. */
-    size_t count;       /* Frequency. */
-    struct _trie *children[ALPHABAT_SIZE];
+    struct node *root;
+    size_t size;
 };
 
-static int get_index(char c)
+static struct node *new_node(const enum node_type type)
 {
-    return c - 'a';
+    static const size_t sizes[] = {
+        sizeof(struct node4), sizeof(struct node16),
+        sizeof(struct node48), sizeof(struct node256),
+    };
+    struct node *n;
+
+    n = (struct node *) calloc(1, sizes[type]);
+    if (n != NULL) {
+        n->type = type;
+    }
+    return n;
 }
 
-static int new_trie_node(trie_t *trie, char c)
+static struct leaf *new_leaf(const unsigned char *key, const size_t len)
 {
-    *trie = (trie_t) malloc(sizeof(struct _trie));
+    struct leaf *l;
 
-    if (*trie == NULL) {
-        return -1;
-    } else {
-        /* Initialize node. */
-        (*trie)->c = c;
-        (*trie)->count = 1;
-        memset((*trie)->children, 0, ALPHABAT_SIZE * sizeof(struct _trie *));
-        return 0;
+    l = (struct leaf *) malloc(sizeof(*l) + len);
+    if (l != NULL) {
+        l->len = len;
+        memcpy(l->key, key, len);
     }
+    return l;
+}
+
+static void free_node(struct node *n)
+{
+    union {
+        struct node4 *p4;
+        struct node16 *p16;
+        struct node48 *p48;
+        struct node256 *p256;
+    } p;
+    int i;
+
+    if (n == NULL) {
+        return;
+    } else if (IS_LEAF(n)) {
+        free(LEAF(n));
+        return;
+    }
+
+    switch (n->type) {
+    case NODE4:
+        p.p4 = (struct node4 *) n;
+        for (i = 0; i < n->count; ++i) {
+            free_node(p.p4->children[i]);
+        }
+        break;
+    case NODE16:
+        p.p16 = (struct node16 *) n;
+        for (i = 0; i < n->count; ++i) {
+            free_node(p.p16->children[i]);
+        }
+        break;
+    case NODE48:
+        p.p48 = (struct node48 *) n;
+        for (i = 0; i < 256; ++i) {
+            if (p.p48->index[i] != 0) {
+                free_node(p.p48->children[p.p48->index[i] - 1]);
+            }
+        }
+        break;
+    case NODE256:
+        p.p256 = (struct node256 *) n;
+        for (i = 0; i < 256; ++i) {
+            free_node(p.p256->children[i]);
+        }
+        break;
+    }
+    free(n);
 }
 
 int trie_new(trie_t *trie)
 {
-    /* Have a root with '\0'. */
-    if (new_trie_node(trie, '\0') == -1) {
+    trie_t new_trie;
+
+    new_trie = (trie_t) malloc(sizeof(*new_trie));
+    if (new_trie == NULL) {
         return -1;
     } else {
-        (*trie)->eow = 1;
+        new_trie->root = NULL;
+        new_trie->size = 0;
+        *trie = new_trie;
         return 0;
     }
 }
 
 void trie_free(trie_t *trie)
 {
+    free_node((*trie)->root);
+    free(*trie);
+    *trie = NULL;
+}
+
+/*
+ * find_child - Find the slot of child by byte c
+ *
+ * Return the slot, or NULL if no such child.
+ */
+static struct node **find_child(struct node *n, const unsigned char c)
+{
+    struct node4 *p4;
+    struct node16 *p16;
+    struct node48 *p48;
     int i;
+#ifdef __SSE2__
+    __m128i cmp;
+    int mask;
+#endif
 
-    if (*trie == NULL) {
-        return;
-    } else {
-        for (i = 0; i < ALPHABAT_SIZE; ++i) {
-            trie_free(&(*trie)->children[i]);
+    switch (n->type) {
+    case NODE4:
+        p4 = (struct node4 *) n;
+        for (i = 0; i < n->count; ++i) {
+            if (p4->keys[i] == c) {
+                return &p4->children[i];
+            }
+        }
+        break;
+    case NODE16:
+        p16 = (struct node16 *) n;
+#ifdef __SSE2__
+        /* Compare all 16 keys at once. */
+        cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char) c),
+                _mm_loadu_si128((__m128i *) p16->keys));
+        mask = _mm_movemask_epi8(cmp) & ((1 << n->count) - 1);
+        if (mask != 0) {
+            return &p16->children[__builtin_ctz(mask)];
         }
-        free(*trie);
+#else
+        for (i = 0; i < n->count; ++i) {
+            if (p16->keys[i] == c) {
+                return &p16->children[i];
+            }
+        }
+#endif
+        break;
+    case NODE48:
+        p48 = (struct node48 *) n;
+        if (p48->index[c] != 0) {
+            return &p48->children[p48->index[c] - 1];
+        }
+        break;
+    case NODE256:
+        if (((struct node256 *) n)->children[c] != NULL) {
+            return &((struct node256 *) n)->children[c];
+        }
+        break;
     }
-    *trie = NULL;
+    return NULL;
 }
 
-int trie_add(trie_t trie, const char *word)
+/*
+ * minimum - Find the leftmost leaf under n
+ */
+static struct leaf *minimum(struct node *n)
 {
-    int i, j;
-    const char *p = word;
+    struct node48 *p48;
+    struct node256 *p256;
+    int i;
 
-    while (*p) {
-        i = get_index(*p);
-        if (trie->children[i] == NULL) {     /* Need to alloc new node. */
-            if (new_trie_node(&trie->children[i], *p) == -1) {
-                return -1;
+    while (!IS_LEAF(n)) {
+        switch (n->type) {
+        case NODE4:
+            n = ((struct node4 *) n)->children[0];
+            break;
+        case NODE16:
+            n = ((struct node16 *) n)->children[0];
+            break;
+        case NODE48:
+            p48 = (struct node48 *) n;
+            for (i = 0; p48->index[i] == 0; ++i) {
+                ;
+            }
+            n = p48->children[p48->index[i] - 1];
+            break;
+        case NODE256:
+            p256 = (struct node256 *) n;
+            for (i = 0; p256->children[i] == NULL; ++i) {
+                ;
             }
+            n = p256->children[i];
+            break;
         }
-        trie = trie->children[i];
-        p++;
     }
-    trie->eow = 1;
-    trie->count++;
-    return 0;
+    return LEAF(n);
 }
 
-int trie_contains(trie_t trie, const char *word)
+/*
+ * check_prefix - Count bytes of key matching the kept prefix of n
+ */
+static size_t check_prefix(const struct node *n, const unsigned char *key,
+        const size_t len, const size_t depth)
 {
+    size_t i, max;
+
+    max = MIN(MIN(n->prefix_len, MAX_PREFIX), len - depth);
+    for (i = 0; i < max && n->prefix[i] == key[depth + i]; ++i) {
+        ;
+    }
+    return i;
+}
+
+/*
+ * prefix_mismatch - Count bytes of key matching the prefix of n
+ *
+ * Bytes past the kept ones are read from a leaf, and the count
+ * may go beyond the prefix then.
+ */
+static size_t prefix_mismatch(struct node *n, const unsigned char *key,
+        const size_t len, const size_t depth)
+{
+    struct leaf *l;
+    size_t i, max;
+
+    i = check_prefix(n, key, len, depth);
+    if (i < MAX_PREFIX || n->prefix_len <= MAX_PREFIX) {
+        return i;
+    }
+
+    l = minimum(n);
+    max = MIN(l->len, len) - depth;
+    for (; i < max && l->key[depth + i] == key[depth + i]; ++i) {
+        ;
+    }
+    return i;
+}
+
+static int leaf_matches(const struct leaf *l, const unsigned char *key,
+        const size_t len)
+{
+    return l->len == len && memcmp(l->key, key, len) == 0;
+}
+
+static void copy_header(struct node *dst, const struct node *src)
+{
+    dst->count = src->count;
+    dst->prefix_len = src->prefix_len;
+    memcpy(dst->prefix, src->prefix, MIN(src->prefix_len, MAX_PREFIX));
+}
+
+/*
+ * add_child - Add child by byte c to n at *ref, growing n if full
+ *
+ * Return 0 if success, -1 if out of memory.
+ */
+static int add_child(struct node **ref, struct node *n,
+        const unsigned char c, struct node *child)
+{
+    union {
+        struct node4 *p4;
+        struct node16 *p16;
+        struct node48 *p48;
+        struct node256 *p256;
+    } p, q;
+    struct node *nn = NULL;
     int i;
-    const char *p = word;
 
-    while (*p) {
-        i = get_index(*p);
-        if (trie->children[i] == NULL) {
+    switch (n->type) {
+    case NODE4:
+    case NODE16:
+        p.p16 = (struct node16 *) n;
+        if (n->count < (n->type == NODE4 ? 4 : 16)) {
+            /* node4 and node16 share the layout up to keys. */
+            if (n->type == NODE4) {
+                for (i = n->count; i > 0 && p.p4->keys[i - 1] > c; --i) {
+                    p.p4->keys[i] = p.p4->keys[i - 1];
+                    p.p4->children[i] = p.p4->children[i - 1];
+                }
+                p.p4->keys[i] = c;
+                p.p4->children[i] = child;
+            } else {
+                for (i = n->count; i > 0 && p.p16->keys[i - 1] > c; --i) {
+                    p.p16->keys[i] = p.p16->keys[i - 1];
+                    p.p16->children[i] = p.p16->children[i - 1];
+                }
+                p.p16->keys[i] = c;
+                p.p16->children[i] = child;
+            }
+            n->count++;
             return 0;
+        }
+
+        nn = new_node(n->type == NODE4 ? NODE16 : NODE48);
+        if (nn == NULL) {
+            return -1;
+        }
+        copy_header(nn, n);
+        if (n->type == NODE4) {
+            q.p16 = (struct node16 *) nn;
+            memcpy(q.p16->keys, p.p4->keys, 4);
+            memcpy(q.p16->children, p.p4->children, 4 * sizeof(nn));
         } else {
-            trie = trie->children[i];
-            p++;
+            q.p48 = (struct node48 *) nn;
+            for (i = 0; i < 16; ++i) {
+                q.p48->index[p.p16->keys[i]] = i + 1;
+            }
+            memcpy(q.p48->children, p.p16->children, 16 * sizeof(nn));
+        }
+        break;
+    case NODE48:
+        p.p48 = (struct node48 *) n;
+        if (n->count < 48) {
+            for (i = 0; p.p48->children[i] != NULL; ++i) {
+                ;
+            }
+            p.p48->children[i] = child;
+            p.p48->index[c] = i + 1;
+            n->count++;
+            return 0;
+        }
+
+        nn = new_node(NODE256);
+        if (nn == NULL) {
+            return -1;
+        }
+        copy_header(nn, n);
+        q.p256 = (struct node256 *) nn;
+        for (i = 0; i < 256; ++i) {
+            if (p.p48->index[i] != 0) {
+                q.p256->children[i] = p.p48->children[p.p48->index[i] - 1];
+            }
         }
+        break;
+    case NODE256:
+        ((struct node256 *) n)->children[c] = child;
+        n->count++;
+        return 0;
     }
-    return trie->eow;
+
+    /* Grown, add to the new node which has room. */
+    free(n);
+    *ref = nn;
+    return add_child(ref, nn, c, child);
 }
 
-int trie_startswith(trie_t trie, const char *word)
+/*
+ * insert - Add key of len bytes under *ref at depth
+ *
+ * Return 1 if added, 0 if already there, -1 if out of memory.
+ */
+static int insert(struct node **ref, const unsigned char *key,
+        const size_t len, size_t depth)
 {
-    int i;
-    const char *p = word;
+    struct node *n, *nn, **child;
+    struct leaf *l, *old;
+    size_t i, diff;
 
-    while (*p) {
-        i = get_index(*p);
-        if (trie->children[i] == NULL) {
+    n = *ref;
+    if (n == NULL) {
+        l = new_leaf(key, len);
+        if (l == NULL) {
+            return -1;
+        }
+        *ref = TAG(l);
+        return 1;
+    }
+
+    if (IS_LEAF(n)) {
+        old = LEAF(n);
+        if (leaf_matches(old, key, len)) {
             return 0;
-        } else {
-            trie = trie->children[i];
-            p++;
         }
+
+        /* Split the leaf by a node4 of their common prefix. */
+        for (i = depth; old->key[i] == key[i]; ++i) {
+            ;
+        }
+        nn = new_node(NODE4);
+        l = new_leaf(key, len);
+        if (nn == NULL || l == NULL) {
+            free(nn);
+            free(l);
+            return -1;
+        }
+        nn->prefix_len = i - depth;
+        memcpy(nn->prefix, key + depth, MIN(nn->prefix_len, MAX_PREFIX));
+        add_child(&nn, nn, old->key[i], n);
+        add_child(&nn, nn, key[i], TAG(l));
+        *ref = nn;
+        return 1;
+    }
+
+    if (n->prefix_len != 0) {
+        diff = prefix_mismatch(n, key, len, depth);
+        if (diff < n->prefix_len) {
+            /* Split the prefix by a node4 above n. */
+            nn = new_node(NODE4);
+            l = new_leaf(key, len);
+            if (nn == NULL || l == NULL) {
+                free(nn);
+                free(l);
+                return -1;
+            }
+            nn->prefix_len = diff;
+            memcpy(nn->prefix, n->prefix, MIN(diff, MAX_PREFIX));
+
+            if (n->prefix_len <= MAX_PREFIX) {
+                add_child(&nn, nn, n->prefix[diff], n);
+                n->prefix_len -= diff + 1;
+                memmove(n->prefix, n->prefix + diff + 1,
+                        MIN(n->prefix_len, MAX_PREFIX));
+            } else {
+                /* Lost bytes of the prefix come back from a leaf. */
+                old = minimum(n);
+                add_child(&nn, nn, old->key[depth + diff], n);
+                n->prefix_len -= diff + 1;
+                memcpy(n->prefix, old->key + depth + diff + 1,
+                        MIN(n->prefix_len, MAX_PREFIX));
+            }
+            add_child(&nn, nn, key[depth + diff], TAG(l));
+            *ref = nn;
+            return 1;
+        }
+        depth += n->prefix_len;
+    }
+
+    child = find_child(n, key[depth]);
+    if (child != NULL) {
+        return insert(child, key, len, depth + 1);
+    }
+
+    l = new_leaf(key, len);
+    if (l == NULL) {
+        return -1;
+    } else if (add_child(ref, n, key[depth], TAG(l)) == -1) {
+        free(l);
+        return -1;
     }
     return 1;
-}
\ No newline at end of file
+}
+
+int trie_add(trie_t trie, const char *word)
+{
+    int res;
+
+    res = insert(&trie->root, (const unsigned char *) word,
+            strlen(word) + 1, 0);
+    if (res == 1) {
+        trie->size++;
+    }
+    return (res == -1) ? -1 : 0;
+}
+
+int trie_contains(trie_t trie, const char *word)
+{
+    const unsigned char *key;
+    struct node *n, **child;
+    size_t depth, len;
+
+    key = (const unsigned char *) word;
+    len = strlen(word) + 1;
+    n = trie->root;
+    depth = 0;
+
+    /* Skip prefixes on kept bytes, the leaf tells at last. */
+    while (n != NULL) {
+        if (IS_LEAF(n)) {
+            return leaf_matches(LEAF(n), key, len);
+        }
+        if (n->prefix_len != 0) {
+            if (check_prefix(n, key, len, depth)
+                    != MIN(n->prefix_len, MAX_PREFIX)) {
+                return 0;
+            }
+            depth += n->prefix_len;
+            if (depth >= len) {
+                return 0;
+            }
+        }
+        child = find_child(n, key[depth]);
+        n = (child != NULL) ? *child : NULL;
+        depth++;
+    }
+    return 0;
+}
+
+int trie_startswith(trie_t trie, const char *prefix)
+{
+    const unsigned char *key;
+    struct node *n, **child;
+    struct leaf *l;
+    size_t depth, len, diff;
+
+    key = (const unsigned char *) prefix;
+    len = strlen(prefix);       /* Without '\0'. */
+    n = trie->root;
+    depth = 0;
+
+    while (n != NULL) {
+        if (IS_LEAF(n)) {
+            l = LEAF(n);
+            return l->len > len && memcmp(l->key, key, len) == 0;
+        } else if (depth == len) {
+            return 1;
+        }
+        if (n->prefix_len != 0) {
+            diff = prefix_mismatch(n, key, len, depth);
+            if (depth + diff == len) {
+                return 1;   /* Ends inside the prefix. */
+            } else if (diff < n->prefix_len) {
+                return 0;
+            }
+            depth += n->prefix_len;
+            if (depth == len) {
+                return 1;
+            }
+        }
+        child = find_child(n, key[depth]);
+        n = (child != NULL) ? *child : NULL;
+        depth++;
+    }
+    return 0;
+}
+
+/*
+ * remove_child - Remove child slot of byte c from n at *ref,
+ * shrinking n if it gets sparse
+ *
+ * A node4 left with a single child is replaced by it, and
+ * gives it its own prefix and the byte in between.
+ */
+static void remove_child(struct node **ref, struct node *n,
+        const unsigned char c, struct node **slot)
+{
+    union {
+        struct node4 *p4;
+        struct node16 *p16;
+        struct node48 *p48;
+        struct node256 *p256;
+    } p, q;
+    struct node *nn = NULL, *child;
+    size_t len;
+    int i, j;
+
+    switch (n->type) {
+    case NODE4:
+        p.p4 = (struct node4 *) n;
+        i = slot - p.p4->children;
+        memmove(p.p4->keys + i, p.p4->keys + i + 1, n->count - 1 - i);
+        memmove(p.p4->children + i, p.p4->children + i + 1,
+                (n->count - 1 - i) * sizeof(n));
+        if (--n->count > 1) {
+            return;
+        }
+
+        child = p.p4->children[0];
+        if (!IS_LEAF(child)) {
+            /* child prefix = n prefix + key byte + child prefix */
+            len = n->prefix_len;
+            if (len < MAX_PREFIX) {
+                n->prefix[len++] = p.p4->keys[0];
+            }
+            for (j = 0; len < MAX_PREFIX && j < (int) child->prefix_len; ++j) {
+                n->prefix[len++] = child->prefix[j];
+            }
+            memcpy(child->prefix, n->prefix, MIN(len, MAX_PREFIX));
+            child->prefix_len += n->prefix_len + 1;
+        }
+        *ref = child;
+        free(n);
+        return;
+    case NODE16:
+        p.p16 = (struct node16 *) n;
+        i = slot - p.p16->children;
+        memmove(p.p16->keys + i, p.p16->keys + i + 1, n->count - 1 - i);
+        memmove(p.p16->children + i, p.p16->children + i + 1,
+                (n->count - 1 - i) * sizeof(n));
+        if (--n->count > 3 || (nn = new_node(NODE4)) == NULL) {
+            return;
+        }
+        copy_header(nn, n);
+        q.p4 = (struct node4 *) nn;
+        memcpy(q.p4->keys, p.p16->keys, 3);
+        memcpy(q.p4->children, p.p16->children, 3 * sizeof(n));
+        break;
+    case NODE48:
+        p.p48 = (struct node48 *) n;
+        p.p48->children[p.p48->index[c] - 1] = NULL;
+        p.p48->index[c] = 0;
+        if (--n->count > 12 || (nn = new_node(NODE16)) == NULL) {
+            return;
+        }
+        copy_header(nn, n);
+        q.p16 = (struct node16 *) nn;
+        for (i = 0, j = 0; i < 256; ++i) {
+            if (p.p48->index[i] != 0) {
+                q.p16->keys[j] = i;
+                q.p16->children[j++] = p.p48->children[p.p48->index[i] - 1];
+            }
+        }
+        break;
+    case NODE256:
+        p.p256 = (struct node256 *) n;
+        p.p256->children[c] = NULL;
+        if (--n->count > 37 || (nn = new_node(NODE48)) == NULL) {
+            return;
+        }
+        copy_header(nn, n);
+        q.p48 = (struct node48 *) nn;
+        for (i = 0, j = 0; i < 256; ++i) {
+            if (p.p256->children[i] != NULL) {
+                q.p48->children[j] = p.p256->children[i];
+                q.p48->index[i] = ++j;
+            }
+        }
+        break;
+    }
+
+    /* Shrunk, a failed alloc above just keeps the larger node. */
+    *ref = nn;
+    free(n);
+}
+
+int trie_remove(trie_t trie, const char *word)
+{
+    const unsigned char *key;
+    struct node *n, **ref, **child;
+    size_t depth, len;
+
+    key = (const unsigned char *) word;
+    len = strlen(word) + 1;
+    ref = &trie->root;
+    depth = 0;
+
+    if (*ref != NULL && IS_LEAF(*ref)) {
+        if (!leaf_matches(LEAF(*ref), key, len)) {
+            return -1;
+        }
+        free(LEAF(*ref));
+        *ref = NULL;
+        trie->size--;
+        return 0;
+    }
+
+    while ((n = *ref) != NULL) {
+        if (n->prefix_len != 0) {
+            if (check_prefix(n, key, len, depth)
+                    != MIN(n->prefix_len, MAX_PREFIX)) {
+                return -1;
+            }
+            depth += n->prefix_len;
+            if (depth >= len) {
+                return -1;
+            }
+        }
+        child = find_child(n, key[depth]);
+        if (child == NULL) {
+            return -1;
+        } else if (IS_LEAF(*child)) {
+            if (!leaf_matches(LEAF(*child), key, len)) {
+                return -1;
+            }
+            free(LEAF(*child));
+            remove_child(ref, n, key[depth], child);
+            trie->size--;
+            return 0;
+        }
+        ref = child;
+        depth++;
+    }
+    return -1;
+}
+
+size_t trie_get_size(trie_t trie)
+{
+    return trie->size;
+}
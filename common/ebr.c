@@ -0,0 +1,248 @@
+/*
+ * ebr.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "ebr.h"
+
+/*
+ * The global epoch only moves from e to e + 1 once every
+ * thread inside a critical section has announced e. A thread
+ * that announced e may retire a node while the global epoch is
+ * already e + 1, so the node may still be seen by threads of
+ * e + 1 at most, which are all gone when the epoch reaches
+ * e + 3. Each thread keeps its retired nodes in 3 lists, one
+ * per epoch modulo 3.
+ */
+#define CACHE_LINE  64
+#define EPOCHS      3
+#define ADVANCE     64      /* retired nodes between advance attempts */
+#define CACHED      4       /* domains cached per thread */
+
+/*
+ * Per thread state in a domain. Records are only added, and
+ * stay with their thread until the domain is freed.
+ */
+struct record {
+    unsigned long state;    /* epoch << 1 | 1 while inside, or 0 */
+    int nest;               /* depth of nested sections */
+    pthread_t owner;
+    struct record *next;
+    struct ebr_node *limbo[EPOCHS];
+    unsigned long limbo_epoch[EPOCHS];
+    unsigned long count;
+} __attribute__((aligned(CACHE_LINE)));
+
+struct _ebr {
+    unsigned long epoch;
+    struct record *records;
+    ebr_reclaim reclaim;
+    unsigned long id;       /* tells domains apart in caches */
+};
+
+static unsigned long next_id = 1;
+
+/*
+ * Records of the domains a thread used last, by domain id.
+ */
+static __thread struct {
+    unsigned long id;
+    struct record *rec;
+} cache[CACHED];
+
+int ebr_new(ebr_t *ebr, const ebr_reclaim reclaim)
+{
+    ebr_t new_ebr;
+
+    if (posix_memalign((void **) &new_ebr, CACHE_LINE, sizeof(*new_ebr)) != 0) {
+        return -1;
+    } else {
+        new_ebr->epoch = EPOCHS;
+        new_ebr->records = NULL;
+        new_ebr->reclaim = reclaim;
+        new_ebr->id = __atomic_fetch_add(&next_id, 1, __ATOMIC_RELAXED);
+        *ebr = new_ebr;
+        return 0;
+    }
+}
+
+/*
+ * reclaim_list - Hand every node of a list to the reclaim callback
+ */
+static void reclaim_list(ebr_t ebr, struct ebr_node *node)
+{
+    struct ebr_node *next;
+
+    while (node != NULL) {
+        next = node->next;
+        ebr->reclaim(node);
+        node = next;
+    }
+}
+
+void ebr_free(ebr_t *ebr)
+{
+    struct record *rec, *next;
+    int i;
+
+    rec = (*ebr)->records;
+    while (rec != NULL) {
+        next = rec->next;
+        for (i = 0; i < EPOCHS; ++i) {
+            reclaim_list(*ebr, rec->limbo[i]);
+        }
+        free(rec);
+        rec = next;
+    }
+    free(*ebr);
+    *ebr = NULL;
+}
+
+/*
+ * get_record - Find or create the record of calling thread
+ *
+ * Return the record, or NULL if failed to alloc memory.
+ */
+static struct record *get_record(ebr_t ebr)
+{
+    struct record *rec, *head;
+    pthread_t self;
+    int i;
+
+    i = ebr->id % CACHED;
+    if (cache[i].id == ebr->id) {
+        return cache[i].rec;
+    }
+
+    self = pthread_self();
+    rec = __atomic_load_n(&ebr->records, __ATOMIC_ACQUIRE);
+    while (rec != NULL && !pthread_equal(rec->owner, self)) {
+        rec = rec->next;
+    }
+
+    if (rec == NULL) {
+        if (posix_memalign((void **) &rec, CACHE_LINE, sizeof(*rec)) != 0) {
+            return NULL;
+        }
+        rec->state = 0;
+        rec->nest = 0;
+        rec->owner = self;
+        rec->count = 0;
+        for (i = 0; i < EPOCHS; ++i) {
+            rec->limbo[i] = NULL;
+            rec->limbo_epoch[i] = 0;
+        }
+
+        head = __atomic_load_n(&ebr->records, __ATOMIC_RELAXED);
+        do {
+            rec->next = head;
+        } while (!__atomic_compare_exchange_n(&ebr->records, &head, rec,
+                    1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+    i = ebr->id % CACHED;
+    cache[i].id = ebr->id;
+    cache[i].rec = rec;
+    return rec;
+}
+
+/*
+ * try_advance - Move the global epoch on if every thread inside caught up
+ */
+static void try_advance(ebr_t ebr)
+{
+    struct record *rec;
+    unsigned long epoch, state;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    epoch = __atomic_load_n(&ebr->epoch, __ATOMIC_ACQUIRE);
+
+    rec = __atomic_load_n(&ebr->records, __ATOMIC_ACQUIRE);
+    while (rec != NULL) {
+        state = __atomic_load_n(&rec->state, __ATOMIC_ACQUIRE);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return;
+        }
+        rec = rec->next;
+    }
+
+    __atomic_compare_exchange_n(&ebr->epoch, &epoch, epoch + 1,
+            0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+int ebr_enter(ebr_t ebr)
+{
+    struct record *rec;
+    unsigned long epoch;
+    int i;
+
+    rec = get_record(ebr);
+    if (rec == NULL) {
+        return -1;
+    } else if (rec->nest++ > 0) {
+        return 0;
+    }
+
+    /* Announce before reading any node. */
+    epoch = __atomic_load_n(&ebr->epoch, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&rec->state, epoch << 1 | 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    for (i = 0; i < EPOCHS; ++i) {
+        if (rec->limbo[i] != NULL && rec->limbo_epoch[i] + EPOCHS <= epoch) {
+            reclaim_list(ebr, rec->limbo[i]);
+            rec->limbo[i] = NULL;
+        }
+    }
+    return 0;
+}
+
+void ebr_exit(ebr_t ebr)
+{
+    struct record *rec;
+
+    rec = get_record(ebr);
+    if (--rec->nest == 0) {
+        __atomic_store_n(&rec->state, 0, __ATOMIC_RELEASE);
+    }
+}
+
+void ebr_retire(ebr_t ebr, struct ebr_node *node)
+{
+    struct record *rec;
+    unsigned long epoch;
+    int i;
+
+    rec = get_record(ebr);
+    epoch = rec->state >> 1;
+    i = epoch % EPOCHS;
+
+    /* A list left from 3 or more epochs ago is safe to reclaim. */
+    if (rec->limbo_epoch[i] != epoch) {
+        reclaim_list(ebr, rec->limbo[i]);
+        rec->limbo[i] = NULL;
+        rec->limbo_epoch[i] = epoch;
+    }
+    node->next = rec->limbo[i];
+    rec->limbo[i] = node;
+
+    if (++rec->count % ADVANCE == 0) {
+        try_advance(ebr);
+    }
+}
@@ -0,0 +1,306 @@
+/*
+ * mempool.c
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <pthread.h>
+#include "mempool.h"
+
+/*
+ * The first chunk holds MIN_CHUNK objects, every following chunk
+ * doubles until MAX_CHUNK, so a pool of n objects costs about
+ * log(n) chunks while small pools stay small.
+ */
+static const size_t MIN_CHUNK = 32;
+static const size_t MAX_CHUNK = 65536;
+
+struct chunk {
+    struct chunk *next;
+    size_t pad;     /* Keep the header 16 bytes, objects follow it. */
+};
+
+struct slot {       /* A released object. */
+    struct slot *next;
+};
+
+struct _mempool {
+    struct chunk *chunks;   /* All chunks, newest first. */
+    struct slot *spare;     /* Released objects. */
+    char *cur;              /* Unused space of newest chunk. */
+    char *end;
+    size_t size;            /* Object size. */
+    size_t nobjs;           /* Objects in next chunk. */
+    size_t refs;            /* Owners of the pool. */
+    struct _mempool *fwd;   /* Pool merged into, or NULL. */
+    pthread_mutex_t lock;   /* Taken only while shared. */
+};
+
+/*
+ * resolve - Follow a merged pool to the one holding its objects
+ *
+ * The result may be merged away by another thread at any time,
+ * use lock_resolved() to keep it.
+ */
+static mempool_t resolve(mempool_t pool)
+{
+    mempool_t fwd;
+
+    while ((fwd = __atomic_load_n(&pool->fwd, __ATOMIC_ACQUIRE)) != NULL) {
+        pool = fwd;
+    }
+    return pool;
+}
+
+/*
+ * lock - Lock a pool if it has more than one owner
+ *
+ * Return non-zero if the pool is locked. A pool with a single
+ * owner can't be used by another thread, nor become shared
+ * behind its owner's back.
+ */
+static int lock(mempool_t pool)
+{
+    if (__atomic_load_n(&pool->refs, __ATOMIC_ACQUIRE) > 1) {
+        pthread_mutex_lock(&pool->lock);
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+static void unlock(mempool_t pool, const int locked)
+{
+    if (locked) {
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/*
+ * lock_resolved - Lock the pool holding the objects of pool
+ *
+ * Return the locked pool, and set locked as lock() does. A pool
+ * is only merged away with its lock held, so once locked it
+ * can't be forwarded until unlocked.
+ */
+static mempool_t lock_resolved(mempool_t pool, int *locked)
+{
+    for (;;) {
+        pool = resolve(pool);
+        *locked = lock(pool);
+        if (__atomic_load_n(&pool->fwd, __ATOMIC_ACQUIRE) == NULL) {
+            return pool;
+        }
+        unlock(pool, *locked);
+    }
+}
+
+int mempool_new(mempool_t *pool, const size_t size)
+{
+    mempool_t new_pool;
+    size_t align;
+
+    new_pool = (mempool_t) malloc(sizeof(*new_pool));
+    if (new_pool == NULL) {
+        return -1;
+    } else {
+        align = sizeof(void *);
+        new_pool->size = size < align ? align
+                       : (size + align - 1) / align * align;
+        new_pool->chunks = NULL;
+        new_pool->spare = NULL;
+        new_pool->cur = NULL;
+        new_pool->end = NULL;
+        new_pool->nobjs = MIN_CHUNK;
+        new_pool->refs = 1;
+        new_pool->fwd = NULL;
+        pthread_mutex_init(&new_pool->lock, NULL);
+        *pool = new_pool;
+        return 0;
+    }
+}
+
+void mempool_free(mempool_t *pool)
+{
+    struct chunk *c, *del;
+    mempool_t p, next;
+
+    /* A merged pool holds a reference on the one it was merged into. */
+    p = *pool;
+    while (p != NULL && __atomic_sub_fetch(&p->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        c = p->chunks;
+        while (c != NULL) {
+            del = c;
+            c = c->next;
+            free(del);
+        }
+        next = p->fwd;
+        pthread_mutex_destroy(&p->lock);
+        free(p);
+        p = next;
+    }
+    *pool = NULL;
+}
+
+mempool_t mempool_share(mempool_t pool)
+{
+    __atomic_add_fetch(&pool->refs, 1, __ATOMIC_ACQ_REL);
+    return pool;
+}
+
+int mempool_merge(mempool_t pool, mempool_t other)
+{
+    struct chunk *c;
+    struct slot *s;
+    int locked, other_locked;
+
+    /*
+     * Lock in address order, so two merges can't wait on each
+     * other, and start over if either was merged away meanwhile.
+     */
+    for (;;) {
+        pool = resolve(pool);
+        other = resolve(other);
+        if (pool == other) {
+            return 0;
+        } else if (pool->size != other->size) {
+            return -1;
+        }
+
+        if (pool < other) {
+            locked = lock(pool);
+            other_locked = lock(other);
+        } else {
+            other_locked = lock(other);
+            locked = lock(pool);
+        }
+        if (__atomic_load_n(&pool->fwd, __ATOMIC_ACQUIRE) == NULL
+                && __atomic_load_n(&other->fwd, __ATOMIC_ACQUIRE) == NULL) {
+            break;
+        }
+        unlock(other, other_locked);
+        unlock(pool, locked);
+    }
+
+    /*
+     * Unused space of other's newest chunk is given up, its
+     * objects are either in use or on the spare list.
+     */
+    if (other->chunks != NULL) {
+        c = other->chunks;
+        while (c->next != NULL) {
+            c = c->next;
+        }
+        c->next = pool->chunks;
+        pool->chunks = other->chunks;
+    }
+    if (other->spare != NULL) {
+        s = other->spare;
+        while (s->next != NULL) {
+            s = s->next;
+        }
+        s->next = pool->spare;
+        pool->spare = other->spare;
+    }
+
+    other->chunks = NULL;
+    other->spare = NULL;
+    other->cur = NULL;
+    other->end = NULL;
+    __atomic_store_n(&other->fwd, mempool_share(pool), __ATOMIC_RELEASE);
+
+    unlock(other, other_locked);
+    unlock(pool, locked);
+    return 0;
+}
+
+/*
+ * add_chunk - Alloc a new chunk to carve objects from
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ */
+static int add_chunk(mempool_t pool)
+{
+    struct chunk *c;
+
+    c = (struct chunk *) malloc(sizeof(*c) + pool->nobjs * pool->size);
+    if (c == NULL) {
+        return -1;
+    } else {
+        c->next = pool->chunks;
+        pool->chunks = c;
+        pool->cur = (char *) (c + 1);
+        pool->end = pool->cur + pool->nobjs * pool->size;
+        if (pool->nobjs < MAX_CHUNK) {
+            pool->nobjs *= 2;
+        }
+        return 0;
+    }
+}
+
+void *mempool_alloc(mempool_t pool)
+{
+    struct slot *s;
+    void *p;
+    int locked;
+
+    pool = lock_resolved(pool, &locked);
+    if (pool->spare != NULL) {
+        s = pool->spare;
+        pool->spare = s->next;
+        p = s;
+    } else if (pool->cur == pool->end && add_chunk(pool) == -1) {
+        p = NULL;
+    } else {
+        p = pool->cur;
+        pool->cur += pool->size;
+    }
+
+    unlock(pool, locked);
+    return p;
+}
+
+void *mempool_alloc_block(mempool_t pool, const size_t n)
+{
+    struct chunk *c;
+    int locked;
+
+    /* Merged pools all have the same object size. */
+    c = (struct chunk *) malloc(sizeof(*c) + n * pool->size);
+    if (c == NULL) {
+        return NULL;
+    }
+
+    /* Carving goes on from cur, wherever the chunk is listed. */
+    pool = lock_resolved(pool, &locked);
+    c->next = pool->chunks;
+    pool->chunks = c;
+    unlock(pool, locked);
+    return c + 1;
+}
+
+void mempool_release(mempool_t pool, void *p)
+{
+    struct slot *s;
+    int locked;
+
+    pool = lock_resolved(pool, &locked);
+    s = (struct slot *) p;
+    s->next = pool->spare;
+    pool->spare = s;
+    unlock(pool, locked);
+}
@@ -20,6 +20,7 @@
 #ifndef BULLET_AVLTREE_H
 #define BULLET_AVLTREE_H
 
+#include <stddef.h>
 #include "comparator.h"
 
 /**
@@ -32,6 +33,21 @@ typedef struct _avltree *avltree_t;
  */
 typedef void *avltreeElem;
 
+/**
+ * Define a new data type: avltree_cursor_t
+ *
+ * A cursor points to an element in an avl-tree and moves
+ * in order. Any change to the tree invalidates its cursors.
+ */
+typedef struct _avltree_cursor *avltree_cursor_t;
+
+/**
+ * Define a callback for range scans
+ *
+ * Return non-zero to stop the scan, 0 to go on.
+ */
+typedef int (*avltree_visitor)(avltreeElem x, void *arg);
+
 /**
  * avltree_new - Create a new avl-tree
  *
@@ -45,6 +61,23 @@ typedef void *avltreeElem;
  */
 extern int avltree_new(avltree_t *avl, const comparator cmp);
 
+/**
+ * avltree_from_sorted - Create an avl-tree from sorted elements
+ *
+ * @avl[out]: the avl-tree
+ * @elems[in]: elements in strictly ascending order
+ * @n[in]: count of elements
+ * @cmp[in]: comparing function
+ *
+ * Return 0 if success, -1 if elems are not strictly ascending
+ * or failed to alloc memory.
+ *
+ * The tree is perfectly balanced and built in O(n), with
+ * nodes laid out in one block in breadth-first order.
+ */
+extern int avltree_from_sorted(avltree_t *avl, avltreeElem const elems[],
+        const size_t n, const comparator cmp);
+
 /**
  * avltree_free - Destroy an avl-tree
  *
@@ -121,4 +154,266 @@ extern int avltree_get_min(avltree_t avl, avltreeElem *x);
  * Return 0 if find maximum value in avl-tree, -1 if avl-tree is empty.
  */
 extern int avltree_get_max(avltree_t avl, avltreeElem *x);
+
+/**
+ * avltree_cursor_new - Create a new cursor
+ *
+ * @cur[out]: the cursor
+ * @avl[in]: the avl-tree
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * A new cursor points to nothing until it is positioned.
+ */
+extern int avltree_cursor_new(avltree_cursor_t *cur, avltree_t avl);
+
+/**
+ * avltree_cursor_free - Destroy a cursor
+ *
+ * @cur[in]: the cursor
+ */
+extern void avltree_cursor_free(avltree_cursor_t *cur);
+
+/**
+ * avltree_cursor_first - Point cursor to the minimum
+ *
+ * @cur[in]: the cursor
+ * @x[out]: the element
+ *
+ * Return 0 if success, -1 if avl-tree is empty.
+ */
+extern int avltree_cursor_first(avltree_cursor_t cur, avltreeElem *x);
+
+/**
+ * avltree_cursor_last - Point cursor to the maximum
+ *
+ * @cur[in]: the cursor
+ * @x[out]: the element
+ *
+ * Return 0 if success, -1 if avl-tree is empty.
+ */
+extern int avltree_cursor_last(avltree_cursor_t cur, avltreeElem *x);
+
+/**
+ * avltree_lower_bound - Point cursor to the first element >= x
+ *
+ * @cur[in]: the cursor
+ * @x[in]: the value
+ * @y[out]: the element
+ *
+ * Return 0 if success, -1 if no such element.
+ */
+extern int avltree_lower_bound(avltree_cursor_t cur, const avltreeElem x,
+        avltreeElem *y);
+
+/**
+ * avltree_upper_bound - Point cursor to the first element > x
+ *
+ * @cur[in]: the cursor
+ * @x[in]: the value
+ * @y[out]: the element
+ *
+ * Return 0 if success, -1 if no such element.
+ */
+extern int avltree_upper_bound(avltree_cursor_t cur, const avltreeElem x,
+        avltreeElem *y);
+
+/**
+ * avltree_next - Move cursor to the next element
+ *
+ * @cur[in]: the cursor
+ * @y[out]: the element
+ *
+ * Return 0 if success, -1 if cursor was at the last element
+ * or pointed to nothing, and it points to nothing afterwards.
+ */
+extern int avltree_next(avltree_cursor_t cur, avltreeElem *y);
+
+/**
+ * avltree_prev - Move cursor to the previous element
+ *
+ * @cur[in]: the cursor
+ * @y[out]: the element
+ *
+ * Return 0 if success, -1 if cursor was at the first element
+ * or pointed to nothing, and it points to nothing afterwards.
+ */
+extern int avltree_prev(avltree_cursor_t cur, avltreeElem *y);
+
+/**
+ * avltree_add_hint - Add an element, starting from a cursor
+ *
+ * @avl[in]: the avl-tree
+ * @cur[in]: a cursor of avl
+ * @x[in]: the element
+ *
+ * Return 0 if success, -1 if failed to alloc memory, cur is
+ * not a cursor of avl, or avl is an avlmap or an interval tree.
+ *
+ * The search climbs from the cursor only as far as x needs,
+ * then goes down. Afterwards the cursor points to x, and stays
+ * valid for the next call, unless the tree is changed in any
+ * other way in between. Adding nearly sorted elements this way
+ * takes O(1) comparisons each, amortized.
+ */
+extern int avltree_add_hint(avltree_t avl, avltree_cursor_t cur,
+        const avltreeElem x);
+
+/**
+ * avltree_range_scan - Visit elements in [lo, hi] in order
+ *
+ * @avl[in]: the avl-tree
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ * @visit[in]: callback of each element
+ * @arg[in]: passed to visit as is
+ *
+ * Return count of visited elements.
+ *
+ * Only the subtrees overlapping [lo, hi] are touched,
+ * so the cost is O(log n + k) for k elements in range.
+ */
+extern size_t avltree_range_scan(avltree_t avl, const avltreeElem lo,
+        const avltreeElem hi, avltree_visitor visit, void *arg);
+/**
+ * avltree_get_size - Get count of elements in avl-tree
+ *
+ * @avl[in]: the avl-tree
+ *
+ * Return count of elements.
+ */
+extern size_t avltree_get_size(avltree_t avl);
+
+/**
+ * avltree_get_comparator - Get comparing function of avl-tree
+ *
+ * @avl[in]: the avl-tree
+ *
+ * Return the comparator, cmp_int if avl-tree was created with NULL.
+ */
+extern comparator avltree_get_comparator(avltree_t avl);
+
+/**
+ * avltree_rank - Count elements less than x
+ *
+ * @avl[in]: the avl-tree
+ * @x[in]: the value, which needs not to be in avl-tree
+ *
+ * Return count of elements less than x, which is also
+ * the 0-based position of x if it is in avl-tree.
+ */
+extern size_t avltree_rank(avltree_t avl, const avltreeElem x);
+
+/**
+ * avltree_select - Find the k-th smallest element
+ *
+ * @avl[in]: the avl-tree
+ * @k[in]: 0-based position
+ * @x[out]: the element
+ *
+ * Return 0 if success, -1 if k is not less than size of avl-tree.
+ */
+extern int avltree_select(avltree_t avl, size_t k, avltreeElem *x);
+
+/**
+ * avltree_count_range - Count elements in [lo, hi]
+ *
+ * @avl[in]: the avl-tree
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ *
+ * Return count of elements, 0 if lo > hi.
+ */
+extern size_t avltree_count_range(avltree_t avl, const avltreeElem lo,
+        const avltreeElem hi);
+
+/**
+ * avltree_join - Append another avl-tree
+ *
+ * @avl[in]: the avl-tree
+ * @other[in]: avl-tree of elements all greater than those of avl
+ *
+ * Return 0 if success, -1 if elements overlap, comparators
+ * differ or either tree takes part in snapshots, and then
+ * nothing is changed.
+ *
+ * other is freed on success. Cost is O(log n).
+ */
+extern int avltree_join(avltree_t avl, avltree_t *other);
+
+/**
+ * avltree_split - Move elements not less than x to a new avl-tree
+ *
+ * @avl[in]: the avl-tree
+ * @x[in]: the value, which needs not to be in avl-tree
+ * @right[out]: the new avl-tree
+ *
+ * Return 0 if success, -1 if failed to alloc memory, or avl
+ * takes part in snapshots.
+ *
+ * Cost is O(log n). Both trees keep drawing nodes from one
+ * pool, which is given back once both are freed.
+ */
+extern int avltree_split(avltree_t avl, const avltreeElem x,
+        avltree_t *right);
+
+/**
+ * avltree_union - Add all elements of another avl-tree
+ *
+ * @avl[in]: the avl-tree
+ * @other[in]: another avl-tree with the same comparator
+ *
+ * Return 0 if success, -1 if comparators differ or either
+ * tree takes part in snapshots, and then nothing is changed.
+ *
+ * other is freed on success, its nodes are moved rather than
+ * copied. Where both hold an equal element, the one in avl
+ * is kept. Large inputs are processed by several threads.
+ */
+extern int avltree_union(avltree_t avl, avltree_t *other);
+
+/**
+ * avltree_intersect - Keep only elements also in another avl-tree
+ *
+ * @avl[in]: the avl-tree
+ * @other[in]: another avl-tree with the same comparator
+ *
+ * Return 0 if success, -1 if comparators differ or either
+ * tree takes part in snapshots, and then nothing is changed.
+ *
+ * other is freed on success.
+ */
+extern int avltree_intersect(avltree_t avl, avltree_t *other);
+
+/**
+ * avltree_difference - Remove all elements of another avl-tree
+ *
+ * @avl[in]: the avl-tree
+ * @other[in]: another avl-tree with the same comparator
+ *
+ * Return 0 if success, -1 if comparators differ or either
+ * tree takes part in snapshots, and then nothing is changed.
+ *
+ * other is freed on success.
+ */
+extern int avltree_difference(avltree_t avl, avltree_t *other);
+
+/**
+ * avltree_snapshot - Take a point-in-time copy of avl-tree
+ *
+ * @avl[in]: the avl-tree
+ * @snap[out]: the copy
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * Cost is O(1), both trees share all nodes at first. From then
+ * on, add and remove on either tree copy the nodes they change,
+ * O(log n) of them, and leave the other tree as it was. So a
+ * thread may read or scan snap without locks, while another one
+ * keeps modifying avl. Free snap when done like any avl-tree.
+ * Once the trees sharing nodes are all freed but one, that one
+ * no longer takes part in snapshots.
+ */
+extern int avltree_snapshot(avltree_t avl, avltree_t *snap);
+
 #endif /* BULLET_AVLTREE_H */
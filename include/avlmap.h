@@ -0,0 +1,144 @@
+/*
+ * avlmap.h - Ordered map on avl balanced tree
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_AVLMAP_H
+#define BULLET_AVLMAP_H
+
+#include "comparator.h"
+
+/**
+ * Define a new data type: avlmap_t
+ *
+ * An avlmap is an avl-tree whose nodes hold the key and
+ * the value side by side, so no pair needs to be allocated.
+ */
+typedef struct _avltree *avlmap_t;
+
+/**
+ * Define a new avlmapKey type
+ */
+typedef void *avlmapKey;
+
+/**
+ * Define a new avlmapValue type
+ */
+typedef void *avlmapValue;
+
+/**
+ * avlmap_new - Create a new avlmap
+ *
+ * @map[out]: the avlmap
+ * @cmp[in]: comparing function of keys
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If cmp set to be NULL, then default integer comparator will be used.
+ */
+extern int avlmap_new(avlmap_t *map, const comparator cmp);
+
+/**
+ * avlmap_free - Destroy an avlmap
+ *
+ * @map[in]: the avlmap
+ */
+extern void avlmap_free(avlmap_t *map);
+
+/**
+ * avlmap_put - Add a new key-value pair
+ *
+ * @map[in]: the avlmap
+ * @key[in]: the key
+ * @value[in]: the value
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If given key can be found in avlmap, this function
+ * will update the old value by the new one.
+ */
+extern int avlmap_put(avlmap_t map, const avlmapKey key,
+        const avlmapValue value);
+
+/**
+ * avlmap_get - Get value by key
+ *
+ * @map[in]: the avlmap
+ * @key[in]: the key
+ * @value[out]: output value
+ *
+ * Return 0 if key exists in avlmap, -1 if not.
+ */
+extern int avlmap_get(avlmap_t map, const avlmapKey key, avlmapValue *value);
+
+/**
+ * avlmap_remove - Remove key-value pair by given key
+ *
+ * @map[in]: the avlmap
+ * @key[in]: the key
+ *
+ * Return 0 if key exists and the pair is removed successfully,
+ * -1 if key doesn't exists in the avlmap.
+ */
+extern int avlmap_remove(avlmap_t map, const avlmapKey key);
+
+/**
+ * avlmap_contains_key - Check if avlmap contains key or not
+ *
+ * @map[in]: the avlmap
+ * @key[in]: the key
+ *
+ * Return non-zero if avlmap contains the given key, 0 if not.
+ */
+extern int avlmap_contains_key(avlmap_t map, const avlmapKey key);
+
+/**
+ * avlmap_floor - Find the pair with the largest key <= given key
+ *
+ * @map[in]: the avlmap
+ * @key[in]: the key
+ * @k[out]: output key
+ * @value[out]: output value
+ *
+ * Return 0 if such a pair exists, -1 if not.
+ */
+extern int avlmap_floor(avlmap_t map, const avlmapKey key,
+        avlmapKey *k, avlmapValue *value);
+
+/**
+ * avlmap_ceiling - Find the pair with the smallest key >= given key
+ *
+ * @map[in]: the avlmap
+ * @key[in]: the key
+ * @k[out]: output key
+ * @value[out]: output value
+ *
+ * Return 0 if such a pair exists, -1 if not.
+ */
+extern int avlmap_ceiling(avlmap_t map, const avlmapKey key,
+        avlmapKey *k, avlmapValue *value);
+
+/**
+ * avlmap_isempty - Check if avlmap is empty or not
+ *
+ * @map[in]: the avlmap
+ *
+ * Return non-zero if avlmap is empty, 0 if not.
+ */
+extern int avlmap_isempty(avlmap_t map);
+
+#endif /* BULLET_AVLMAP_H */
@@ -89,6 +89,21 @@ extern int binary_minheap_poll(binary_minheap_t heap, binaryMinHeapElem *x);
  */
 extern int binary_minheap_peek(binary_minheap_t heap, binaryMinHeapElem *x);
 
+/**
+ * binary_minheap_replace - Replace the root of the heap
+ *
+ * @heap[in]: the binary minheap
+ * @x[in]: new value
+ * @old[out]: the old root
+ *
+ * Return 0 if root exists, -1 otherwise.
+ *
+ * Same as binary_minheap_poll() followed by binary_minheap_add(),
+ * but sifts down only once.
+ */
+extern int binary_minheap_replace(binary_minheap_t heap,
+        const binaryMinHeapElem x, binaryMinHeapElem *old);
+
 /**
  * binary_minheap_get_size - Count elements in heap
  *
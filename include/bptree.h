@@ -0,0 +1,157 @@
+/*
+ * bptree.h - B+tree of integer keys
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_BPTREE_H
+#define BULLET_BPTREE_H
+
+#include <stddef.h>
+
+/**
+ * Define a new data type: bptree_t
+ *
+ * A bptree maps int keys to values. Keys are stored in
+ * place, many to a node, so a lookup touches a handful of
+ * nodes instead of one node per level of a binary tree.
+ * Leaves are linked in key order for range scans.
+ */
+typedef struct _bptree *bptree_t;
+
+/**
+ * Define a new bptreeValue type
+ */
+typedef void *bptreeValue;
+
+/**
+ * Define a callback for range scans
+ *
+ * Return non-zero to stop the scan, 0 to go on.
+ */
+typedef int (*bptree_visitor)(int key, bptreeValue value, void *arg);
+
+/**
+ * bptree_new - Create a new bptree
+ *
+ * @bpt[out]: the bptree
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ */
+extern int bptree_new(bptree_t *bpt);
+
+/**
+ * bptree_from_sorted - Create a bptree from sorted keys
+ *
+ * @bpt[out]: the bptree
+ * @keys[in]: keys in strictly ascending order
+ * @values[in]: values of keys, or NULL for all NULL values
+ * @n[in]: count of keys
+ *
+ * Return 0 if success, -1 if keys are not strictly ascending
+ * or failed to alloc memory.
+ *
+ * Nodes are filled bottom-up in O(n), with no search or split.
+ */
+extern int bptree_from_sorted(bptree_t *bpt, const int keys[],
+        bptreeValue const values[], const size_t n);
+
+/**
+ * bptree_free - Destroy a bptree
+ *
+ * @bpt[in]: the bptree
+ */
+extern void bptree_free(bptree_t *bpt);
+
+/**
+ * bptree_put - Add a key-value pair
+ *
+ * @bpt[in]: the bptree
+ * @key[in]: the key
+ * @value[in]: the value
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If given key can be found in bptree, this function
+ * will update the old value by the new one.
+ */
+extern int bptree_put(bptree_t bpt, const int key, const bptreeValue value);
+
+/**
+ * bptree_get - Get value by key
+ *
+ * @bpt[in]: the bptree
+ * @key[in]: the key
+ * @value[out]: output value
+ *
+ * Return 0 if key exists in bptree, -1 if not.
+ */
+extern int bptree_get(bptree_t bpt, const int key, bptreeValue *value);
+
+/**
+ * bptree_contains - Check if bptree contains key or not
+ *
+ * @bpt[in]: the bptree
+ * @key[in]: the key
+ *
+ * Return non-zero if bptree contains the given key, 0 if not.
+ */
+extern int bptree_contains(bptree_t bpt, const int key);
+
+/**
+ * bptree_remove - Remove key-value pair by given key
+ *
+ * @bpt[in]: the bptree
+ * @key[in]: the key
+ *
+ * Return 0 if key exists and the pair is removed successfully,
+ * -1 if key doesn't exists in the bptree.
+ */
+extern int bptree_remove(bptree_t bpt, const int key);
+
+/**
+ * bptree_range_scan - Visit pairs with key in [lo, hi] in order
+ *
+ * @bpt[in]: the bptree
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ * @visit[in]: callback of each pair
+ * @arg[in]: passed to visit as is
+ *
+ * Return count of visited pairs.
+ */
+extern size_t bptree_range_scan(bptree_t bpt, const int lo, const int hi,
+        bptree_visitor visit, void *arg);
+
+/**
+ * bptree_get_size - Get count of keys in bptree
+ *
+ * @bpt[in]: the bptree
+ *
+ * Return count of keys.
+ */
+extern size_t bptree_get_size(bptree_t bpt);
+
+/**
+ * bptree_isempty - Check if bptree is empty or not
+ *
+ * @bpt[in]: the bptree
+ *
+ * Return non-zero if bptree is empty, 0 if not.
+ */
+extern int bptree_isempty(bptree_t bpt);
+
+#endif /* BULLET_BPTREE_H */
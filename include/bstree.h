@@ -33,6 +33,21 @@ typedef struct _bstree *bstree_t;
  */
 typedef void *bstreeElem;
 
+/**
+ * Define a new data type: bstree_cursor_t
+ *
+ * A cursor points to an element in a bstree and moves
+ * in order. Any change to the bstree invalidates its cursors.
+ */
+typedef struct _bstree_cursor *bstree_cursor_t;
+
+/**
+ * Define a callback for range scans
+ *
+ * Return non-zero to stop the scan, 0 to go on.
+ */
+typedef int (*bstree_visitor)(bstreeElem x, void *arg);
+
 /**
  * bstree_new - Create a new bstree
  *
@@ -43,6 +58,41 @@ typedef void *bstreeElem;
  */
 extern int bstree_new(bstree_t *bstree, const comparator cmp);
 
+/**
+ * bstree_new_splay - Create a new self-adjusting bstree
+ *
+ * @bstree[out]: the bstree
+ * @cmp[in]: comparing function
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ * If cmp = NULL, then default comparator function would be used.
+ *
+ * The bstree is a splay tree: add, remove and contains move
+ * the element they look for up to root, so frequently used
+ * elements stay near the top, and any sequence of m operations
+ * costs O(m log n), sorted inserts included. As contains changes
+ * the tree, it invalidates cursors, and a splaying bstree can't
+ * be read by several threads at the same time.
+ */
+extern int bstree_new_splay(bstree_t *bstree, const comparator cmp);
+
+/**
+ * bstree_from_sorted - Create a bstree from sorted elements
+ *
+ * @bstree[out]: the bstree
+ * @elems[in]: elements in strictly ascending order
+ * @n[in]: count of elements
+ * @cmp[in]: comparing function
+ *
+ * Return 0 if success, -1 if elems are not strictly ascending
+ * or failed to alloc memory.
+ *
+ * The tree is perfectly balanced and built in O(n), with
+ * nodes laid out in one block in breadth-first order.
+ */
+extern int bstree_from_sorted(bstree_t *bstree, bstreeElem const elems[],
+        const size_t n, const comparator cmp);
+
 /**
  * bstree_free - Destroy a bstree
  *
@@ -99,6 +149,15 @@ extern size_t bstree_get_height(bstree_t bstree);
  */
 extern int bstree_isempty(bstree_t bstree);
 
+/**
+ * bstree_get_comparator - Get comparing function of bstree
+ *
+ * @bstree[in]: the bstree
+ *
+ * Return the comparator, cmp_int if bstree was created with NULL.
+ */
+extern comparator bstree_get_comparator(bstree_t bstree);
+
 /**
  * bstree_get_min - Get min value in bstree
  *
@@ -119,4 +178,105 @@ extern int bstree_get_min(bstree_t bstree, bstreeElem *x);
  */
 extern int bstree_get_max(bstree_t bstree, bstreeElem *x);
 
+/**
+ * bstree_cursor_new - Create a new cursor
+ *
+ * @cur[out]: the cursor
+ * @bstree[in]: the bstree
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * A new cursor points to nothing until it is positioned.
+ */
+extern int bstree_cursor_new(bstree_cursor_t *cur, bstree_t bstree);
+
+/**
+ * bstree_cursor_free - Destroy a cursor
+ *
+ * @cur[in]: the cursor
+ */
+extern void bstree_cursor_free(bstree_cursor_t *cur);
+
+/**
+ * bstree_cursor_first - Point cursor to the minimum
+ *
+ * @cur[in]: the cursor
+ * @x[out]: the element
+ *
+ * Return 0 if success, -1 if bstree is empty or failed to alloc memory.
+ */
+extern int bstree_cursor_first(bstree_cursor_t cur, bstreeElem *x);
+
+/**
+ * bstree_cursor_last - Point cursor to the maximum
+ *
+ * @cur[in]: the cursor
+ * @x[out]: the element
+ *
+ * Return 0 if success, -1 if bstree is empty or failed to alloc memory.
+ */
+extern int bstree_cursor_last(bstree_cursor_t cur, bstreeElem *x);
+
+/**
+ * bstree_lower_bound - Point cursor to the first element >= x
+ *
+ * @cur[in]: the cursor
+ * @x[in]: the value
+ * @y[out]: the element
+ *
+ * Return 0 if success, -1 if no such element or failed to alloc memory.
+ */
+extern int bstree_lower_bound(bstree_cursor_t cur, const bstreeElem x,
+        bstreeElem *y);
+
+/**
+ * bstree_upper_bound - Point cursor to the first element > x
+ *
+ * @cur[in]: the cursor
+ * @x[in]: the value
+ * @y[out]: the element
+ *
+ * Return 0 if success, -1 if no such element or failed to alloc memory.
+ */
+extern int bstree_upper_bound(bstree_cursor_t cur, const bstreeElem x,
+        bstreeElem *y);
+
+/**
+ * bstree_next - Move cursor to the next element
+ *
+ * @cur[in]: the cursor
+ * @y[out]: the element
+ *
+ * Return 0 if success, -1 if cursor was at the last element
+ * or pointed to nothing, and it points to nothing afterwards.
+ */
+extern int bstree_next(bstree_cursor_t cur, bstreeElem *y);
+
+/**
+ * bstree_prev - Move cursor to the previous element
+ *
+ * @cur[in]: the cursor
+ * @y[out]: the element
+ *
+ * Return 0 if success, -1 if cursor was at the first element
+ * or pointed to nothing, and it points to nothing afterwards.
+ */
+extern int bstree_prev(bstree_cursor_t cur, bstreeElem *y);
+
+/**
+ * bstree_range_scan - Visit elements in [lo, hi] in order
+ *
+ * @bstree[in]: the bstree
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ * @visit[in]: callback of each element
+ * @arg[in]: passed to visit as is
+ *
+ * Return count of visited elements.
+ *
+ * Only the subtrees overlapping [lo, hi] are touched.
+ */
+extern size_t bstree_range_scan(bstree_t bstree, const bstreeElem lo,
+        const bstreeElem hi, bstree_visitor visit, void *arg);
+
 #endif /* BULLET_BSTREE_H */
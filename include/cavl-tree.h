@@ -0,0 +1,146 @@
+/*
+ * cavl-tree.h - Concurrent avl-tree
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_CAVLTREE_H
+#define BULLET_CAVLTREE_H
+
+#include <stddef.h>
+#include "comparator.h"
+
+/**
+ * Define a new data type: cavltree_t
+ *
+ * A cavltree may be used by many threads at the same time.
+ * Lookups take no lock: they check a version number of each
+ * node they pass, and step back when a rotation moved the node
+ * under them. Updates lock the nodes they change only, and the
+ * tree is re-balanced by the updating thread after the change,
+ * so it may be briefly out of balance.
+ */
+typedef struct _cavltree *cavltree_t;
+
+/**
+ * Define a new cavltreeElem type
+ */
+typedef void *cavltreeElem;
+
+/**
+ * cavltree_new - Create a new cavltree
+ *
+ * @cavl[out]: the cavltree
+ * @cmp[in]: comparing function
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If cmp set to be NULL, then function will load default
+ * comparator of intagers.
+ */
+extern int cavltree_new(cavltree_t *cavl, const comparator cmp);
+
+/**
+ * cavltree_free - Destroy a cavltree
+ *
+ * @cavl[in]: the cavltree
+ *
+ * No other thread may access the cavltree at this time.
+ */
+extern void cavltree_free(cavltree_t *cavl);
+
+/**
+ * cavltree_add - Add an element to cavltree
+ *
+ * @cavl[in]: the cavltree
+ * @x[in]: the element
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * An element already in the cavltree is ignored.
+ */
+extern int cavltree_add(cavltree_t cavl, const cavltreeElem x);
+
+/**
+ * cavltree_remove - Remove an element from cavltree
+ *
+ * @cavl[in]: the cavltree
+ * @x[in]: the element
+ *
+ * Return 0 if success, -1 if no such element or failed to
+ * alloc memory.
+ */
+extern int cavltree_remove(cavltree_t cavl, const cavltreeElem x);
+
+/**
+ * cavltree_contains - Check if cavltree contains x or not
+ *
+ * @cavl[in]: the cavltree
+ * @x[in]: the element
+ *
+ * Return 1 if cavltree contains x, 0 if not, -1 if failed to
+ * alloc memory for the epoch record of a new thread.
+ */
+extern int cavltree_contains(cavltree_t cavl, const cavltreeElem x);
+
+/**
+ * cavltree_get_min - Get the minimal element
+ *
+ * @cavl[in]: the cavltree
+ * @x[out]: the minimal element
+ *
+ * Return 0 if success, -1 if cavltree is empty or failed to
+ * alloc memory.
+ *
+ * Elements added or removed by other threads during the
+ * call may or may not be taken into account.
+ */
+extern int cavltree_get_min(cavltree_t cavl, cavltreeElem *x);
+
+/**
+ * cavltree_get_max - Get the maximal element
+ *
+ * @cavl[in]: the cavltree
+ * @x[out]: the maximal element
+ *
+ * Return 0 if success, -1 if cavltree is empty or failed to
+ * alloc memory.
+ *
+ * Elements added or removed by other threads during the
+ * call may or may not be taken into account.
+ */
+extern int cavltree_get_max(cavltree_t cavl, cavltreeElem *x);
+
+/**
+ * cavltree_get_size - Get count of elements in cavltree
+ *
+ * @cavl[in]: the cavltree
+ *
+ * Return count of elements, which may be stale
+ * while other threads are updating the cavltree.
+ */
+extern size_t cavltree_get_size(cavltree_t cavl);
+
+/**
+ * cavltree_isempty - Check if cavltree is empty or not
+ *
+ * @cavl[in]: the cavltree
+ *
+ * Return non-zero if cavltree is empty, 0 if not.
+ */
+extern int cavltree_isempty(cavltree_t cavl);
+
+#endif /* BULLET_CAVLTREE_H */
@@ -0,0 +1,141 @@
+/*
+ * cskiplist.h - Lock-free concurrent skiplist
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_CSKIPLIST_H
+#define BULLET_CSKIPLIST_H
+
+#include <stddef.h>
+#include "comparator.h"
+
+/**
+ * Define a new data type: cskiplist_t
+ *
+ * A cskiplist may be used by many threads at the same time
+ * without locks. Links are changed by compare-and-swap only,
+ * and an element is removed by marking its links first, so
+ * other threads never link to a node on its way out.
+ */
+typedef struct _cskiplist *cskiplist_t;
+
+/**
+ * Define a new cskiplistElem type
+ */
+typedef void *cskiplistElem;
+
+/**
+ * Define a callback for range scans
+ *
+ * Return non-zero to stop the scan, 0 to go on.
+ */
+typedef int (*cskiplist_visitor)(cskiplistElem x, void *arg);
+
+/**
+ * cskiplist_new - Create a new cskiplist
+ *
+ * @cs[out]: the cskiplist
+ * @cmp[in]: comparator
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If cmp set to be NULL, then default integer comparator will be used.
+ */
+extern int cskiplist_new(cskiplist_t *cs, const comparator cmp);
+
+/**
+ * cskiplist_free - Destroy a cskiplist
+ *
+ * @cs[in]: the cskiplist
+ *
+ * No other thread may access the cskiplist at this time.
+ */
+extern void cskiplist_free(cskiplist_t *cs);
+
+/**
+ * cskiplist_add - Add an element to cskiplist
+ *
+ * @cs[in]: the cskiplist
+ * @x[in]: the element
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * An element already in the cskiplist is ignored.
+ */
+extern int cskiplist_add(cskiplist_t cs, const cskiplistElem x);
+
+/**
+ * cskiplist_remove - Remove an element from cskiplist
+ *
+ * @cs[in]: the cskiplist
+ * @x[in]: the element
+ *
+ * Return 0 if success, -1 if no such element or failed to
+ * alloc memory.
+ */
+extern int cskiplist_remove(cskiplist_t cs, const cskiplistElem x);
+
+/**
+ * cskiplist_contains - Check if cskiplist contains x or not
+ *
+ * @cs[in]: the cskiplist
+ * @x[in]: the element
+ *
+ * Return 1 if cskiplist contains x, 0 if not, -1 if failed to
+ * alloc memory for the epoch record of a new thread.
+ */
+extern int cskiplist_contains(cskiplist_t cs, const cskiplistElem x);
+
+/**
+ * cskiplist_range_scan - Visit elements in [lo, hi] in order
+ *
+ * @cs[in]: the cskiplist
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ * @visit[in]: callback of each element
+ * @arg[in]: passed to visit as is
+ *
+ * Return count of visited elements, or (size_t) -1 if failed
+ * to alloc memory, and then nothing is visited.
+ *
+ * The scan is weakly consistent: every element in range for
+ * the whole scan is visited once, elements added or removed
+ * by other threads meanwhile may or may not be.
+ */
+extern size_t cskiplist_range_scan(cskiplist_t cs, const cskiplistElem lo,
+        const cskiplistElem hi, cskiplist_visitor visit, void *arg);
+
+/**
+ * cskiplist_get_size - Get count of elements in cskiplist
+ *
+ * @cs[in]: the cskiplist
+ *
+ * Return count of elements, which may be stale
+ * while other threads are updating the cskiplist.
+ */
+extern size_t cskiplist_get_size(cskiplist_t cs);
+
+/**
+ * cskiplist_isempty - Check if cskiplist is empty or not
+ *
+ * @cs[in]: the cskiplist
+ *
+ * Return non-zero if cskiplist is empty, 0 if not.
+ */
+extern int cskiplist_isempty(cskiplist_t cs);
+
+#endif /* BULLET_CSKIPLIST_H */
@@ -0,0 +1,97 @@
+/*
+ * ebr.h - Epoch based memory reclamation
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_EBR_H
+#define BULLET_EBR_H
+
+/**
+ * Define a new data type: ebr_t
+ *
+ * An ebr domain defers freeing of nodes unlinked from a shared
+ * structure until no thread can still be reading them. Readers
+ * don't lock nor write to the nodes they visit, they only
+ * announce once per operation that they are inside.
+ */
+typedef struct _ebr *ebr_t;
+
+/**
+ * Define struct ebr_node, to be embedded in reclaimed nodes
+ */
+struct ebr_node {
+    struct ebr_node *next;
+};
+
+/**
+ * Define a callback to free a node once it is safe
+ */
+typedef void (*ebr_reclaim)(struct ebr_node *node);
+
+/**
+ * ebr_new - Create a new ebr domain
+ *
+ * @ebr[out]: the ebr domain
+ * @reclaim[in]: frees a retired node
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ */
+extern int ebr_new(ebr_t *ebr, const ebr_reclaim reclaim);
+
+/**
+ * ebr_free - Destroy an ebr domain
+ *
+ * @ebr[in]: the ebr domain
+ *
+ * Nodes still waiting are reclaimed now. No thread may
+ * be inside the domain at this time.
+ */
+extern void ebr_free(ebr_t *ebr);
+
+/**
+ * ebr_enter - Start a critical section
+ *
+ * @ebr[in]: the ebr domain
+ *
+ * Return 0 if success, -1 if failed to alloc memory
+ * on the first call of a thread.
+ *
+ * Nodes reached from the shared structure inside the
+ * section stay valid until ebr_exit(). Sections may nest.
+ */
+extern int ebr_enter(ebr_t ebr);
+
+/**
+ * ebr_exit - End a critical section
+ *
+ * @ebr[in]: the ebr domain
+ */
+extern void ebr_exit(ebr_t ebr);
+
+/**
+ * ebr_retire - Reclaim a node once no thread can reach it
+ *
+ * @ebr[in]: the ebr domain
+ * @node[in]: the node, already unlinked from the structure
+ *
+ * Must be called inside a critical section. Reclaiming
+ * takes place two epochs later, at some ebr_enter() or
+ * ebr_retire() of the same thread, or at ebr_free().
+ */
+extern void ebr_retire(ebr_t ebr, struct ebr_node *node);
+
+#endif /* BULLET_EBR_H */
@@ -0,0 +1,179 @@
+/*
+ * frozenset.h - Read-only sorted set in Eytzinger layout
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_FROZENSET_H
+#define BULLET_FROZENSET_H
+
+#include <stddef.h>
+#include "comparator.h"
+#include "avl-tree.h"
+#include "bstree.h"
+
+/**
+ * Define a new data type: frozenset_t
+ *
+ * A frozenset holds the elements of a set that no longer
+ * changes in one array, laid out in the order a breadth-first
+ * walk of a complete binary search tree would visit them. The
+ * first levels share a few cache lines, and there are no child
+ * pointers to chase or store.
+ */
+typedef struct _frozenset *frozenset_t;
+
+/**
+ * Define a new frozensetElem type
+ */
+typedef void *frozensetElem;
+
+/**
+ * Define a callback for range scans
+ *
+ * Return non-zero to stop the scan, 0 to go on.
+ */
+typedef int (*frozenset_visitor)(frozensetElem x, void *arg);
+
+/**
+ * frozenset_new - Create a frozenset from sorted elements
+ *
+ * @fs[out]: the frozenset
+ * @elems[in]: elements in strictly ascending order
+ * @n[in]: count of elements
+ * @cmp[in]: comparing function
+ *
+ * Return 0 if success, -1 if elements are not strictly
+ * ascending or failed to alloc memory.
+ *
+ * If cmp set to be NULL, then function will load default
+ * comparator of intagers.
+ */
+extern int frozenset_new(frozenset_t *fs, frozensetElem const elems[],
+        const size_t n, const comparator cmp);
+
+/**
+ * frozenset_from_avltree - Create a frozenset from an avl-tree
+ *
+ * @fs[out]: the frozenset
+ * @avl[in]: the avl-tree
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * The frozenset takes the comparator of avl-tree. The avl-tree
+ * is left as it is, later changes to it don't show in the
+ * frozenset.
+ */
+extern int frozenset_from_avltree(frozenset_t *fs, avltree_t avl);
+
+/**
+ * frozenset_from_bstree - Create a frozenset from a binary search tree
+ *
+ * @fs[out]: the frozenset
+ * @bstree[in]: the binary search tree
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * The frozenset takes the comparator of bstree. The bstree is
+ * left as it is, later changes to it don't show in the frozenset.
+ */
+extern int frozenset_from_bstree(frozenset_t *fs, bstree_t bstree);
+
+/**
+ * frozenset_free - Destroy a frozenset
+ *
+ * @fs[in]: the frozenset
+ */
+extern void frozenset_free(frozenset_t *fs);
+
+/**
+ * frozenset_contains - Check if frozenset contains x or not
+ *
+ * @fs[in]: the frozenset
+ * @x[in]: element to be checked
+ *
+ * Return non-zero if frozenset contains x, 0 if not.
+ */
+extern int frozenset_contains(frozenset_t fs, const frozensetElem x);
+
+/**
+ * frozenset_lower_bound - Find the smallest element >= x
+ *
+ * @fs[in]: the frozenset
+ * @x[in]: the bound
+ * @y[out]: the element found
+ *
+ * Return 0 if found, -1 if every element is less than x.
+ */
+extern int frozenset_lower_bound(frozenset_t fs, const frozensetElem x,
+        frozensetElem *y);
+
+/**
+ * frozenset_upper_bound - Find the smallest element > x
+ *
+ * @fs[in]: the frozenset
+ * @x[in]: the bound
+ * @y[out]: the element found
+ *
+ * Return 0 if found, -1 if no element is greater than x.
+ */
+extern int frozenset_upper_bound(frozenset_t fs, const frozensetElem x,
+        frozensetElem *y);
+
+/**
+ * frozenset_range_scan - Visit elements in [lo, hi] in order
+ *
+ * @fs[in]: the frozenset
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ * @visit[in]: callback of each element
+ * @arg[in]: passed to visit as is
+ *
+ * Return count of visited elements.
+ */
+extern size_t frozenset_range_scan(frozenset_t fs, const frozensetElem lo,
+        const frozensetElem hi, frozenset_visitor visit, void *arg);
+
+/**
+ * frozenset_get_min - Get the minimal element
+ *
+ * @fs[in]: the frozenset
+ * @x[out]: the minimal element
+ *
+ * Return 0 if success, -1 if frozenset is empty.
+ */
+extern int frozenset_get_min(frozenset_t fs, frozensetElem *x);
+
+/**
+ * frozenset_get_max - Get the maximal element
+ *
+ * @fs[in]: the frozenset
+ * @x[out]: the maximal element
+ *
+ * Return 0 if success, -1 if frozenset is empty.
+ */
+extern int frozenset_get_max(frozenset_t fs, frozensetElem *x);
+
+/**
+ * frozenset_get_size - Get count of elements in frozenset
+ *
+ * @fs[in]: the frozenset
+ *
+ * Return count of elements.
+ */
+extern size_t frozenset_get_size(frozenset_t fs);
+
+#endif /* BULLET_FROZENSET_H */
@@ -0,0 +1,154 @@
+/*
+ * intervaltree.h - Interval tree on avl balanced tree
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_INTERVALTREE_H
+#define BULLET_INTERVALTREE_H
+
+#include <stddef.h>
+#include "comparator.h"
+
+/**
+ * Define a new data type: intervaltree_t
+ *
+ * An intervaltree is an avl-tree of closed intervals [lo, hi],
+ * ordered by lo then hi. Each node also keeps the largest hi
+ * of its subtree, which lets overlap queries skip subtrees.
+ */
+typedef struct _avltree *intervaltree_t;
+
+/**
+ * Define a new intervaltreePoint type, an end of an interval
+ */
+typedef void *intervaltreePoint;
+
+/**
+ * Define a callback for overlap queries
+ *
+ * Return non-zero to stop the query, 0 to go on.
+ */
+typedef int (*intervaltree_visitor)(intervaltreePoint lo,
+        intervaltreePoint hi, void *arg);
+
+/**
+ * intervaltree_new - Create a new intervaltree
+ *
+ * @it[out]: the intervaltree
+ * @cmp[in]: comparing function of points
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If cmp set to be NULL, then default integer comparator will be used.
+ */
+extern int intervaltree_new(intervaltree_t *it, const comparator cmp);
+
+/**
+ * intervaltree_free - Destroy an intervaltree
+ *
+ * @it[in]: the intervaltree
+ */
+extern void intervaltree_free(intervaltree_t *it);
+
+/**
+ * intervaltree_add - Add interval [lo, hi]
+ *
+ * @it[in]: the intervaltree
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ *
+ * Return 0 if success, -1 if lo > hi or failed to alloc memory.
+ *
+ * An interval already in the tree is ignored.
+ */
+extern int intervaltree_add(intervaltree_t it, const intervaltreePoint lo,
+        const intervaltreePoint hi);
+
+/**
+ * intervaltree_remove - Remove interval [lo, hi]
+ *
+ * @it[in]: the intervaltree
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ *
+ * Return 0 if success, -1 if no such interval.
+ */
+extern int intervaltree_remove(intervaltree_t it, const intervaltreePoint lo,
+        const intervaltreePoint hi);
+
+/**
+ * intervaltree_contains - Check if interval [lo, hi] is in intervaltree
+ *
+ * @it[in]: the intervaltree
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ *
+ * Return non-zero if intervaltree contains it, 0 if not.
+ */
+extern int intervaltree_contains(intervaltree_t it, const intervaltreePoint lo,
+        const intervaltreePoint hi);
+
+/**
+ * intervaltree_overlap - Visit intervals overlapping [lo, hi]
+ *
+ * @it[in]: the intervaltree
+ * @lo[in]: lower bound
+ * @hi[in]: upper bound
+ * @visit[in]: callback of each interval
+ * @arg[in]: passed to visit as is
+ *
+ * Return count of visited intervals.
+ *
+ * Intervals are visited in order, the cost is O(log n + k)
+ * for k overlapping intervals.
+ */
+extern size_t intervaltree_overlap(intervaltree_t it,
+        const intervaltreePoint lo, const intervaltreePoint hi,
+        intervaltree_visitor visit, void *arg);
+
+/**
+ * intervaltree_stab - Visit intervals containing point x
+ *
+ * @it[in]: the intervaltree
+ * @x[in]: the point
+ * @visit[in]: callback of each interval
+ * @arg[in]: passed to visit as is
+ *
+ * Return count of visited intervals.
+ */
+extern size_t intervaltree_stab(intervaltree_t it, const intervaltreePoint x,
+        intervaltree_visitor visit, void *arg);
+
+/**
+ * intervaltree_get_size - Get count of intervals in intervaltree
+ *
+ * @it[in]: the intervaltree
+ *
+ * Return count of intervals.
+ */
+extern size_t intervaltree_get_size(intervaltree_t it);
+
+/**
+ * intervaltree_isempty - Check if intervaltree is empty or not
+ *
+ * @it[in]: the intervaltree
+ *
+ * Return non-zero if intervaltree is empty, 0 if not.
+ */
+extern int intervaltree_isempty(intervaltree_t it);
+
+#endif /* BULLET_INTERVALTREE_H */
@@ -0,0 +1,76 @@
+/*
+ * kmerge.h - K-way merge of sorted runs
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_KMERGE_H
+#define BULLET_KMERGE_H
+
+#include <stdlib.h>
+#include "comparator.h"
+
+/**
+ * Define a new data type: kmerge_t
+ *
+ * A kmerge iterates over k sorted runs in ascending order.
+ * It is a loser tree, so every step replays a single
+ * leaf-to-root path with one comparison per level.
+ */
+typedef struct _kmerge *kmerge_t;
+
+/**
+ * Define a new kmergeElem type
+ */
+typedef void *kmergeElem;
+
+/**
+ * kmerge_new - Create a new k-way merge iterator
+ *
+ * @km[out]: the iterator
+ * @runs[in]: k sorted runs
+ * @lens[in]: length of each run
+ * @k[in]: count of runs
+ * @cmp[in]: a comparator
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * Runs are not copied, they must outlive the iterator.
+ * If cmp set to be NULL, then default integer comparator will be used.
+ */
+extern int kmerge_new(kmerge_t *km, kmergeElem *const runs[],
+        const size_t lens[], const size_t k, const comparator cmp);
+
+/**
+ * kmerge_free - Destroy a k-way merge iterator
+ *
+ * @km[in]: the iterator
+ */
+extern void kmerge_free(kmerge_t *km);
+
+/**
+ * kmerge_next - Retrive next element in merged order
+ *
+ * @km[in]: the iterator
+ * @x[out]: output value
+ *
+ * Return 0 if success, -1 if every run is exhausted.
+ *
+ * Equal elements come out in the order of their runs.
+ */
+extern int kmerge_next(kmerge_t km, kmergeElem *x);
+
+#endif /* BULLET_KMERGE_H */
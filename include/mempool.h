@@ -0,0 +1,109 @@
+/*
+ * mempool.h - Fixed-size object pool
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_MEMPOOL_H
+#define BULLET_MEMPOOL_H
+
+#include <stdlib.h>
+
+/**
+ * Define a new data type: mempool_t
+ *
+ * A mempool hands out objects of one size carved from large
+ * chunks. Released objects are kept on a free list for reuse,
+ * and every chunk is returned to the system at once when the
+ * pool is destroyed.
+ */
+typedef struct _mempool *mempool_t;
+
+/**
+ * mempool_new - Create a new object pool
+ *
+ * @pool[out]: the pool
+ * @size[in]: size of each object
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ */
+extern int mempool_new(mempool_t *pool, const size_t size);
+
+/**
+ * mempool_free - Drop a reference to a pool
+ *
+ * @pool[in]: the pool
+ *
+ * The pool and every object in it are destroyed
+ * when its last reference is dropped.
+ */
+extern void mempool_free(mempool_t *pool);
+
+/**
+ * mempool_share - Take one more reference to a pool
+ *
+ * @pool[in]: the pool
+ *
+ * Return the pool. While it has more than one owner, the
+ * pool locks itself around every call, so owners may use it
+ * from different threads.
+ */
+extern mempool_t mempool_share(mempool_t pool);
+
+/**
+ * mempool_merge - Move every object of other into pool
+ *
+ * @pool[in]: the pool
+ * @other[in]: pool to merge, of the same object size
+ *
+ * Return 0 if success, -1 if object sizes differ.
+ *
+ * Objects of other stay where they are and now belong to pool.
+ * other remains valid as another name of pool until freed.
+ */
+extern int mempool_merge(mempool_t pool, mempool_t other);
+
+/**
+ * mempool_alloc - Get an object from the pool
+ *
+ * @pool[in]: the pool
+ *
+ * Return the object, NULL if failed to alloc memory.
+ */
+extern void *mempool_alloc(mempool_t pool);
+
+/**
+ * mempool_alloc_block - Get n objects side by side
+ *
+ * @pool[in]: the pool
+ * @n[in]: count of objects
+ *
+ * Return the first object, NULL if failed to alloc memory.
+ *
+ * The block gets a chunk of its own. Its objects may be
+ * released one by one like any other object of the pool.
+ */
+extern void *mempool_alloc_block(mempool_t pool, const size_t n);
+
+/**
+ * mempool_release - Give an object back to the pool
+ *
+ * @pool[in]: the pool
+ * @p[in]: the object, which must come from this pool
+ */
+extern void mempool_release(mempool_t pool, void *p);
+
+#endif /* BULLET_MEMPOOL_H */
@@ -0,0 +1,232 @@
+/*
+ * memtable.h - Insert-only key/value skiplist on an arena
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_MEMTABLE_H
+#define BULLET_MEMTABLE_H
+
+#include <stddef.h>
+#include "comparator.h"
+
+/**
+ * Define a new data type: memtable_t
+ *
+ * A memtable is a skiplist of key-value pairs which never
+ * removes anything. Its nodes are cut from a bump arena and
+ * all go away at once with the memtable.
+ *
+ * One thread at a time may put, while any number of threads
+ * get and move cursors at the same time without locks. Writers
+ * must be serialized by the caller.
+ */
+typedef struct _memtable *memtable_t;
+
+/**
+ * Define a new data type: memtable_cursor_t
+ *
+ * A cursor points to a pair in a memtable and moves in order.
+ * Puts never invalidate a cursor.
+ */
+typedef struct _memtable_cursor *memtable_cursor_t;
+
+/**
+ * Define a new memtableKey type
+ */
+typedef void *memtableKey;
+
+/**
+ * Define a new memtableValue type
+ */
+typedef void *memtableValue;
+
+/**
+ * memtable_new - Create a new memtable
+ *
+ * @mt[out]: the memtable
+ * @cmp[in]: comparing function of keys
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If cmp set to be NULL, then default integer comparator will be used.
+ */
+extern int memtable_new(memtable_t *mt, const comparator cmp);
+
+/**
+ * memtable_free - Destroy a memtable and its arena
+ *
+ * @mt[in]: the memtable
+ *
+ * No other thread may access the memtable at this time.
+ */
+extern void memtable_free(memtable_t *mt);
+
+/**
+ * memtable_put - Add a new key-value pair
+ *
+ * @mt[in]: the memtable
+ * @key[in]: the key
+ * @value[in]: the value
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If given key can be found in memtable, this function
+ * will update the old value by the new one.
+ */
+extern int memtable_put(memtable_t mt, const memtableKey key,
+        const memtableValue value);
+
+/**
+ * memtable_get - Get value by key
+ *
+ * @mt[in]: the memtable
+ * @key[in]: the key
+ * @value[out]: the value
+ *
+ * Return 0 if success, -1 if key not found.
+ */
+extern int memtable_get(memtable_t mt, const memtableKey key,
+        memtableValue *value);
+
+/**
+ * memtable_alloc - Get memory from the arena of memtable
+ *
+ * @mt[in]: the memtable
+ * @size[in]: size in bytes
+ *
+ * Return 8 bytes aligned memory, or NULL if failed to alloc memory.
+ *
+ * The memory is freed with the memtable, and counts in its
+ * footprint, so keys and values may be copied here. Only the
+ * writing thread may call it.
+ */
+extern void *memtable_alloc(memtable_t mt, size_t size);
+
+/**
+ * memtable_get_memory_usage - Get memory footprint of memtable
+ *
+ * @mt[in]: the memtable
+ *
+ * Return bytes taken by the arena, to tell when the memtable
+ * is full enough to be flushed.
+ */
+extern size_t memtable_get_memory_usage(memtable_t mt);
+
+/**
+ * memtable_get_size - Get count of pairs in memtable
+ *
+ * @mt[in]: the memtable
+ *
+ * Return count of pairs, which may be stale while
+ * another thread puts.
+ */
+extern size_t memtable_get_size(memtable_t mt);
+
+/**
+ * memtable_isempty - Check if memtable is empty or not
+ *
+ * @mt[in]: the memtable
+ *
+ * Return non-zero if memtable is empty, 0 if not.
+ */
+extern int memtable_isempty(memtable_t mt);
+
+/**
+ * memtable_cursor_new - Create a new cursor
+ *
+ * @cur[out]: the cursor
+ * @mt[in]: the memtable
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * A new cursor points to nothing until it is positioned.
+ */
+extern int memtable_cursor_new(memtable_cursor_t *cur, memtable_t mt);
+
+/**
+ * memtable_cursor_free - Destroy a cursor
+ *
+ * @cur[in]: the cursor
+ */
+extern void memtable_cursor_free(memtable_cursor_t *cur);
+
+/**
+ * memtable_cursor_first - Point cursor to the minimal key
+ *
+ * @cur[in]: the cursor
+ * @key[out]: the key
+ * @value[out]: the value
+ *
+ * Return 0 if success, -1 if memtable is empty.
+ */
+extern int memtable_cursor_first(memtable_cursor_t cur, memtableKey *key,
+        memtableValue *value);
+
+/**
+ * memtable_cursor_last - Point cursor to the maximal key
+ *
+ * @cur[in]: the cursor
+ * @key[out]: the key
+ * @value[out]: the value
+ *
+ * Return 0 if success, -1 if memtable is empty.
+ */
+extern int memtable_cursor_last(memtable_cursor_t cur, memtableKey *key,
+        memtableValue *value);
+
+/**
+ * memtable_seek - Point cursor to the first key >= target
+ *
+ * @cur[in]: the cursor
+ * @target[in]: the target
+ * @key[out]: the key
+ * @value[out]: the value
+ *
+ * Return 0 if success, -1 if no such key.
+ */
+extern int memtable_seek(memtable_cursor_t cur, const memtableKey target,
+        memtableKey *key, memtableValue *value);
+
+/**
+ * memtable_next - Move cursor to the next key
+ *
+ * @cur[in]: the cursor
+ * @key[out]: the key
+ * @value[out]: the value
+ *
+ * Return 0 if success, -1 if cursor was at the last key
+ * or pointed to nothing, and it points to nothing afterwards.
+ */
+extern int memtable_next(memtable_cursor_t cur, memtableKey *key,
+        memtableValue *value);
+
+/**
+ * memtable_prev - Move cursor to the previous key
+ *
+ * @cur[in]: the cursor
+ * @key[out]: the key
+ * @value[out]: the value
+ *
+ * Return 0 if success, -1 if cursor was at the first key
+ * or pointed to nothing, and it points to nothing afterwards.
+ *
+ * Nodes have no back links, so this costs a search from the top.
+ */
+extern int memtable_prev(memtable_cursor_t cur, memtableKey *key,
+        memtableValue *value);
+
+#endif /* BULLET_MEMTABLE_H */
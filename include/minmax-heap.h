@@ -0,0 +1,139 @@
+/*
+ * minmax-heap.h - Double-ended priority queue
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_MINMAX_HEAP_H
+#define BULLET_MINMAX_HEAP_H
+
+#include <stdlib.h>
+#include "comparator.h"
+
+/**
+ * Define a new data type: minmax_heap_t
+ *
+ * Nodes on even levels are smaller than all their descendants,
+ * nodes on odd levels are larger. So the minimum is the root and
+ * the maximum is one of its children.
+ */
+typedef struct _minmax_heap *minmax_heap_t;
+
+/**
+ * Define a new minMaxHeapElem type
+ */
+typedef void *minMaxHeapElem;
+
+/**
+ * minmax_heap_new - Create a new min-max heap
+ *
+ * @heap[out]: the min-max heap
+ * @n[in]: size of heap
+ * @cmp[in]: a comparator
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If cmp set to be NULL, then default
+ * integer comparator will be used.
+ */
+extern int minmax_heap_new(minmax_heap_t *heap,
+        const size_t n, const comparator cmp);
+
+/**
+ * minmax_heap_free - Destroy a min-max heap
+ *
+ * @heap[in]: the min-max heap
+ */
+extern void minmax_heap_free(minmax_heap_t *heap);
+
+/**
+ * minmax_heap_add - Add an element to heap
+ *
+ * @heap[in]: the min-max heap
+ * @x[in]: value to be stored
+ *
+ * Return 0 if heap is not full, -1 otherwise.
+ */
+extern int minmax_heap_add(minmax_heap_t heap, const minMaxHeapElem x);
+
+/**
+ * minmax_heap_poll_min - Poll the minimum of heap
+ *
+ * @heap[in]: the min-max heap
+ * @x[out]: output value
+ *
+ * Return 0 if heap is not empty, -1 otherwise.
+ */
+extern int minmax_heap_poll_min(minmax_heap_t heap, minMaxHeapElem *x);
+
+/**
+ * minmax_heap_poll_max - Poll the maximum of heap
+ *
+ * @heap[in]: the min-max heap
+ * @x[out]: output value
+ *
+ * Return 0 if heap is not empty, -1 otherwise.
+ */
+extern int minmax_heap_poll_max(minmax_heap_t heap, minMaxHeapElem *x);
+
+/**
+ * minmax_heap_peek_min - Peek the minimum of heap
+ *
+ * @heap[in]: the min-max heap
+ * @x[out]: output value
+ *
+ * Return 0 if heap is not empty, -1 otherwise.
+ */
+extern int minmax_heap_peek_min(minmax_heap_t heap, minMaxHeapElem *x);
+
+/**
+ * minmax_heap_peek_max - Peek the maximum of heap
+ *
+ * @heap[in]: the min-max heap
+ * @x[out]: output value
+ *
+ * Return 0 if heap is not empty, -1 otherwise.
+ */
+extern int minmax_heap_peek_max(minmax_heap_t heap, minMaxHeapElem *x);
+
+/**
+ * minmax_heap_get_size - Count elements in heap
+ *
+ * @heap[in]: the min-max heap
+ *
+ * Count the elements in heap. Return 0 if heap is empty.
+ */
+extern size_t minmax_heap_get_size(minmax_heap_t heap);
+
+/**
+ * minmax_heap_isempty - Check if the heap is empty or not
+ *
+ * @heap[in]: the min-max heap
+ *
+ * Return non-zero if heap is empty, 0 otherwise.
+ */
+extern int minmax_heap_isempty(minmax_heap_t heap);
+
+/**
+ * minmax_heap_isfull - Check if the heap is full or not
+ *
+ * @heap[in]: the min-max heap
+ *
+ * Return non-zero if heap is full, 0 otherwise.
+ */
+extern int minmax_heap_isfull(minmax_heap_t heap);
+
+#endif /* BULLET_MINMAX_HEAP_H */
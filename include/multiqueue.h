@@ -0,0 +1,111 @@
+/*
+ * multiqueue.h - Relaxed concurrent priority queue
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_MULTIQUEUE_H
+#define BULLET_MULTIQUEUE_H
+
+#include <stdlib.h>
+#include "comparator.h"
+
+/**
+ * Define a new data type: multiqueue_t
+ *
+ * A multiqueue is made of c * T binary minheaps, each one
+ * guarded by its own lock. Insertion goes to a random heap,
+ * polling takes the smaller root of two random heaps. The
+ * element returned by multiqueue_poll() is not always the
+ * global minimum, but its rank error is small on average.
+ */
+typedef struct _multiqueue *multiqueue_t;
+
+/**
+ * Define a new multiQueueElem type
+ */
+typedef void *multiQueueElem;
+
+/**
+ * multiqueue_new - Create a new multiqueue
+ *
+ * @mq[out]: the multiqueue
+ * @nthreads[in]: number of threads sharing the multiqueue
+ * @c[in]: heaps per thread
+ * @n[in]: capacity of each internal heap
+ * @cmp[in]: a comparator
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * nthreads * c internal heaps are created. If c is 0,
+ * 2 heaps per thread are used. If cmp set to be NULL,
+ * then default integer comparator will be used.
+ */
+extern int multiqueue_new(multiqueue_t *mq, const size_t nthreads,
+        const size_t c, const size_t n, const comparator cmp);
+
+/**
+ * multiqueue_free - Destroy a multiqueue
+ *
+ * @mq[in]: the multiqueue
+ *
+ * No other thread may access the multiqueue at this time.
+ */
+extern void multiqueue_free(multiqueue_t *mq);
+
+/**
+ * multiqueue_add - Add an element to multiqueue
+ *
+ * @mq[in]: the multiqueue
+ * @x[in]: value to be stored, must not be NULL
+ *
+ * Return 0 if success, -1 if every internal heap is full.
+ */
+extern int multiqueue_add(multiqueue_t mq, const multiQueueElem x);
+
+/**
+ * multiqueue_poll - Poll a near-minimum element
+ *
+ * @mq[in]: the multiqueue
+ * @x[out]: output value
+ *
+ * Return 0 if an element is retrived, -1 if multiqueue is empty.
+ *
+ * The smaller root of two randomly chosen heaps is retrived
+ * and removed, so the result is not always the global minimum.
+ */
+extern int multiqueue_poll(multiqueue_t mq, multiQueueElem *x);
+
+/**
+ * multiqueue_get_size - Count elements in multiqueue
+ *
+ * @mq[in]: the multiqueue
+ *
+ * Return count of elements, which may be stale
+ * while other threads are updating the multiqueue.
+ */
+extern size_t multiqueue_get_size(multiqueue_t mq);
+
+/**
+ * multiqueue_isempty - Check if the multiqueue is empty or not
+ *
+ * @mq[in]: the multiqueue
+ *
+ * Return non-zero if multiqueue is empty, 0 otherwise.
+ */
+extern int multiqueue_isempty(multiqueue_t mq);
+
+#endif /* BULLET_MULTIQUEUE_H */
@@ -0,0 +1,224 @@
+/*
+ * rb-tree.h - Red-black tree
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_RBTREE_H
+#define BULLET_RBTREE_H
+
+#include "comparator.h"
+
+/**
+ * Define a new data type: rbtree_t
+ */
+typedef struct _rbtree *rbtree_t;
+
+/**
+ * Define a new rbtreeElem type
+ */
+typedef void *rbtreeElem;
+
+/**
+ * Define node of red-black tree
+ *
+ * Embed it in your own struct to use the intrusive API,
+ * so that the tree never allocates nodes by itself.
+ */
+struct rbnode {
+    struct rbnode *parent;
+    struct rbnode *left;
+    struct rbnode *right;
+    int color;
+};
+
+/**
+ * Define a callback comparator of nodes for the intrusive API
+ */
+typedef int (*rbnode_comparator)(const struct rbnode *n1,
+        const struct rbnode *n2);
+
+/**
+ * rbtree_new - Create a new red-black tree
+ *
+ * @rb[out]: the red-black tree
+ * @cmp[in]: comparing function
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If cmp set to be NULL, then function will load default
+ * comparator of intagers.
+ */
+extern int rbtree_new(rbtree_t *rb, const comparator cmp);
+
+/**
+ * rbtree_new_intrusive - Create a new red-black tree of embedded nodes
+ *
+ * @rb[out]: the red-black tree
+ * @cmp[in]: comparing function of nodes
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * Such a tree works with rbtree_*_node() only. The element
+ * calls fail on it as if it were empty, and rbtree_add fails.
+ */
+extern int rbtree_new_intrusive(rbtree_t *rb, const rbnode_comparator cmp);
+
+/**
+ * rbtree_free - Destroy a red-black tree
+ *
+ * @rb[in]: the red-black tree
+ *
+ * Embedded nodes are left to their owner.
+ */
+extern void rbtree_free(rbtree_t *rb);
+
+/**
+ * rbtree_add - Add an element to the red-black tree
+ *
+ * @rb[in]: the red-black tree
+ * @x[in]: the value
+ *
+ * Return 0 if success, -1 if failed to alloc memory, or the
+ * tree is intrusive. Duplicate values are ignored and return 0.
+ */
+extern int rbtree_add(rbtree_t rb, const rbtreeElem x);
+
+/**
+ * rbtree_remove - Remove an element from the red-black tree
+ *
+ * @rb[in]: the red-black tree
+ * @x[in]: the value
+ *
+ * Return 0 if the match node is removed successfully,
+ * -1 if no match node exists.
+ */
+extern int rbtree_remove(rbtree_t rb, const rbtreeElem x);
+
+/**
+ * rbtree_contains - Check red-black tree contains given element or not
+ *
+ * @rb[in]: the red-black tree
+ * @x[in]: the value
+ *
+ * Return non-zero if the value is in the tree, 0 if not.
+ */
+extern int rbtree_contains(rbtree_t rb, const rbtreeElem x);
+
+/**
+ * rbtree_get_min - Find min value in red-black tree
+ *
+ * @rb[in]: the red-black tree
+ * @x[out]: output min value
+ *
+ * Return 0 if find minimum value, -1 if the tree is empty.
+ */
+extern int rbtree_get_min(rbtree_t rb, rbtreeElem *x);
+
+/**
+ * rbtree_get_max - Find max value in red-black tree
+ *
+ * @rb[in]: the red-black tree
+ * @x[out]: output max value
+ *
+ * Return 0 if find maximum value, -1 if the tree is empty.
+ */
+extern int rbtree_get_max(rbtree_t rb, rbtreeElem *x);
+
+/**
+ * rbtree_get_height - Find height of red-black tree
+ *
+ * @rb[in]: the red-black tree
+ *
+ * Return height of the tree, 0 if the tree is empty.
+ */
+extern int rbtree_get_height(rbtree_t rb);
+
+/**
+ * rbtree_isempty - Check if red-black tree is empty or not
+ *
+ * @rb[in]: the red-black tree
+ *
+ * Return non-zero if the tree is empty, 0 if not.
+ */
+extern int rbtree_isempty(rbtree_t rb);
+
+/**
+ * rbtree_insert_node - Link an embedded node into the tree
+ *
+ * @rb[in]: an intrusive red-black tree
+ * @node[in]: the node
+ *
+ * Return 0 if success, -1 if an equal node is already in the tree,
+ * in which case node is left untouched.
+ */
+extern int rbtree_insert_node(rbtree_t rb, struct rbnode *node);
+
+/**
+ * rbtree_erase_node - Unlink an embedded node from the tree
+ *
+ * @rb[in]: an intrusive red-black tree
+ * @node[in]: a node in the tree
+ */
+extern void rbtree_erase_node(rbtree_t rb, struct rbnode *node);
+
+/**
+ * rbtree_find_node - Find node equal to a given key node
+ *
+ * @rb[in]: an intrusive red-black tree
+ * @key[in]: the key node, which needs not to be in the tree
+ *
+ * Return the node, NULL if no match node exists.
+ */
+extern struct rbnode *rbtree_find_node(rbtree_t rb, const struct rbnode *key);
+
+/**
+ * rbtree_first_node - Get the smallest node
+ *
+ * @rb[in]: an intrusive red-black tree
+ *
+ * Return the node, NULL if the tree is empty.
+ */
+extern struct rbnode *rbtree_first_node(rbtree_t rb);
+
+/**
+ * rbtree_last_node - Get the largest node
+ *
+ * @rb[in]: an intrusive red-black tree
+ *
+ * Return the node, NULL if the tree is empty.
+ */
+extern struct rbnode *rbtree_last_node(rbtree_t rb);
+
+/**
+ * rbtree_next_node - Get in-order successor of a node
+ *
+ * @node[in]: a node in the tree
+ *
+ * Return the successor, NULL if node is the largest one.
+ */
+extern struct rbnode *rbtree_next_node(const struct rbnode *node);
+
+/**
+ * rbtree_prev_node - Get in-order precursor of a node
+ *
+ * @node[in]: a node in the tree
+ *
+ * Return the precursor, NULL if node is the smallest one.
+ */
+extern struct rbnode *rbtree_prev_node(const struct rbnode *node);
+
+#endif /* BULLET_RBTREE_H */
@@ -20,6 +20,7 @@
 #ifndef BULLET_SKIPLIST_H
 #define BULLET_SKIPLIST_H
 
+#include <stddef.h>
 #include "comparator.h"
 
 /**
@@ -32,6 +33,13 @@ typedef struct _skiplist *skiplist_t;
  */
 typedef void *skiplistElem;
 
+/**
+ * Define a callback for scans by rank
+ *
+ * Return non-zero to stop the scan, 0 to go on.
+ */
+typedef int (*skiplist_visitor)(skiplistElem x, void *arg);
+
 /**
  * skiplist_new - Create a new skiplist
  *
@@ -43,6 +51,40 @@ typedef void *skiplistElem;
  */
 extern int skiplist_new(skiplist_t *skiplist, comparator cmp);
 
+/**
+ * skiplist_new_inline - Create a new skiplist holding copies of elements
+ *
+ * @skiplist[out]: the skiplist
+ * @cmp[in]: comparator
+ * @size[in]: size of each element in bytes
+ *
+ * Return 0 if create a new skiplist successfully,
+ * -1 if failed to alloc memory or size is 0.
+ *
+ * Elements passed in are copied into the nodes, so the
+ * search needs no trip to memory elsewhere. Fits small keys
+ * of fixed size, such as integers.
+ */
+extern int skiplist_new_inline(skiplist_t *skiplist, comparator cmp,
+        size_t size);
+
+/**
+ * skiplist_from_sorted - Create a skiplist from sorted elements
+ *
+ * @skiplist[out]: the skiplist
+ * @elems[in]: elements in strictly ascending order
+ * @n[in]: count of elements
+ * @cmp[in]: comparator
+ *
+ * Return 0 if success, -1 if elems are not strictly ascending
+ * or failed to alloc memory.
+ *
+ * Boxes are appended at the end of their levels in one
+ * pass, which is O(n) without any search.
+ */
+extern int skiplist_from_sorted(skiplist_t *skiplist,
+        skiplistElem const elems[], const size_t n, const comparator cmp);
+
 /**
  * skiplist_free - Destroy a skiplist
  *
@@ -50,6 +92,20 @@ extern int skiplist_new(skiplist_t *skiplist, comparator cmp);
  */
 extern void skiplist_free(skiplist_t *skiplist);
 
+/**
+ * skiplist_set_branching - Set 1/p of skiplist
+ *
+ * @skiplist[in]: the skiplist
+ * @branching[in]: a power of 2, 4 by default
+ *
+ * Return 0 if success, -1 if branching is not a power of 2
+ * or less than 2.
+ *
+ * New boxes go one level higher with chance p. A larger
+ * branching saves memory for longer level scans.
+ */
+extern int skiplist_set_branching(skiplist_t skiplist, unsigned int branching);
+
 /**
  * skiplist_add - Add an element to a skiplist
  *
@@ -60,6 +116,36 @@ extern void skiplist_free(skiplist_t *skiplist);
  */
 extern int skiplist_add(skiplist_t skiplist, skiplistElem x);
 
+/**
+ * skiplist_add_hint - Add an element, searching from the last change
+ *
+ * @skiplist[in]: the skiplist
+ * @x[in]: input value
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * The search starts where the last element was added or
+ * removed, and costs O(log d) for d elements in between.
+ * Adding nearly sorted elements this way takes O(1) each.
+ */
+extern int skiplist_add_hint(skiplist_t skiplist, skiplistElem x);
+
+/**
+ * skiplist_add_batch - Add elements in any order to a skiplist
+ *
+ * @skiplist[in]: the skiplist
+ * @elems[in]: the elements, left untouched
+ * @n[in]: count of elements
+ *
+ * Return 0 if success, -1 if failed to alloc memory, and
+ * then some of the elements may have been added.
+ *
+ * A sorted copy of the batch is merged into the skiplist in
+ * one sweep, each search going on from the last one.
+ */
+extern int skiplist_add_batch(skiplist_t skiplist, skiplistElem const elems[],
+        size_t n);
+
 /**
  * skiplist_remove - Remove an element from the skiplist
  *
@@ -81,4 +167,52 @@ extern int skiplist_remove(skiplist_t skiplist, skiplistElem x);
  */
 extern int skiplist_contains(skiplist_t skiplist, skiplistElem x);
 
+/**
+ * skiplist_get_size - Get count of elements in skiplist
+ *
+ * @skiplist[in]: the skiplist
+ *
+ * Return count of elements.
+ */
+extern size_t skiplist_get_size(skiplist_t skiplist);
+
+/**
+ * skiplist_rank - Count elements less than x
+ *
+ * @skiplist[in]: the skiplist
+ * @x[in]: the value, which needs not to be in skiplist
+ *
+ * Return count of elements less than x, which is also
+ * the 0-based position of x if it is in skiplist.
+ */
+extern size_t skiplist_rank(skiplist_t skiplist, skiplistElem x);
+
+/**
+ * skiplist_at - Find the k-th smallest element
+ *
+ * @skiplist[in]: the skiplist
+ * @k[in]: 0-based position
+ * @x[out]: the element
+ *
+ * Return 0 if success, -1 if k is not less than size of skiplist.
+ */
+extern int skiplist_at(skiplist_t skiplist, size_t k, skiplistElem *x);
+
+/**
+ * skiplist_range_by_rank - Visit elements at positions [lo, hi] in order
+ *
+ * @skiplist[in]: the skiplist
+ * @lo[in]: first 0-based position
+ * @hi[in]: last 0-based position
+ * @visit[in]: callback of each element
+ * @arg[in]: passed to visit as is
+ *
+ * Return count of visited elements, 0 if lo > hi.
+ *
+ * Links count the elements they skip, so finding lo costs
+ * O(log n), like a search by value.
+ */
+extern size_t skiplist_range_by_rank(skiplist_t skiplist, size_t lo,
+        size_t hi, skiplist_visitor visit, void *arg);
+
 #endif /*  BULLET_SKIPLIST_H */
@@ -0,0 +1,138 @@
+/*
+ * timer-wheel.h - Hierarchical timing wheel
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_TIMER_WHEEL_H
+#define BULLET_TIMER_WHEEL_H
+
+#include <stdlib.h>
+
+/**
+ * Define a new data type: timerwheel_t
+ *
+ * Time is counted in ticks of the caller's choice. The first
+ * level has one slot per tick, every upper level has one slot
+ * per full turn of the level below. Timers move down a level
+ * (cascade) when the lower level wraps around.
+ */
+typedef struct _timerwheel *timerwheel_t;
+
+/**
+ * Define a new data type: twtimer_t, handle of a pending timer
+ */
+typedef struct _twtimer *twtimer_t;
+
+/**
+ * Define a new timerWheelElem type
+ */
+typedef void *timerWheelElem;
+
+/**
+ * Define a callback for expired timers
+ */
+typedef void (*timerwheel_callback)(timerWheelElem x);
+
+/**
+ * timerwheel_new - Create a new timing wheel
+ *
+ * @tw[out]: the timing wheel
+ * @now[in]: current tick
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ */
+extern int timerwheel_new(timerwheel_t *tw, const unsigned long now);
+
+/**
+ * timerwheel_free - Destroy a timing wheel
+ *
+ * @tw[in]: the timing wheel
+ *
+ * Pending timers are dropped without firing.
+ */
+extern void timerwheel_free(timerwheel_t *tw);
+
+/**
+ * timerwheel_schedule - Schedule a new timer
+ *
+ * @tw[in]: the timing wheel
+ * @timer[out]: handle of the timer
+ * @expires[in]: tick at which the timer fires
+ * @x[in]: value passed to callback
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * A timer which is already expired fires on next timerwheel_advance(),
+ * even if given the same now as the last one.
+ * The handle is valid until the timer fires or is cancelled,
+ * and dangles afterwards.
+ */
+extern int timerwheel_schedule(timerwheel_t tw, twtimer_t *timer,
+        const unsigned long expires, const timerWheelElem x);
+
+/**
+ * timerwheel_reschedule - Move a pending timer to a new tick
+ *
+ * @tw[in]: the timing wheel
+ * @timer[in]: handle of a pending timer
+ * @expires[in]: new tick at which the timer fires
+ *
+ * The timer must not have fired yet, the handle of a fired
+ * timer dangles and passing it corrupts the wheel.
+ */
+extern void timerwheel_reschedule(timerwheel_t tw, twtimer_t timer,
+        const unsigned long expires);
+
+/**
+ * timerwheel_cancel - Cancel a pending timer
+ *
+ * @tw[in]: the timing wheel
+ * @timer[in]: handle of a pending timer
+ *
+ * Return 0 if success, -1 if timer is NULL.
+ *
+ * The handle is set to NULL after this operation. As with
+ * timerwheel_reschedule(), the timer must not have fired yet.
+ */
+extern int timerwheel_cancel(timerwheel_t tw, twtimer_t *timer);
+
+/**
+ * timerwheel_advance - Advance the wheel and fire expired timers
+ *
+ * @tw[in]: the timing wheel
+ * @now[in]: current tick
+ * @cb[in]: callback of expired timers
+ *
+ * Return count of fired timers.
+ *
+ * Every timer which expires at or before now is fired. Callbacks
+ * may schedule and cancel timers on the same wheel, timers they
+ * schedule at or before now fire on the next call.
+ */
+extern size_t timerwheel_advance(timerwheel_t tw, const unsigned long now,
+        timerwheel_callback cb);
+
+/**
+ * timerwheel_get_size - Count pending timers
+ *
+ * @tw[in]: the timing wheel
+ *
+ * Return count of pending timers, 0 if there is none.
+ */
+extern size_t timerwheel_get_size(timerwheel_t tw);
+
+#endif /* BULLET_TIMER_WHEEL_H */
@@ -0,0 +1,121 @@
+/*
+ * topk.h - Bounded top-k collector
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BULLET_TOPK_H
+#define BULLET_TOPK_H
+
+#include <stdlib.h>
+#include "comparator.h"
+
+/**
+ * Define a new data type: topk_t
+ *
+ * A topk keeps the k largest elements seen so far in a
+ * fixed-size min heap, whose root is the rejection threshold.
+ */
+typedef struct _topk *topk_t;
+
+/**
+ * Define a new topkElem type
+ */
+typedef void *topkElem;
+
+/**
+ * topk_new - Create a new top-k collector
+ *
+ * @topk[out]: the collector
+ * @k[in]: count of elements to keep
+ * @cmp[in]: a comparator
+ *
+ * Return 0 if success, -1 if failed to alloc memory.
+ *
+ * If cmp set to be NULL, then default
+ * integer comparator will be used.
+ */
+extern int topk_new(topk_t *topk, const size_t k, const comparator cmp);
+
+/**
+ * topk_free - Destroy a top-k collector
+ *
+ * @topk[in]: the collector
+ */
+extern void topk_free(topk_t *topk);
+
+/**
+ * topk_add - Offer an element to the collector
+ *
+ * @topk[in]: the collector
+ * @x[in]: input value
+ *
+ * Return non-zero if x is kept, 0 if it is rejected.
+ *
+ * Once k elements are kept, x is rejected with a single
+ * comparison if it is not larger than the threshold,
+ * otherwise it replaces the threshold.
+ */
+extern int topk_add(topk_t topk, const topkElem x);
+
+/**
+ * topk_add_ints - Offer an array of integers to the collector
+ *
+ * @topk[in]: the collector
+ * @xs[in]: the integers
+ * @n[in]: length of xs
+ *
+ * Return count of integers kept.
+ *
+ * Pointers into xs are kept, so xs must outlive the collector.
+ * With the default integer comparator, integers are checked
+ * against the threshold several at a time with SIMD, and only
+ * the blocks holding a larger one go into the heap.
+ */
+extern size_t topk_add_ints(topk_t topk, const int *xs, const size_t n);
+
+/**
+ * topk_peek - Peek the threshold
+ *
+ * @topk[in]: the collector
+ * @x[out]: the smallest element kept
+ *
+ * Return 0 if success, -1 if collector is empty.
+ */
+extern int topk_peek(topk_t topk, topkElem *x);
+
+/**
+ * topk_poll - Poll the smallest element kept
+ *
+ * @topk[in]: the collector
+ * @x[out]: output value
+ *
+ * Return 0 if success, -1 if collector is empty.
+ *
+ * Polling until empty retrives the top-k in ascending order.
+ */
+extern int topk_poll(topk_t topk, topkElem *x);
+
+/**
+ * topk_get_size - Count elements kept
+ *
+ * @topk[in]: the collector
+ *
+ * Return count of elements kept, at most k.
+ */
+extern size_t topk_get_size(topk_t topk);
+
+#endif /* BULLET_TOPK_H */
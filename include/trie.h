@@ -18,8 +18,14 @@
 #ifndef _BULLET_TRIE_H
 #define _BULLET_TRIE_H
 
+#include <stddef.h>
+
 /**
  * Define a new trie_t type
+ *
+ * Words are strings of any bytes but '\0'. Nodes are of
+ * 4, 16, 48 or 256 children by how many they have, and
+ * chains of single children are merged into one node.
  */
 typedef struct _trie *trie_t;
 
@@ -73,4 +79,23 @@ int trie_contains(trie_t trie, const char *word);
  */
 int trie_startswith(trie_t trie, const char *prefix);
 
+/**
+ * trie_remove - Remove a word from trie
+ *
+ * @trie[in]: the trie
+ * @word[in]: the word
+ *
+ * Return 0 if success, -1 if the word is not in trie.
+ */
+int trie_remove(trie_t trie, const char *word);
+
+/**
+ * trie_get_size - Get count of words in trie
+ *
+ * @trie[in]: the trie
+ *
+ * Return count of words.
+ */
+size_t trie_get_size(trie_t trie);
+
 #endif /* _BULLET_TRIE_H */
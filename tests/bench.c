@@ -0,0 +1,263 @@
+/*
+ * bench.c - Compare red-black tree and B+tree against avl-tree
+ *
+ * Build with `make bench CFLAGS=-O2` and run ./build/bench [n].
+ *
+ * Copyright (C) 2018 by Xiaoliang Fang (fangxlmr@foxmail.com).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include "avl-tree.h"
+#include "rb-tree.h"
+#include "bptree.h"
+
+struct item {
+    struct rbnode node;
+    int key;
+};
+
+static int cmp_item(const struct rbnode *n1, const struct rbnode *n2)
+{
+    const struct item *i1 = (const struct item *) n1;
+    const struct item *i2 = (const struct item *) n2;
+
+    return (i1->key > i2->key) - (i1->key < i2->key);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Every workload runs n operations on keys drawn from [0, 2n):
+ *   insert  - n inserts into an empty tree
+ *   mixed   - 50% insert, 50% delete on the filled tree
+ *   lookup  - 90% lookup, 10% insert or delete
+ */
+static const char *workloads[] = {"insert", "mixed", "lookup"};
+
+static void run_avl(int *keys, int *ops, size_t n, double res[])
+{
+    avltree_t avl;
+    double t;
+    size_t i;
+
+    avltree_new(&avl, NULL);
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        avltree_add(avl, &keys[i]);
+    }
+    res[0] = now() - t;
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        if (ops[i] % 2) {
+            avltree_add(avl, &keys[n + i]);
+        } else {
+            avltree_remove(avl, &keys[n + i]);
+        }
+    }
+    res[1] = now() - t;
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        if (ops[i] % 10) {
+            avltree_contains(avl, &keys[i]);
+        } else if (ops[i] % 20) {
+            avltree_add(avl, &keys[n + i]);
+        } else {
+            avltree_remove(avl, &keys[n + i]);
+        }
+    }
+    res[2] = now() - t;
+
+    avltree_free(&avl);
+}
+
+static void run_rb(int *keys, int *ops, size_t n, double res[])
+{
+    rbtree_t rb;
+    double t;
+    size_t i;
+
+    rbtree_new(&rb, NULL);
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        rbtree_add(rb, &keys[i]);
+    }
+    res[0] = now() - t;
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        if (ops[i] % 2) {
+            rbtree_add(rb, &keys[n + i]);
+        } else {
+            rbtree_remove(rb, &keys[n + i]);
+        }
+    }
+    res[1] = now() - t;
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        if (ops[i] % 10) {
+            rbtree_contains(rb, &keys[i]);
+        } else if (ops[i] % 20) {
+            rbtree_add(rb, &keys[n + i]);
+        } else {
+            rbtree_remove(rb, &keys[n + i]);
+        }
+    }
+    res[2] = now() - t;
+
+    rbtree_free(&rb);
+}
+
+static void run_rb_intrusive(int *keys, int *ops, size_t n, double res[])
+{
+    struct item *items, *found;
+    struct item key;
+    rbtree_t rb;
+    double t;
+    size_t i;
+
+    /* Slot k of items holds key k, the caller owns all memory. */
+    items = (struct item *) calloc(2 * n, sizeof(*items));
+    for (i = 0; i < 2 * n; ++i) {
+        items[i].key = (int) i;
+    }
+    rbtree_new_intrusive(&rb, cmp_item);
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        rbtree_insert_node(rb, &items[keys[i]].node);
+    }
+    res[0] = now() - t;
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        key.key = keys[n + i];
+        found = (struct item *) rbtree_find_node(rb, &key.node);
+        if (ops[i] % 2) {
+            if (found == NULL) {
+                rbtree_insert_node(rb, &items[key.key].node);
+            }
+        } else if (found != NULL) {
+            rbtree_erase_node(rb, &found->node);
+        }
+    }
+    res[1] = now() - t;
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        key.key = (ops[i] % 10) ? keys[i] : keys[n + i];
+        found = (struct item *) rbtree_find_node(rb, &key.node);
+        if (ops[i] % 10 == 0) {
+            if (ops[i] % 20 && found == NULL) {
+                rbtree_insert_node(rb, &items[key.key].node);
+            } else if (ops[i] % 20 == 0 && found != NULL) {
+                rbtree_erase_node(rb, &found->node);
+            }
+        }
+    }
+    res[2] = now() - t;
+
+    rbtree_free(&rb);
+    free(items);
+}
+
+static void run_bpt(int *keys, int *ops, size_t n, double res[])
+{
+    bptree_t bpt;
+    double t;
+    size_t i;
+
+    bptree_new(&bpt);
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        bptree_put(bpt, keys[i], NULL);
+    }
+    res[0] = now() - t;
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        if (ops[i] % 2) {
+            bptree_put(bpt, keys[n + i], NULL);
+        } else {
+            bptree_remove(bpt, keys[n + i]);
+        }
+    }
+    res[1] = now() - t;
+
+    t = now();
+    for (i = 0; i < n; ++i) {
+        if (ops[i] % 10) {
+            bptree_contains(bpt, keys[i]);
+        } else if (ops[i] % 20) {
+            bptree_put(bpt, keys[n + i], NULL);
+        } else {
+            bptree_remove(bpt, keys[n + i]);
+        }
+    }
+    res[2] = now() - t;
+
+    bptree_free(&bpt);
+}
+
+int main(int argc, char **argv)
+{
+    size_t n, i;
+    int *keys, *ops;
+    double avl[3], rb[3], rbi[3], bpt[3];
+
+    n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+    keys = (int *) malloc(2 * n * sizeof(*keys));
+    ops = (int *) malloc(n * sizeof(*ops));
+
+    srand(42);
+    for (i = 0; i < 2 * n; ++i) {
+        keys[i] = rand() % (2 * n);
+    }
+    for (i = 0; i < n; ++i) {
+        ops[i] = rand();
+    }
+
+    run_avl(keys, ops, n, avl);
+    run_rb(keys, ops, n, rb);
+    run_rb_intrusive(keys, ops, n, rbi);
+    run_bpt(keys, ops, n, bpt);
+
+    printf("%zu operations per workload, seconds\n", n);
+    printf("%-8s %10s %10s %14s %10s\n",
+            "", "avl-tree", "rb-tree", "rb-intrusive", "bptree");
+    for (i = 0; i < 3; ++i) {
+        printf("%-8s %10.3f %10.3f %14.3f %10.3f\n",
+                workloads[i], avl[i], rb[i], rbi[i], bpt[i]);
+    }
+
+    free(keys);
+    free(ops);
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <pthread.h>
 #include <gtest/gtest.h>
 #include "vector.h"
 #include "stack.h"
@@ -10,6 +11,19 @@
 #include "bstree.h"
 #include "binary-minheap.h"
 #include "trie.h"
+#include "multiqueue.h"
+#include "topk.h"
+#include "kmerge.h"
+#include "timer-wheel.h"
+#include "minmax-heap.h"
+#include "rb-tree.h"
+#include "avlmap.h"
+#include "intervaltree.h"
+#include "bptree.h"
+#include "frozenset.h"
+#include "cavl-tree.h"
+#include "cskiplist.h"
+#include "memtable.h"
 
 static int a[] = {
     11, 23, 35, 20, 
@@ -164,6 +178,12 @@ TEST(hashtable, hashtable_testing) {
     hashtable_free(&hashtable);
 }
 
+static int sum_visitor(void *x, void *arg)
+{
+    *(int *) arg += *(int *) x;
+    return 0;
+}
+
 TEST(skiplist, skiplist_testing) {
     int i;
     skiplistElem x;
@@ -186,10 +206,118 @@ TEST(skiplist, skiplist_testing) {
     EXPECT_EQ(-1, skiplist_remove(skiplist, &a[1]));
 
     skiplist_free(&skiplist);
+
+    /* Nearly sorted, pairs swapped. */
+    int nums[1000];
+    for (i = 0; i < 1000; i++) {
+        nums[i] = i;
+    }
+    ASSERT_EQ(0, skiplist_new(&skiplist, NULL));
+    EXPECT_EQ(-1, skiplist_set_branching(skiplist, 3));
+    EXPECT_EQ(-1, skiplist_set_branching(skiplist, 1));
+    EXPECT_EQ(0, skiplist_set_branching(skiplist, 2));
+    for (i = 0; i < 1000; i++) {
+        EXPECT_EQ(0, skiplist_add_hint(skiplist, &nums[i ^ 1]));
+    }
+    EXPECT_EQ(0, skiplist_add_hint(skiplist, &nums[3]));
+    EXPECT_EQ(0, skiplist_remove(skiplist, &nums[500]));
+    EXPECT_EQ(0, skiplist_add_hint(skiplist, &nums[500]));
+    EXPECT_EQ(0, skiplist_remove(skiplist, &nums[0]));
+    for (i = 1; i < 1000; i++) {
+        EXPECT_TRUE(skiplist_contains(skiplist, &nums[i]));
+        EXPECT_EQ(0, skiplist_remove(skiplist, &nums[i]));
+    }
+    EXPECT_FALSE(skiplist_contains(skiplist, &nums[0]));
+    skiplist_free(&skiplist);
+
+    /* Inline elements are copies. */
+    int tmp;
+    EXPECT_EQ(-1, skiplist_new_inline(&skiplist, NULL, 0));
+    ASSERT_EQ(0, skiplist_new_inline(&skiplist, NULL, sizeof(int)));
+    for (i = 0; i < LEN_A; i++) {
+        tmp = a[i];
+        EXPECT_EQ(0, skiplist_add(skiplist, &tmp));
+    }
+    tmp = 0;
+    EXPECT_TRUE(skiplist_contains(skiplist, &a[6]));
+    EXPECT_FALSE(skiplist_contains(skiplist, &b[0]));
+    for (i = 0; i < LEN_A - 1; i++) {
+        EXPECT_EQ(0, skiplist_remove(skiplist, &a[i]));
+    }
+    EXPECT_FALSE(skiplist_contains(skiplist, &a[6]));
+    skiplist_free(&skiplist);
+
+    /* Ranks, evens left of 0..999 added out of order. */
+    int sum;
+    ASSERT_EQ(0, skiplist_new(&skiplist, NULL));
+    EXPECT_EQ(-1, skiplist_at(skiplist, 0, &x));
+    for (i = 0; i < 1000; i++) {
+        EXPECT_EQ(0, skiplist_add(skiplist, &nums[(i * 7) % 1000]));
+    }
+    for (i = 1; i < 1000; i += 2) {
+        EXPECT_EQ(0, (i % 4 == 1) ? skiplist_remove(skiplist, &nums[i])
+                : skiplist_remove(skiplist, &nums[i]) + skiplist_add_hint(
+                    skiplist, &nums[i]) + skiplist_remove(skiplist, &nums[i]));
+    }
+    EXPECT_EQ(500u, skiplist_get_size(skiplist));
+    for (i = 0; i < 1000; i++) {
+        EXPECT_EQ((size_t) (i + 1) / 2, skiplist_rank(skiplist, &nums[i]));
+    }
+    for (i = 0; i < 500; i++) {
+        ASSERT_EQ(0, skiplist_at(skiplist, i, &x));
+        EXPECT_EQ(2 * i, *(int *) x);
+    }
+    EXPECT_EQ(-1, skiplist_at(skiplist, 500, &x));
+
+    sum = 0;    /* 20 + 22 + 24 */
+    EXPECT_EQ(3u, skiplist_range_by_rank(skiplist, 10, 12, sum_visitor, &sum));
+    EXPECT_EQ(66, sum);
+    sum = 0;
+    EXPECT_EQ(2u, skiplist_range_by_rank(skiplist, 498, 600, sum_visitor, &sum));
+    EXPECT_EQ(1994, sum);
+    EXPECT_EQ(0u, skiplist_range_by_rank(skiplist, 12, 10, sum_visitor, &sum));
+    EXPECT_EQ(0u, skiplist_range_by_rank(skiplist, 500, 600, sum_visitor, &sum));
+
+    /* Odds in a batch, out of order and twice each. */
+    skiplistElem batch[1000];
+    for (i = 0; i < 1000; i++) {
+        batch[i] = &nums[((i * 7) % 500) * 2 + 1];
+    }
+    EXPECT_EQ(0, skiplist_add_batch(skiplist, batch, 1000));
+    EXPECT_EQ(0, skiplist_add_batch(skiplist, batch, 0));
+    EXPECT_EQ(1000u, skiplist_get_size(skiplist));
+    for (i = 0; i < 1000; i++) {
+        ASSERT_EQ(0, skiplist_at(skiplist, i, &x));
+        EXPECT_EQ(i, *(int *) x);
+    }
+    skiplist_free(&skiplist);
+
+    for (i = 0; i < 1000; i++) {
+        batch[i] = &nums[i];
+    }
+    ASSERT_EQ(0, skiplist_from_sorted(&skiplist, batch, 1000, NULL));
+    EXPECT_EQ(1000u, skiplist_get_size(skiplist));
+    for (i = 0; i < 1000; i++) {
+        EXPECT_TRUE(skiplist_contains(skiplist, &nums[i]));
+        EXPECT_EQ((size_t) i, skiplist_rank(skiplist, &nums[i]));
+    }
+    EXPECT_EQ(0, skiplist_remove(skiplist, &nums[10]));
+    EXPECT_EQ(0, skiplist_add(skiplist, &nums[10]));
+    EXPECT_EQ(0, skiplist_at(skiplist, 999, &x));
+    EXPECT_EQ(&nums[999], x);
+    skiplist_free(&skiplist);
+
+    batch[1] = batch[0];
+    EXPECT_EQ(-1, skiplist_from_sorted(&skiplist, batch, 1000, NULL));
+    ASSERT_EQ(0, skiplist_from_sorted(&skiplist, batch, 0, NULL));
+    EXPECT_EQ(0u, skiplist_get_size(skiplist));
+    skiplist_free(&skiplist);
 }
 
 TEST(avl_tree, avltree_testing) {
     int i;
+    int nums[1000];
+    avltreeElem elems[1000];
     avltreeElem x;
     avltree_t avl;
 
@@ -197,6 +325,7 @@ TEST(avl_tree, avltree_testing) {
     for (i = 0; i < LEN_A; i++) {
         EXPECT_EQ(0, avltree_add(avl, &a[i]));
     }
+    EXPECT_EQ(4, avltree_get_height(avl));
     EXPECT_TRUE(avltree_contains(avl, &a[0]));
     EXPECT_FALSE(avltree_contains(avl, &b[0]));
 
@@ -211,6 +340,18 @@ TEST(avl_tree, avltree_testing) {
     EXPECT_EQ(0, avltree_get_max(avl, &x));
     EXPECT_EQ(330, *(int *) x);
 
+    /* -501 -10 0 2 20 23 25 35 78 330 */
+    EXPECT_EQ(10u, avltree_get_size(avl));
+    EXPECT_EQ(7u, avltree_rank(avl, &b[0]));
+    EXPECT_EQ(3u, avltree_rank(avl, &a[4]));
+    EXPECT_EQ(0, avltree_select(avl, 7, &x));
+    EXPECT_EQ(35, *(int *) x);
+    EXPECT_EQ(0, avltree_select(avl, 0, &x));
+    EXPECT_EQ(-501, *(int *) x);
+    EXPECT_EQ(-1, avltree_select(avl, 10, &x));
+    EXPECT_EQ(5u, avltree_count_range(avl, &b[6], &b[0]));
+    EXPECT_EQ(0u, avltree_count_range(avl, &b[0], &b[6]));
+
     for (i = 1; i < LEN_A - 1; i++) {
         EXPECT_EQ(0, avltree_remove(avl, &a[i]));
     }
@@ -220,10 +361,70 @@ TEST(avl_tree, avltree_testing) {
     EXPECT_TRUE(avltree_isempty(avl));
 
     avltree_free(&avl);
+
+    for (i = 0; i < 1000; i++) {
+        elems[i] = &nums[i];
+        nums[i] = 2 * i;
+    }
+    ASSERT_EQ(0, avltree_from_sorted(&avl, elems, 1000, NULL));
+    EXPECT_EQ(10, avltree_get_height(avl));
+    EXPECT_EQ(1000u, avltree_get_size(avl));
+    EXPECT_EQ(0, avltree_select(avl, 500, &x));
+    EXPECT_EQ(1000, *(int *) x);
+    EXPECT_EQ(0, avltree_remove(avl, &nums[500]));
+    EXPECT_EQ(0, avltree_add(avl, &b[0]));
+    EXPECT_EQ(15u, avltree_rank(avl, &b[0]));
+    avltree_free(&avl);
+
+    nums[1] = 0;
+    EXPECT_EQ(-1, avltree_from_sorted(&avl, elems, 1000, NULL));
+
+    /* Nearly sorted, pairs swapped, then a step back. */
+    avltree_cursor_t cur;
+    for (i = 0; i < 1000; i++) {
+        nums[i] = i;
+    }
+    ASSERT_EQ(0, avltree_new(&avl, NULL));
+    ASSERT_EQ(0, avltree_cursor_new(&cur, avl));
+    for (i = 0; i < 1000; i++) {
+        EXPECT_EQ(0, avltree_add_hint(avl, cur, &nums[i ^ 1]));
+    }
+    EXPECT_EQ(0, avltree_add_hint(avl, cur, &nums[500]));
+    EXPECT_EQ(1000u, avltree_get_size(avl));
+    EXPECT_EQ(10, avltree_get_height(avl));
+    EXPECT_EQ(0, avltree_remove(avl, &nums[10]));
+    EXPECT_EQ(0, avltree_cursor_first(cur, &x));
+    EXPECT_EQ(0, avltree_add_hint(avl, cur, &nums[10]));
+    EXPECT_EQ(0, avltree_next(cur, &x));
+    EXPECT_EQ(11, *(int *) x);
+    EXPECT_EQ(0, avltree_cursor_first(cur, &x));
+    for (i = 1; i < 1000; i++) {
+        EXPECT_EQ(0, avltree_next(cur, &x));
+        EXPECT_EQ(i, *(int *) x);
+    }
+    avltree_cursor_free(&cur);
+    avltree_free(&avl);
+
+    /* Maps take no hints, they would lose the value. */
+    avlmap_t map;
+    ASSERT_EQ(0, avlmap_new(&map, NULL));
+    ASSERT_EQ(0, avltree_cursor_new(&cur, map));
+    EXPECT_EQ(-1, avltree_add_hint(map, cur, &nums[0]));
+    EXPECT_TRUE(avlmap_isempty(map));
+
+    /* Nor does a tree take the cursor of another one. */
+    ASSERT_EQ(0, avltree_new(&avl, NULL));
+    EXPECT_EQ(-1, avltree_add_hint(avl, cur, &nums[0]));
+    EXPECT_TRUE(avltree_isempty(avl));
+    avltree_free(&avl);
+    avltree_cursor_free(&cur);
+    avlmap_free(&map);
 }
 
 TEST(bstree, bstree_testing) {
     int i;
+    int nums[1000];
+    bstreeElem elems[1000];
     bstreeElem x;
     bstree_t bstree;
 
@@ -254,6 +455,42 @@ TEST(bstree, bstree_testing) {
     EXPECT_TRUE(bstree_isempty(bstree));
 
     bstree_free(&bstree);
+
+    for (i = 0; i < 1000; i++) {
+        elems[i] = &nums[i];
+        nums[i] = 2 * i;
+    }
+    ASSERT_EQ(0, bstree_from_sorted(&bstree, elems, 1000, NULL));
+    EXPECT_EQ(10u, bstree_get_height(bstree));
+    EXPECT_TRUE(bstree_contains(bstree, &nums[999]));
+    EXPECT_FALSE(bstree_contains(bstree, &b[0]));
+    EXPECT_EQ(0, bstree_remove(bstree, &nums[0]));
+    EXPECT_EQ(0, bstree_get_min(bstree, &x));
+    EXPECT_EQ(2, *(int *) x);
+    bstree_free(&bstree);
+
+    nums[1] = 0;
+    EXPECT_EQ(-1, bstree_from_sorted(&bstree, elems, 1000, NULL));
+
+    /* Sorted inserts don't leave a splay tree as a list for long. */
+    ASSERT_EQ(0, bstree_new_splay(&bstree, NULL));
+    for (i = 0; i < 1000; i++) {
+        nums[i] = i;
+        EXPECT_EQ(0, bstree_add(bstree, &nums[i]));
+    }
+    EXPECT_EQ(0, bstree_add(bstree, &nums[500]));
+    EXPECT_TRUE(bstree_contains(bstree, &nums[0]));
+    EXPECT_GT(500u, bstree_get_height(bstree));
+    EXPECT_FALSE(bstree_contains(bstree, &b[11]));
+    for (i = 0; i < 1000; i += 2) {
+        EXPECT_EQ(0, bstree_remove(bstree, &nums[i]));
+    }
+    EXPECT_EQ(-1, bstree_remove(bstree, &nums[0]));
+    EXPECT_EQ(0, bstree_get_min(bstree, &x));
+    EXPECT_EQ(1, *(int *) x);
+    EXPECT_EQ(0, bstree_get_max(bstree, &x));
+    EXPECT_EQ(999, *(int *) x);
+    bstree_free(&bstree);
 }
 
 TEST(binary_minheap, binary_minheap_testing) {
@@ -290,6 +527,27 @@ TEST(binary_minheap, binary_minheap_testing) {
     EXPECT_TRUE(binary_minheap_isempty(mh));
     EXPECT_FALSE(binary_minheap_isfull(mh));
 
+    /* Replace takes the root out and sifts the new one down. */
+    int big = 1000, small = -1000;
+    EXPECT_EQ(-1, binary_minheap_replace(mh, &big, &x));
+    for (i = 0; i < LEN_A; i++) {
+        EXPECT_EQ(0, binary_minheap_add(mh, &a[i]));
+    }
+    EXPECT_EQ(0, binary_minheap_replace(mh, &big, &x));
+    EXPECT_EQ(-501, *(int *) x);
+    EXPECT_EQ(LEN_A, binary_minheap_get_size(mh));
+    EXPECT_EQ(0, binary_minheap_peek(mh, &x));
+    EXPECT_EQ(-10, *(int *) x);
+    EXPECT_EQ(0, binary_minheap_replace(mh, &small, &x));
+    EXPECT_EQ(-10, *(int *) x);
+    EXPECT_EQ(0, binary_minheap_peek(mh, &x));
+    EXPECT_EQ(-1000, *(int *) x);
+    EXPECT_EQ(0, binary_minheap_poll(mh, &x));
+    for (i = 1; i < LEN_A; i++) {
+        EXPECT_EQ(0, binary_minheap_poll(mh, &x));
+    }
+    EXPECT_EQ(1000, *(int *) x);
+
     binary_minheap_free(&mh);
 }
 
@@ -321,7 +579,1019 @@ TEST(trie, trie_testing) {
     EXPECT_TRUE(trie_startswith(trie, "sim"));
     EXPECT_FALSE(trie_startswith(trie, "she"));
 
+    /* Words sharing long prefixes, and bytes of all kinds. */
+    char word[32];
+    EXPECT_EQ((size_t) len, trie_get_size(trie));
+    for (i = 1; i < 256; ++i) {
+        snprintf(word, sizeof(word), "http://example.com/%c", i);
+        EXPECT_EQ(0, trie_add(trie, word));
+    }
+    EXPECT_EQ(0, trie_add(trie, "http://example.com/"));
+    EXPECT_EQ(0, trie_add(trie, "HTTP"));
+    EXPECT_EQ(0, trie_add(trie, "HTTP"));
+    EXPECT_EQ((size_t) len + 257, trie_get_size(trie));
+    EXPECT_TRUE(trie_contains(trie, "http://example.com/\xff"));
+    EXPECT_TRUE(trie_contains(trie, "http://example.com/"));
+    EXPECT_FALSE(trie_contains(trie, "http://example.co"));
+    EXPECT_TRUE(trie_startswith(trie, "http://exa"));
+    EXPECT_FALSE(trie_startswith(trie, "http://exb"));
+
+    /* Nodes shrink back as words go. */
+    for (i = 1; i < 256; ++i) {
+        snprintf(word, sizeof(word), "http://example.com/%c", i);
+        EXPECT_EQ(0, trie_remove(trie, word));
+        EXPECT_FALSE(trie_contains(trie, word));
+    }
+    EXPECT_EQ(-1, trie_remove(trie, "http://example.com/a"));
+    EXPECT_TRUE(trie_contains(trie, "http://example.com/"));
+    EXPECT_EQ(0, trie_remove(trie, "http://example.com/"));
+    EXPECT_FALSE(trie_startswith(trie, "http"));
+    EXPECT_EQ(0, trie_remove(trie, "exam"));
+    EXPECT_TRUE(trie_contains(trie, "example"));
+    EXPECT_TRUE(trie_startswith(trie, "exam"));
+    EXPECT_EQ(-1, trie_remove(trie, "exam"));
+    for (i = 0; i < len; ++i) {
+        EXPECT_EQ(i == 7 ? -1 : 0, trie_remove(trie, str[i]));
+    }
+    EXPECT_EQ(0, trie_remove(trie, "HTTP"));
+    EXPECT_EQ(0u, trie_get_size(trie));
+    EXPECT_FALSE(trie_startswith(trie, ""));
+
     trie_free(&trie);
+    EXPECT_EQ(NULL, trie);
+}
+
+static void *multiqueue_worker(void *arg)
+{
+    int i;
+    int *count;
+    multiQueueElem x;
+    multiqueue_t mq = (multiqueue_t) arg;
+
+    count = (int *) malloc(sizeof(*count));
+    *count = 0;
+    for (i = 0; i < 1000; i++) {
+        multiqueue_add(mq, &a[i % LEN_A]);
+        if (i % 2 && multiqueue_poll(mq, &x) == 0) {
+            (*count)++;
+        }
+    }
+    return count;
+}
+
+TEST(multiqueue, multiqueue_testing) {
+    int i, polled;
+    void *res;
+    multiQueueElem x;
+    multiqueue_t mq;
+    pthread_t threads[4];
+
+    ASSERT_EQ(0, multiqueue_new(&mq, 1, 1, LEN_A, NULL));
+    for (i = 0; i < LEN_A; i++) {
+        EXPECT_EQ(0, multiqueue_add(mq, &a[i]));
+    }
+    EXPECT_EQ(-1, multiqueue_add(mq, &a[0]));   /* Full. */
+    EXPECT_EQ(LEN_A, multiqueue_get_size(mq));
+
+    /* A single heap is strict. */
+    EXPECT_EQ(0, multiqueue_poll(mq, &x));
+    EXPECT_EQ(-501, *(int *) x);
+    EXPECT_EQ(0, multiqueue_poll(mq, &x));
+    EXPECT_EQ(-10, *(int *) x);
+    for (i = 2; i < LEN_A; i++) {
+        EXPECT_EQ(0, multiqueue_poll(mq, &x));
+    }
+    EXPECT_EQ(-1, multiqueue_poll(mq, &x));
+    EXPECT_TRUE(multiqueue_isempty(mq));
+    multiqueue_free(&mq);
+
+    ASSERT_EQ(0, multiqueue_new(&mq, 4, 0, 4000, NULL));
+    for (i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, multiqueue_worker, mq);
+    }
+    polled = 0;
+    for (i = 0; i < 4; i++) {
+        pthread_join(threads[i], &res);
+        polled += *(int *) res;
+        free(res);
+    }
+    while (multiqueue_poll(mq, &x) == 0) {
+        polled++;
+    }
+    EXPECT_EQ(4000, polled);
+    EXPECT_TRUE(multiqueue_isempty(mq));
+    multiqueue_free(&mq);
+}
+
+TEST(topk, topk_testing) {
+    int i;
+    int xs[1000];
+    topkElem x;
+    topk_t topk;
+
+    ASSERT_EQ(0, topk_new(&topk, 3, NULL));
+    for (i = 0; i < LEN_A; i++) {
+        topk_add(topk, &a[i]);
+    }
+    EXPECT_EQ(3, topk_get_size(topk));
+    EXPECT_EQ(0, topk_peek(topk, &x));
+    EXPECT_EQ(35, *(int *) x);
+    EXPECT_FALSE(topk_add(topk, &b[0]));     /* 29 */
+    EXPECT_TRUE(topk_add(topk, &b[2]));      /* 50 */
+
+    EXPECT_EQ(0, topk_poll(topk, &x));
+    EXPECT_EQ(50, *(int *) x);
+    EXPECT_EQ(0, topk_poll(topk, &x));
+    EXPECT_EQ(78, *(int *) x);
+    EXPECT_EQ(0, topk_poll(topk, &x));
+    EXPECT_EQ(330, *(int *) x);
+    EXPECT_EQ(-1, topk_poll(topk, &x));
+    topk_free(&topk);
+
+    for (i = 0; i < 1000; i++) {
+        xs[i] = (i * 7919) % 1000;
+    }
+    ASSERT_EQ(0, topk_new(&topk, 10, NULL));
+    topk_add_ints(topk, xs, 1000);
+    for (i = 990; i < 1000; i++) {
+        EXPECT_EQ(0, topk_poll(topk, &x));
+        EXPECT_EQ(i, *(int *) x);
+    }
+    topk_free(&topk);
+}
+
+TEST(kmerge, kmerge_testing) {
+    int i;
+    int prev;
+    kmergeElem x;
+    kmergeElem ra[4], rb[3], rc[1];
+    kmergeElem *runs[] = {ra, rb, rc, NULL};
+    size_t lens[] = {4, 3, 1, 0};
+    kmerge_t km;
+
+    ra[0] = &a[7]; ra[1] = &a[4]; ra[2] = &a[1]; ra[3] = &a[6];  /* -501 2 23 330 */
+    rb[0] = &b[7]; rb[1] = &b[3]; rb[2] = &b[5];    /* -90 0 600 */
+    rc[0] = &a[8];                                  /* 0 */
+
+    ASSERT_EQ(0, kmerge_new(&km, runs, lens, 4, NULL));
+    prev = -1000;
+    for (i = 0; i < 8; i++) {
+        EXPECT_EQ(0, kmerge_next(km, &x));
+        EXPECT_LE(prev, *(int *) x);
+        prev = *(int *) x;
+    }
+    EXPECT_EQ(600, prev);
+    EXPECT_EQ(-1, kmerge_next(km, &x));
+    kmerge_free(&km);
+}
+
+static int fired[16];
+static int nfired;
+
+static void timerwheel_fire(timerWheelElem x)
+{
+    fired[nfired++] = *(int *) x;
+}
+
+TEST(timer_wheel, timer_wheel_testing) {
+    int i;
+    static int ticks[] = {5, 300, 70000, 20000000, 3};
+    twtimer_t timers[5];
+    timerwheel_t tw;
+
+    nfired = 0;
+    ASSERT_EQ(0, timerwheel_new(&tw, 1000));
+    for (i = 0; i < 5; i++) {
+        EXPECT_EQ(0, timerwheel_schedule(tw, &timers[i],
+                    1000 + ticks[i], &ticks[i]));
+    }
+    EXPECT_EQ(5, timerwheel_get_size(tw));
+
+    EXPECT_EQ(0, timerwheel_cancel(tw, &timers[4]));
+    EXPECT_EQ(-1, timerwheel_cancel(tw, &timers[4]));
+    EXPECT_EQ(4, timerwheel_get_size(tw));
+
+    EXPECT_EQ(0, timerwheel_advance(tw, 1004, timerwheel_fire));
+    EXPECT_EQ(1, timerwheel_advance(tw, 1005, timerwheel_fire));
+    EXPECT_EQ(5, fired[0]);
+
+    timerwheel_reschedule(tw, timers[1], 1000 + 400);
+    EXPECT_EQ(0, timerwheel_advance(tw, 1300, timerwheel_fire));
+    EXPECT_EQ(1, timerwheel_advance(tw, 1400, timerwheel_fire));
+    EXPECT_EQ(300, fired[1]);
+
+    EXPECT_EQ(0, timerwheel_advance(tw, 1000 + 69999, timerwheel_fire));
+    EXPECT_EQ(1, timerwheel_advance(tw, 1000 + 70000, timerwheel_fire));
+    EXPECT_EQ(70000, fired[2]);
+
+    /* Already expired timer fires on next advance. */
+    EXPECT_EQ(0, timerwheel_schedule(tw, &timers[4], 10, &ticks[4]));
+    EXPECT_EQ(1, timerwheel_advance(tw, 1000 + 70001, timerwheel_fire));
+    EXPECT_EQ(3, fired[3]);
+    EXPECT_EQ(0, timerwheel_schedule(tw, &timers[4], 1000 + 70001, &ticks[4]));
+    EXPECT_EQ(1, timerwheel_advance(tw, 1000 + 70001, timerwheel_fire));
+    EXPECT_EQ(0, timerwheel_advance(tw, 1000 + 70001, timerwheel_fire));
+
+    EXPECT_EQ(0, timerwheel_advance(tw, 1000 + 19999999, timerwheel_fire));
+    EXPECT_EQ(1, timerwheel_advance(tw, 1000 + 20000000, timerwheel_fire));
+    EXPECT_EQ(20000000, fired[5]);
+    EXPECT_EQ(0, timerwheel_get_size(tw));
+
+    EXPECT_EQ(0, timerwheel_schedule(tw, &timers[0], 1000 + 20000100, &ticks[0]));
+    timerwheel_free(&tw);
+}
+
+TEST(minmax_heap, minmax_heap_testing) {
+    int i;
+    minMaxHeapElem x;
+    minmax_heap_t mh;
+
+    ASSERT_EQ(0, minmax_heap_new(&mh, LEN_A, NULL));
+    EXPECT_EQ(-1, minmax_heap_peek_max(mh, &x));
+    for (i = 0; i < LEN_A; i++) {
+        EXPECT_EQ(0, minmax_heap_add(mh, &a[i]));
+    }
+    EXPECT_TRUE(minmax_heap_isfull(mh));
+    EXPECT_EQ(-1, minmax_heap_add(mh, &b[0]));
+
+    EXPECT_EQ(0, minmax_heap_peek_min(mh, &x));
+    EXPECT_EQ(-501, *(int *) x);
+    EXPECT_EQ(0, minmax_heap_peek_max(mh, &x));
+    EXPECT_EQ(330, *(int *) x);
+
+    EXPECT_EQ(0, minmax_heap_poll_max(mh, &x));
+    EXPECT_EQ(330, *(int *) x);
+    EXPECT_EQ(0, minmax_heap_poll_min(mh, &x));
+    EXPECT_EQ(-501, *(int *) x);
+    EXPECT_EQ(0, minmax_heap_poll_max(mh, &x));
+    EXPECT_EQ(78, *(int *) x);
+    EXPECT_EQ(0, minmax_heap_poll_min(mh, &x));
+    EXPECT_EQ(-10, *(int *) x);
+
+    EXPECT_EQ(LEN_A - 4, minmax_heap_get_size(mh));
+    for (i = 0; i < LEN_A - 4; i++) {
+        EXPECT_EQ(0, minmax_heap_poll_max(mh, &x));
+    }
+    EXPECT_EQ(-1, minmax_heap_poll_min(mh, &x));
+    EXPECT_TRUE(minmax_heap_isempty(mh));
+
+    minmax_heap_free(&mh);
+}
+
+struct rbitem {
+    struct rbnode node;
+    int key;
+};
+
+static int cmp_rbitem(const struct rbnode *n1, const struct rbnode *n2)
+{
+    return ((struct rbitem *) n1)->key - ((struct rbitem *) n2)->key;
+}
+
+TEST(rb_tree, rbtree_testing) {
+    int i;
+    rbtreeElem x;
+    rbtree_t rb;
+    struct rbitem items[12], key;
+    struct rbnode *n;
+
+    ASSERT_EQ(0, rbtree_new(&rb, NULL));
+    for (i = 0; i < LEN_A; i++) {
+        EXPECT_EQ(0, rbtree_add(rb, &a[i]));
+    }
+    EXPECT_TRUE(rbtree_contains(rb, &a[0]));
+    EXPECT_FALSE(rbtree_contains(rb, &b[0]));
+
+    EXPECT_EQ(0, rbtree_remove(rb, &a[0]));
+    EXPECT_FALSE(rbtree_contains(rb, &a[0]));
+    EXPECT_FALSE(rbtree_isempty(rb));
+    EXPECT_GE(6, rbtree_get_height(rb));
+
+    EXPECT_EQ(0, rbtree_get_min(rb, &x));
+    EXPECT_EQ(-501, *(int *) x);
+    EXPECT_EQ(0, rbtree_get_max(rb, &x));
+    EXPECT_EQ(330, *(int *) x);
+
+    for (i = 1; i < LEN_A - 1; i++) {
+        EXPECT_EQ(0, rbtree_remove(rb, &a[i]));
+    }
+    EXPECT_EQ(-1, rbtree_remove(rb, &a[LEN_A - 1]));
+    EXPECT_TRUE(rbtree_isempty(rb));
+    rbtree_free(&rb);
+
+    /* Intrusive, nodes live in items[]. */
+    ASSERT_EQ(0, rbtree_new_intrusive(&rb, cmp_rbitem));
+    for (i = 0; i < LEN_A; i++) {
+        items[i].key = a[i];
+        EXPECT_EQ(i == LEN_A - 1 ? -1 : 0,
+                rbtree_insert_node(rb, &items[i].node));  /* 0 twice */
+    }
+    key.key = 25;
+    EXPECT_EQ(&items[9].node, rbtree_find_node(rb, &key.node));
+    rbtree_erase_node(rb, &items[9].node);
+    EXPECT_EQ(NULL, rbtree_find_node(rb, &key.node));
+
+    n = rbtree_first_node(rb);
+    EXPECT_EQ(-501, ((struct rbitem *) n)->key);
+    for (i = 1; i < LEN_A - 2; i++) {
+        n = rbtree_next_node(n);
+    }
+    EXPECT_EQ(330, ((struct rbitem *) n)->key);
+    EXPECT_EQ(NULL, rbtree_next_node(n));
+    EXPECT_EQ(n, rbtree_last_node(rb));
+    EXPECT_EQ(78, ((struct rbitem *) rbtree_prev_node(n))->key);
+
+    /* Elements have no place in it. */
+    EXPECT_EQ(-1, rbtree_add(rb, &a[0]));
+    EXPECT_EQ(-1, rbtree_remove(rb, &a[0]));
+    EXPECT_FALSE(rbtree_contains(rb, &a[0]));
+    EXPECT_EQ(-1, rbtree_get_min(rb, &x));
+    EXPECT_EQ(-1, rbtree_get_max(rb, &x));
+    rbtree_free(&rb);
+}
+
+TEST(avlmap, avlmap_testing) {
+    int i, key;
+    avlmapKey k;
+    avlmapValue v;
+    avlmap_t map;
+
+    ASSERT_EQ(0, avlmap_new(&map, NULL));
+    EXPECT_TRUE(avlmap_isempty(map));
+    for (i = 0; i < LEN_A; i++) {
+        EXPECT_EQ(0, avlmap_put(map, &a[i], &b[i]));
+    }
+    EXPECT_TRUE(avlmap_contains_key(map, &a[0]));
+    EXPECT_FALSE(avlmap_contains_key(map, &b[0]));
+
+    /* Duplicated key 0 keeps the last value. */
+    EXPECT_EQ(0, avlmap_get(map, &a[8], &v));
+    EXPECT_EQ(b[LEN_A - 1], *(int *) v);
+    EXPECT_EQ(0, avlmap_get(map, &a[6], &v));
+    EXPECT_EQ(b[6], *(int *) v);
+    EXPECT_EQ(-1, avlmap_get(map, &b[0], &v));
+
+    key = 24;
+    EXPECT_EQ(0, avlmap_floor(map, &key, &k, &v));
+    EXPECT_EQ(23, *(int *) k);
+    EXPECT_EQ(b[1], *(int *) v);
+    EXPECT_EQ(0, avlmap_ceiling(map, &key, &k, &v));
+    EXPECT_EQ(25, *(int *) k);
+    EXPECT_EQ(b[9], *(int *) v);
+
+    key = 1000;
+    EXPECT_EQ(-1, avlmap_ceiling(map, &key, &k, &v));
+    EXPECT_EQ(0, avlmap_floor(map, &key, &k, &v));
+    EXPECT_EQ(330, *(int *) k);
+
+    for (i = 0; i < LEN_A - 1; i++) {
+        EXPECT_EQ(0, avlmap_remove(map, &a[i]));
+        if (i < LEN_A - 2) {
+            EXPECT_EQ(0, avlmap_get(map, &a[LEN_A - 2], &v));
+            EXPECT_EQ(b[LEN_A - 2], *(int *) v);
+        }
+    }
+    EXPECT_EQ(-1, avlmap_remove(map, &a[LEN_A - 1]));
+    EXPECT_TRUE(avlmap_isempty(map));
+
+    avlmap_free(&map);
+}
+
+TEST(tree_cursor, tree_cursor_testing) {
+    int i, key, sum;
+    void *x;
+    avltree_t avl;
+    avltree_cursor_t ac;
+    bstree_t bst;
+    bstree_cursor_t bc;
+    /* Sorted unique values of a. */
+    static const int sorted[] = {-501, -10, 0, 2, 11, 20, 23, 25, 35, 78, 330};
+
+    ASSERT_EQ(0, avltree_new(&avl, NULL));
+    ASSERT_EQ(0, bstree_new(&bst, NULL));
+    ASSERT_EQ(0, avltree_cursor_new(&ac, avl));
+    ASSERT_EQ(0, bstree_cursor_new(&bc, bst));
+    EXPECT_EQ(-1, avltree_cursor_first(ac, &x));
+    EXPECT_EQ(-1, bstree_cursor_first(bc, &x));
+    for (i = 0; i < LEN_A; i++) {
+        avltree_add(avl, &a[i]);
+        bstree_add(bst, &a[i]);
+    }
+
+    EXPECT_EQ(0, avltree_cursor_first(ac, &x));
+    EXPECT_EQ(0, bstree_cursor_first(bc, &x));
+    for (i = 0; i < 11; i++) {
+        EXPECT_EQ(sorted[i], *(int *) x);
+        EXPECT_EQ(i < 10 ? 0 : -1, avltree_next(ac, &x));
+    }
+    EXPECT_EQ(0, bstree_cursor_last(bc, &x));
+    for (i = 10; i >= 0; i--) {
+        EXPECT_EQ(sorted[i], *(int *) x);
+        EXPECT_EQ(i > 0 ? 0 : -1, bstree_prev(bc, &x));
+    }
+
+    key = 24;
+    EXPECT_EQ(0, avltree_lower_bound(ac, &key, &x));
+    EXPECT_EQ(25, *(int *) x);
+    EXPECT_EQ(0, avltree_prev(ac, &x));
+    EXPECT_EQ(23, *(int *) x);
+    EXPECT_EQ(0, bstree_lower_bound(bc, &key, &x));
+    EXPECT_EQ(25, *(int *) x);
+    key = 25;
+    EXPECT_EQ(0, avltree_upper_bound(ac, &key, &x));
+    EXPECT_EQ(35, *(int *) x);
+    EXPECT_EQ(0, bstree_upper_bound(bc, &key, &x));
+    EXPECT_EQ(35, *(int *) x);
+    EXPECT_EQ(0, bstree_next(bc, &x));
+    EXPECT_EQ(78, *(int *) x);
+    key = 330;
+    EXPECT_EQ(-1, avltree_upper_bound(ac, &key, &x));
+    EXPECT_EQ(-1, bstree_upper_bound(bc, &key, &x));
+
+    /* 0 + 2 + 11 + 20 + 23 */
+    key = 24;
+    sum = 0;
+    EXPECT_EQ(5u, avltree_range_scan(avl, &a[8], &key, sum_visitor, &sum));
+    EXPECT_EQ(56, sum);
+    sum = 0;
+    EXPECT_EQ(5u, bstree_range_scan(bst, &a[8], &key, sum_visitor, &sum));
+    EXPECT_EQ(56, sum);
+    EXPECT_EQ(0u, avltree_range_scan(avl, &key, &a[8], sum_visitor, &sum));
+
+    avltree_cursor_free(&ac);
+    bstree_cursor_free(&bc);
+    EXPECT_EQ(NULL, ac);
+    avltree_free(&avl);
+    bstree_free(&bst);
+}
+
+static int bptree_sum(int key, bptreeValue value, void *arg)
+{
+    *(long *) arg += key;
+    return 0;
+}
+
+TEST(bptree, bptree_testing) {
+    int i;
+    long sum;
+    int keys[1000];
+    bptreeValue v;
+    bptree_t bpt;
+
+    ASSERT_EQ(0, bptree_new(&bpt));
+    EXPECT_TRUE(bptree_isempty(bpt));
+    for (i = 0; i < LEN_A; i++) {
+        EXPECT_EQ(0, bptree_put(bpt, a[i], &b[i]));
+    }
+    EXPECT_EQ(11u, bptree_get_size(bpt));
+    EXPECT_TRUE(bptree_contains(bpt, a[0]));
+    EXPECT_FALSE(bptree_contains(bpt, b[0]));
+
+    /* Duplicated key 0 keeps the last value. */
+    EXPECT_EQ(0, bptree_get(bpt, 0, &v));
+    EXPECT_EQ(b[LEN_A - 1], *(int *) v);
+
+    for (i = 0; i < LEN_A - 1; i++) {
+        EXPECT_EQ(0, bptree_remove(bpt, a[i]));
+    }
+    EXPECT_EQ(-1, bptree_remove(bpt, a[LEN_A - 1]));
+    EXPECT_TRUE(bptree_isempty(bpt));
+
+    /* Enough keys for several levels, removed in another order. */
+    for (i = 0; i < 10000; i++) {
+        EXPECT_EQ(0, bptree_put(bpt, (i * 7919) % 10000, NULL));
+    }
+    EXPECT_EQ(10000u, bptree_get_size(bpt));
+    sum = 0;
+    EXPECT_EQ(101u, bptree_range_scan(bpt, 100, 200, bptree_sum, &sum));
+    EXPECT_EQ(15150, sum);
+    for (i = 0; i < 10000; i += 2) {
+        EXPECT_EQ(0, bptree_remove(bpt, i));
+    }
+    EXPECT_FALSE(bptree_contains(bpt, 5000));
+    EXPECT_TRUE(bptree_contains(bpt, 5001));
+    bptree_free(&bpt);
+    EXPECT_EQ(NULL, bpt);
+
+    for (i = 0; i < 1000; i++) {
+        keys[i] = 3 * i;
+    }
+    ASSERT_EQ(0, bptree_from_sorted(&bpt, keys, NULL, 1000));
+    EXPECT_EQ(1000u, bptree_get_size(bpt));
+    EXPECT_TRUE(bptree_contains(bpt, 2997));
+    EXPECT_FALSE(bptree_contains(bpt, 2998));
+    sum = 0;
+    EXPECT_EQ(4u, bptree_range_scan(bpt, -5, 10, bptree_sum, &sum));
+    EXPECT_EQ(18, sum);
+    EXPECT_EQ(0, bptree_put(bpt, 2998, NULL));
+    EXPECT_TRUE(bptree_contains(bpt, 2998));
+    bptree_free(&bpt);
+
+    keys[1] = keys[0];
+    EXPECT_EQ(-1, bptree_from_sorted(&bpt, keys, NULL, 1000));
+}
+
+TEST(avl_tree_setop, avltree_setop_testing) {
+    int i;
+    int nums[10000];
+    avltreeElem x;
+    avltree_t avl, other, right;
+
+    for (i = 0; i < 10000; i++) {
+        nums[i] = i;
+    }
+
+    /* Multiples of 2 and of 3 below 10000. */
+    ASSERT_EQ(0, avltree_new(&avl, NULL));
+    ASSERT_EQ(0, avltree_new(&other, NULL));
+    for (i = 0; i < 10000; i += 2) {
+        avltree_add(avl, &nums[i]);
+    }
+    for (i = 0; i < 10000; i += 3) {
+        avltree_add(other, &nums[i]);
+    }
+    EXPECT_EQ(0, avltree_union(avl, &other));
+    EXPECT_EQ(NULL, other);
+    EXPECT_EQ(6667u, avltree_get_size(avl));
+    EXPECT_TRUE(avltree_contains(avl, &nums[9999]));
+    EXPECT_FALSE(avltree_contains(avl, &nums[9995]));
+
+    /* Drop multiples of 3 again. */
+    ASSERT_EQ(0, avltree_new(&other, NULL));
+    for (i = 0; i < 10000; i += 3) {
+        avltree_add(other, &nums[i]);
+    }
+    EXPECT_EQ(0, avltree_difference(avl, &other));
+    EXPECT_EQ(3333u, avltree_get_size(avl));
+    EXPECT_FALSE(avltree_contains(avl, &nums[6]));
+    EXPECT_TRUE(avltree_contains(avl, &nums[8]));
+
+    /* Keep multiples of 4, 4 8 16 20 ... */
+    ASSERT_EQ(0, avltree_new(&other, NULL));
+    for (i = 0; i < 10000; i += 4) {
+        avltree_add(other, &nums[i]);
+    }
+    EXPECT_EQ(0, avltree_intersect(avl, &other));
+    EXPECT_EQ(1666u, avltree_get_size(avl));
+    EXPECT_EQ(0, avltree_select(avl, 0, &x));
+    EXPECT_EQ(4, *(int *) x);
+
+    EXPECT_EQ(0, avltree_split(avl, &nums[5000], &right));
+    EXPECT_EQ(0, avltree_get_max(avl, &x));
+    EXPECT_EQ(4996, *(int *) x);
+    EXPECT_EQ(0, avltree_get_min(right, &x));
+    EXPECT_EQ(5000, *(int *) x);
+    EXPECT_EQ(-1, avltree_join(right, &avl));
+    EXPECT_EQ(0, avltree_join(avl, &right));
+    EXPECT_EQ(NULL, right);
+    EXPECT_EQ(1666u, avltree_get_size(avl));
+    EXPECT_EQ(556u, avltree_rank(avl, &nums[3333]));
+
+    avltree_free(&avl);
+}
+
+TEST(avl_tree_snapshot, avltree_snapshot_testing) {
+    int i;
+    int nums[1000];
+    avltreeElem x;
+    avltree_t avl, snap, right, other;
+
+    for (i = 0; i < 1000; i++) {
+        nums[i] = i;
+    }
+
+    ASSERT_EQ(0, avltree_new(&avl, NULL));
+    for (i = 0; i < 1000; i += 2) {
+        avltree_add(avl, &nums[i]);
+    }
+    ASSERT_EQ(0, avltree_snapshot(avl, &snap));
+    EXPECT_EQ(500u, avltree_get_size(snap));
+
+    /* Writes to avl leave snap as it was, and the other way round. */
+    for (i = 0; i < 1000; i += 4) {
+        EXPECT_EQ(0, avltree_remove(avl, &nums[i]));
+    }
+    for (i = 1; i < 1000; i += 2) {
+        EXPECT_EQ(0, avltree_add(avl, &nums[i]));
+    }
+    EXPECT_EQ(0, avltree_remove(snap, &nums[998]));
+    EXPECT_EQ(-1, avltree_remove(snap, &nums[1]));
+
+    EXPECT_EQ(750u, avltree_get_size(avl));
+    EXPECT_FALSE(avltree_contains(avl, &nums[0]));
+    EXPECT_TRUE(avltree_contains(avl, &nums[998]));
+    EXPECT_EQ(499u, avltree_get_size(snap));
+    EXPECT_TRUE(avltree_contains(snap, &nums[0]));
+    EXPECT_FALSE(avltree_contains(snap, &nums[1]));
+    EXPECT_EQ(0, avltree_get_max(snap, &x));
+    EXPECT_EQ(996, *(int *) x);
+
+    /* Trees sharing nodes can't be split or joined. */
+    EXPECT_EQ(-1, avltree_split(avl, &nums[500], &right));
+
+    avltree_free(&avl);
+    EXPECT_EQ(250u, avltree_rank(snap, &nums[500]));
+    avltree_free(&snap);
+
+    /* Once its snapshot is freed, a tree can be merged and split. */
+    ASSERT_EQ(0, avltree_new(&avl, NULL));
+    ASSERT_EQ(0, avltree_new(&other, NULL));
+    for (i = 0; i < 1000; i += 2) {
+        avltree_add(avl, &nums[i]);
+        avltree_add(other, &nums[i + 1]);
+    }
+    ASSERT_EQ(0, avltree_snapshot(avl, &snap));
+    EXPECT_EQ(-1, avltree_union(avl, &other));
+    avltree_free(&snap);
+    EXPECT_EQ(0, avltree_union(avl, &other));
+    EXPECT_EQ(1000u, avltree_get_size(avl));
+    ASSERT_EQ(0, avltree_split(avl, &nums[500], &right));
+    EXPECT_EQ(500u, avltree_get_size(avl));
+    EXPECT_EQ(500u, avltree_get_size(right));
+    EXPECT_TRUE(avltree_contains(right, &nums[999]));
+    avltree_free(&right);
+    avltree_free(&avl);
+}
+
+TEST(frozenset, frozenset_testing) {
+    int i, sum;
+    int nums[1000];
+    frozensetElem elems[500];
+    frozensetElem x;
+    frozenset_t fs;
+    avltree_t avl;
+    bstree_t bst;
+
+    for (i = 0; i < 1000; i++) {
+        nums[i] = i;
+    }
+    for (i = 0; i < 500; i++) {
+        elems[i] = &nums[2 * i];
+    }
+
+    /* Even numbers below 1000. */
+    ASSERT_EQ(0, frozenset_new(&fs, elems, 500, NULL));
+    EXPECT_EQ(500u, frozenset_get_size(fs));
+    for (i = 0; i < 1000; i++) {
+        EXPECT_EQ(i % 2 == 0, !!frozenset_contains(fs, &nums[i]));
+    }
+    EXPECT_EQ(0, frozenset_get_min(fs, &x));
+    EXPECT_EQ(0, *(int *) x);
+    EXPECT_EQ(0, frozenset_get_max(fs, &x));
+    EXPECT_EQ(998, *(int *) x);
+    EXPECT_EQ(0, frozenset_lower_bound(fs, &nums[501], &x));
+    EXPECT_EQ(502, *(int *) x);
+    EXPECT_EQ(0, frozenset_upper_bound(fs, &nums[502], &x));
+    EXPECT_EQ(504, *(int *) x);
+    EXPECT_EQ(-1, frozenset_upper_bound(fs, &nums[998], &x));
+    sum = 0;
+    EXPECT_EQ(250u, frozenset_range_scan(fs, &nums[1], &nums[500],
+            sum_visitor, &sum));
+    EXPECT_EQ(250 * 251, sum);
+    frozenset_free(&fs);
+    EXPECT_EQ(NULL, fs);
+
+    elems[1] = &nums[0];
+    EXPECT_EQ(-1, frozenset_new(&fs, elems, 500, NULL));
+
+    /* From trees, which stay usable. */
+    ASSERT_EQ(0, avltree_new(&avl, NULL));
+    ASSERT_EQ(0, bstree_new(&bst, NULL));
+    for (i = 999; i >= 0; i -= 3) {
+        avltree_add(avl, &nums[i]);
+        bstree_add(bst, &nums[i]);
+    }
+
+    EXPECT_EQ(cmp_int, avltree_get_comparator(avl));
+    EXPECT_EQ(cmp_int, bstree_get_comparator(bst));
+    ASSERT_EQ(0, frozenset_from_avltree(&fs, avl));
+    EXPECT_EQ(334u, frozenset_get_size(fs));
+    EXPECT_TRUE(frozenset_contains(fs, &nums[999]));
+    EXPECT_FALSE(frozenset_contains(fs, &nums[998]));
+    frozenset_free(&fs);
+
+    ASSERT_EQ(0, frozenset_from_bstree(&fs, bst));
+    EXPECT_EQ(334u, frozenset_get_size(fs));
+    EXPECT_EQ(0, frozenset_get_min(fs, &x));
+    EXPECT_EQ(0, *(int *) x);
+    EXPECT_TRUE(bstree_contains(bst, &nums[3]));
+    frozenset_free(&fs);
+
+    avltree_free(&avl);
+    bstree_free(&bst);
+}
+
+static int sum_lo(void *lo, void *hi, void *arg)
+{
+    (void) hi;
+    *(int *) arg += *(int *) lo;
+    return 0;
+}
+
+TEST(intervaltree, intervaltree_testing) {
+    int i, sum;
+    int nums[1000];
+    intervaltree_t it;
+
+    for (i = 0; i < 1000; i++) {
+        nums[i] = i;
+    }
+
+    /* [i, i + 9] for i = 0, 10, 20 ... 980, and [0, 999]. */
+    ASSERT_EQ(0, intervaltree_new(&it, NULL));
+    EXPECT_TRUE(intervaltree_isempty(it));
+    for (i = 0; i < 990; i += 10) {
+        EXPECT_EQ(0, intervaltree_add(it, &nums[i], &nums[i + 9]));
+    }
+    EXPECT_EQ(0, intervaltree_add(it, &nums[0], &nums[999]));
+    EXPECT_EQ(0, intervaltree_add(it, &nums[0], &nums[999]));
+    EXPECT_EQ(-1, intervaltree_add(it, &nums[5], &nums[4]));
+    EXPECT_EQ(100u, intervaltree_get_size(it));
+    EXPECT_TRUE(intervaltree_contains(it, &nums[0], &nums[9]));
+    EXPECT_FALSE(intervaltree_contains(it, &nums[0], &nums[8]));
+
+    sum = 0;
+    EXPECT_EQ(2u, intervaltree_stab(it, &nums[985], sum_lo, &sum));
+    EXPECT_EQ(980, sum);
+    sum = 0;
+    EXPECT_EQ(4u, intervaltree_overlap(it, &nums[15], &nums[35], sum_lo, &sum));
+    EXPECT_EQ(60, sum);
+
+    EXPECT_EQ(0, intervaltree_remove(it, &nums[0], &nums[999]));
+    EXPECT_EQ(-1, intervaltree_remove(it, &nums[0], &nums[999]));
+    EXPECT_EQ(0u, intervaltree_stab(it, &nums[995], sum_lo, &sum));
+    EXPECT_EQ(1u, intervaltree_stab(it, &nums[0], sum_lo, &sum));
+
+    for (i = 0; i < 990; i += 10) {
+        EXPECT_EQ(0, intervaltree_remove(it, &nums[i], &nums[i + 9]));
+    }
+    EXPECT_TRUE(intervaltree_isempty(it));
+    intervaltree_free(&it);
+    EXPECT_EQ(NULL, it);
+}
+
+static int cavl_nums[4000];
+
+struct cavl_arg {
+    cavltree_t cavl;
+    int first;
+};
+
+static void *cavltree_worker(void *arg)
+{
+    int i, *fails;
+    struct cavl_arg *ca = (struct cavl_arg *) arg;
+
+    fails = (int *) malloc(sizeof(*fails));
+    *fails = 0;
+    for (i = ca->first; i < ca->first + 1000; i++) {
+        *fails += cavltree_add(ca->cavl, &cavl_nums[i]) != 0;
+        *fails += cavltree_contains(ca->cavl, &cavl_nums[i]) != 1;
+    }
+    for (i = ca->first + 1; i < ca->first + 1000; i += 2) {
+        *fails += cavltree_remove(ca->cavl, &cavl_nums[i]) != 0;
+        *fails += cavltree_contains(ca->cavl, &cavl_nums[i]) != 0;
+    }
+    return fails;
+}
+
+TEST(cavltree, cavltree_testing) {
+    int i, fails;
+    void *res;
+    cavltreeElem x;
+    cavltree_t cavl;
+    pthread_t threads[4];
+    struct cavl_arg args[4];
+
+    for (i = 0; i < 4000; i++) {
+        cavl_nums[i] = i;
+    }
+
+    ASSERT_EQ(0, cavltree_new(&cavl, NULL));
+    EXPECT_TRUE(cavltree_isempty(cavl));
+    EXPECT_EQ(-1, cavltree_get_min(cavl, &x));
+    EXPECT_EQ(-1, cavltree_remove(cavl, &cavl_nums[0]));
+
+    /* Each thread owns 1000 numbers, interleaved with the others. */
+    for (i = 0; i < 4; i++) {
+        args[i].cavl = cavl;
+        args[i].first = i * 1000;
+        pthread_create(&threads[i], NULL, cavltree_worker, &args[i]);
+    }
+    fails = 0;
+    for (i = 0; i < 4; i++) {
+        pthread_join(threads[i], &res);
+        fails += *(int *) res;
+        free(res);
+    }
+    EXPECT_EQ(0, fails);
+
+    EXPECT_EQ(2000u, cavltree_get_size(cavl));
+    for (i = 0; i < 4000; i++) {
+        EXPECT_EQ(i % 2 == 0, cavltree_contains(cavl, &cavl_nums[i]));
+    }
+    EXPECT_EQ(0, cavltree_get_min(cavl, &x));
+    EXPECT_EQ(0, *(int *) x);
+    EXPECT_EQ(0, cavltree_get_max(cavl, &x));
+    EXPECT_EQ(3998, *(int *) x);
+
+    /* Duplicates are ignored. */
+    EXPECT_EQ(0, cavltree_add(cavl, &cavl_nums[0]));
+    EXPECT_EQ(2000u, cavltree_get_size(cavl));
+
+    for (i = 0; i < 4000; i += 2) {
+        EXPECT_EQ(0, cavltree_remove(cavl, &cavl_nums[i]));
+    }
+    EXPECT_TRUE(cavltree_isempty(cavl));
+    EXPECT_EQ(-1, cavltree_get_max(cavl, &x));
+    cavltree_free(&cavl);
+    EXPECT_EQ(NULL, cavl);
+}
+
+static int cs_nums[4000];
+
+struct cs_arg {
+    cskiplist_t cs;
+    int first;
+};
+
+static void *cskiplist_worker(void *arg)
+{
+    int i, *fails;
+    struct cs_arg *ca = (struct cs_arg *) arg;
+
+    fails = (int *) malloc(sizeof(*fails));
+    *fails = 0;
+    for (i = ca->first; i < 4000; i += 4) {
+        *fails += cskiplist_add(ca->cs, &cs_nums[i]) != 0;
+        *fails += cskiplist_contains(ca->cs, &cs_nums[i]) != 1;
+    }
+    for (i = ca->first; i < 4000; i += 8) {
+        *fails += cskiplist_remove(ca->cs, &cs_nums[i]) != 0;
+        *fails += cskiplist_contains(ca->cs, &cs_nums[i]) != 0;
+    }
+    return fails;
+}
+
+TEST(cskiplist, cskiplist_testing) {
+    int i, fails, sum;
+    void *res;
+    cskiplist_t cs;
+    pthread_t threads[4];
+    struct cs_arg args[4];
+
+    for (i = 0; i < 4000; i++) {
+        cs_nums[i] = i;
+    }
+
+    ASSERT_EQ(0, cskiplist_new(&cs, NULL));
+    EXPECT_TRUE(cskiplist_isempty(cs));
+    EXPECT_EQ(-1, cskiplist_remove(cs, &cs_nums[0]));
+
+    /* Thread t owns i = t (mod 4), and removes i = t (mod 8). */
+    for (i = 0; i < 4; i++) {
+        args[i].cs = cs;
+        args[i].first = i;
+        pthread_create(&threads[i], NULL, cskiplist_worker, &args[i]);
+    }
+    fails = 0;
+    for (i = 0; i < 4; i++) {
+        pthread_join(threads[i], &res);
+        fails += *(int *) res;
+        free(res);
+    }
+    EXPECT_EQ(0, fails);
+
+    EXPECT_EQ(2000u, cskiplist_get_size(cs));
+    for (i = 0; i < 4000; i++) {
+        EXPECT_EQ(i % 8 >= 4, cskiplist_contains(cs, &cs_nums[i]));
+    }
+    EXPECT_EQ(0, cskiplist_add(cs, &cs_nums[4]));
+    EXPECT_EQ(2000u, cskiplist_get_size(cs));
+
+    /* 4 5 6 7 12 13 14 15 ... */
+    sum = 0;
+    EXPECT_EQ(7u, cskiplist_range_scan(cs, &cs_nums[1], &cs_nums[14],
+                sum_visitor, &sum));
+    EXPECT_EQ(61, sum);
+
+    for (i = 0; i < 4000; i++) {
+        EXPECT_EQ(i % 8 >= 4 ? 0 : -1, cskiplist_remove(cs, &cs_nums[i]));
+    }
+    EXPECT_TRUE(cskiplist_isempty(cs));
+    cskiplist_free(&cs);
+    EXPECT_EQ(NULL, cs);
+}
+
+static int mt_nums[4000];
+
+/* Scan while the writer puts, keys must come in order. */
+static void *memtable_reader(void *arg)
+{
+    int *fails, last, rounds;
+    memtable_t mt = (memtable_t) arg;
+    memtable_cursor_t cur;
+    memtableKey k;
+    memtableValue v;
+
+    fails = (int *) malloc(sizeof(*fails));
+    *fails = 0;
+    memtable_cursor_new(&cur, mt);
+    for (rounds = 0; rounds < 50; rounds++) {
+        last = -1;
+        for (int rc = memtable_cursor_first(cur, &k, &v); rc == 0;
+                rc = memtable_next(cur, &k, &v)) {
+            *fails += *(int *) k <= last || k != v;
+            last = *(int *) k;
+        }
+    }
+    memtable_cursor_free(&cur);
+    return fails;
+}
+
+TEST(memtable, memtable_testing) {
+    int i, fails, *p;
+    void *res;
+    size_t usage;
+    memtable_t mt;
+    memtable_cursor_t cur;
+    memtableKey k;
+    memtableValue v;
+    pthread_t threads[2];
+
+    for (i = 0; i < 4000; i++) {
+        mt_nums[i] = i;
+    }
+
+    ASSERT_EQ(0, memtable_new(&mt, NULL));
+    EXPECT_TRUE(memtable_isempty(mt));
+    usage = memtable_get_memory_usage(mt);
+    EXPECT_LT(0u, usage);
+    EXPECT_EQ(-1, memtable_get(mt, &mt_nums[0], &v));
+
+    /* One writer, two readers. */
+    for (i = 0; i < 2; i++) {
+        pthread_create(&threads[i], NULL, memtable_reader, mt);
+    }
+    for (i = 0; i < 4000; i++) {
+        p = &mt_nums[(i * 7) % 4000];
+        EXPECT_EQ(0, memtable_put(mt, p, p));
+    }
+    fails = 0;
+    for (i = 0; i < 2; i++) {
+        pthread_join(threads[i], &res);
+        fails += *(int *) res;
+        free(res);
+    }
+    EXPECT_EQ(0, fails);
+    EXPECT_EQ(4000u, memtable_get_size(mt));
+    EXPECT_LT(usage, memtable_get_memory_usage(mt));
+
+    for (i = 0; i < 4000; i++) {
+        ASSERT_EQ(0, memtable_get(mt, &mt_nums[i], &v));
+        EXPECT_EQ(&mt_nums[i], v);
+    }
+    EXPECT_EQ(0, memtable_put(mt, &mt_nums[5], &mt_nums[6]));
+    EXPECT_EQ(4000u, memtable_get_size(mt));
+    EXPECT_EQ(0, memtable_get(mt, &mt_nums[5], &v));
+    EXPECT_EQ(&mt_nums[6], v);
+
+    /* Cursors. */
+    ASSERT_EQ(0, memtable_cursor_new(&cur, mt));
+    EXPECT_EQ(-1, memtable_next(cur, &k, &v));
+    EXPECT_EQ(0, memtable_cursor_last(cur, &k, &v));
+    EXPECT_EQ(3999, *(int *) k);
+    EXPECT_EQ(-1, memtable_next(cur, &k, &v));
+    EXPECT_EQ(0, memtable_cursor_first(cur, &k, &v));
+    EXPECT_EQ(0, *(int *) k);
+    EXPECT_EQ(-1, memtable_prev(cur, &k, &v));
+    i = 4;
+    EXPECT_EQ(0, memtable_seek(cur, &i, &k, &v));
+    EXPECT_EQ(&mt_nums[4], k);
+    EXPECT_EQ(0, memtable_next(cur, &k, &v));
+    EXPECT_EQ(&mt_nums[6], v);
+    EXPECT_EQ(0, memtable_prev(cur, &k, &v));
+    EXPECT_EQ(0, memtable_prev(cur, &k, &v));
+    EXPECT_EQ(3, *(int *) k);
+    i = 4000;
+    EXPECT_EQ(-1, memtable_seek(cur, &i, &k, &v));
+
+    /* Keys copied into the arena. */
+    p = (int *) memtable_alloc(mt, sizeof(*p));
+    ASSERT_TRUE(p != NULL);
+    *p = -1;
+    EXPECT_EQ(0, memtable_put(mt, p, NULL));
+    EXPECT_EQ(0, memtable_cursor_first(cur, &k, &v));
+    EXPECT_EQ(p, k);
+    p = (int *) memtable_alloc(mt, 8192);
+    ASSERT_TRUE(p != NULL);
+    p[2047] = 0;
+    EXPECT_LT(usage + 8192, memtable_get_memory_usage(mt));
+
+    memtable_cursor_free(&cur);
+    EXPECT_EQ(NULL, cur);
+    memtable_free(&mt);
+    EXPECT_EQ(NULL, mt);
 }
 
 int main (int argc, char **argv) {